@@ -0,0 +1,238 @@
+/// Allocation counter: replays generated steady-state ingestion (known assets sending metrics through METRICS
+/// stream and fty_shm) through fty-outage actor and reports heap allocations per message. malloc family of
+/// the process is replaced by counting wrappers, so allocations done by czmq and fty_proto are counted too.
+/// Allocations of reading the trace itself are measured separately and subtracted. Run with --help for options.
+
+#include "src/capture.h"
+#include "src/fty-outage-server.h"
+#include <atomic>
+#include <cstdio>
+#include <fty_proto.h>
+#include <fty_shm.h>
+#include <string>
+
+static const char* SHM_DIR      = "fty-outage-alloc-shm";
+static const char* WARMUP_TRACE = "fty-outage-alloc-warmup.bin";
+static const char* STEADY_TRACE = "fty-outage-alloc-steady.bin";
+
+static std::atomic<bool>     s_counting{false};
+static std::atomic<uint64_t> s_allocations{0};
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void  __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+    if (s_counting.load(std::memory_order_relaxed))
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if (s_counting.load(std::memory_order_relaxed))
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if (s_counting.load(std::memory_order_relaxed))
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+}
+
+struct options_t
+{
+    size_t assets = 1000; //!< number of announced assets
+    size_t rounds = 100;  //!< metrics sent by each asset in the measured part
+    bool   shm    = true; //!< each round is also read from fty_shm
+};
+
+// allocations done by 'fn'
+template <typename Fn>
+static uint64_t s_count(Fn fn)
+{
+    uint64_t start = s_allocations.load();
+    s_counting.store(true);
+    fn();
+    s_counting.store(false);
+    return s_allocations.load() - start;
+}
+
+static std::string s_asset(size_t i)
+{
+    return "ups-" + std::to_string(i);
+}
+
+// write warm-up trace announcing the assets and steady trace of their metrics, all at time 'now_ms'
+// metric times stay in the past, so the assets are alive and no timer runs during the replay
+static void s_write_traces(const options_t& options, int64_t now_ms)
+{
+    uint64_t   first_sec = uint64_t(now_ms / 1000) - options.rounds - 1;
+    capture_t* capture   = capture_new();
+    capture_start(capture, WARMUP_TRACE);
+    for (size_t i = 0; i < options.assets; i++) {
+        std::string name = s_asset(i);
+        zhash_t*    aux  = zhash_new();
+        zhash_insert(aux, FTY_PROTO_ASSET_TYPE, const_cast<char*>("device"));
+        zhash_insert(aux, FTY_PROTO_ASSET_SUBTYPE, const_cast<char*>("ups"));
+        zmsg_t* msg = fty_proto_encode_asset(aux, name.c_str(), FTY_PROTO_ASSET_OP_CREATE, NULL);
+        zhash_destroy(&aux);
+        capture_message(capture, now_ms, "STREAM DELIVER", FTY_PROTO_STREAM_ASSETS, "asset-agent", name.c_str(), msg);
+        zmsg_destroy(&msg);
+        msg = fty_proto_encode_metric(NULL, first_sec, 900, "status.ups", name.c_str(), "1", "");
+        std::string subject = "status.ups@" + name;
+        capture_message(
+            capture, now_ms, "STREAM DELIVER", FTY_PROTO_STREAM_METRICS, "nut", subject.c_str(), msg);
+        zmsg_destroy(&msg);
+    }
+
+    capture_start(capture, STEADY_TRACE);
+    for (size_t round = 1; round <= options.rounds; round++) {
+        fty::shm::shmMetrics metrics;
+        for (size_t i = 0; i < options.assets; i++) {
+            std::string name    = s_asset(i);
+            std::string subject = "status.ups@" + name;
+            zmsg_t* msg = fty_proto_encode_metric(NULL, first_sec + round, 900, "status.ups", name.c_str(), "1", "");
+            capture_message(
+                capture, now_ms, "STREAM DELIVER", FTY_PROTO_STREAM_METRICS, "nut", subject.c_str(), msg);
+            if (options.shm)
+                metrics.add(fty_proto_decode(&msg));
+            zmsg_destroy(&msg);
+        }
+        if (options.shm)
+            capture_metrics(capture, now_ms, {&metrics});
+    }
+    capture_destroy(&capture);
+}
+
+// read the trace as the replay does, without handling the records
+// return number of records, 'metrics' is set to number of metrics in fty_shm batches
+static int64_t s_read_trace(const char* path, size_t* metrics)
+{
+    FILE* trace = capture_open(path);
+    if (!trace)
+        return -1;
+    capture_record_t record  = {};
+    int64_t          records = 0;
+    while (capture_read(trace, record) == 0) {
+        if (record.kind == CAPTURE_METRICS) {
+            fty::shm::shmMetrics batch;
+            capture_record_metrics(record, batch);
+            *metrics += batch.size();
+        }
+        zmsg_destroy(&record.content);
+        records++;
+    }
+    fclose(trace);
+    return records;
+}
+
+static int64_t s_replay(zactor_t* outage, const char* path)
+{
+    zstr_sendx(outage, "REPLAY", path, "0", NULL);
+    char*   reply   = zstr_recv(outage);
+    int64_t records = reply ? atoll(reply) : -1;
+    zstr_free(&reply);
+    return records;
+}
+
+static int s_usage(void)
+{
+    puts("fty-outage-bench-alloc [options]");
+    puts("  --assets N        number of assets (default 1000)");
+    puts("  --rounds N        metrics of each asset in the measured part (default 100)");
+    puts("  --no-shm          send the metrics only through METRICS stream");
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    options_t options;
+    for (int argn = 1; argn < argc; argn++) {
+        const char* option = argv[argn];
+        if (streq(option, "--help") || streq(option, "-h"))
+            return s_usage();
+        else if (streq(option, "--assets") && argn < argc - 1)
+            options.assets = size_t(atol(argv[++argn]));
+        else if (streq(option, "--rounds") && argn < argc - 1)
+            options.rounds = size_t(atol(argv[++argn]));
+        else if (streq(option, "--no-shm"))
+            options.shm = false;
+        else {
+            printf("Unknown option: %s\n", option);
+            return 1;
+        }
+    }
+    if (options.assets == 0 || options.rounds == 0)
+        return s_usage();
+
+    s_write_traces(options, zclock_time());
+
+    // fty_shm is empty, shm batches come from the trace; the agent is not connected, it sends nothing
+    zsys_dir_create(SHM_DIR);
+    fty_shm_set_test_dir(SHM_DIR);
+    zactor_t* outage = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    zstr_sendx(outage, "STATS-INTERVAL", "0", NULL);
+    zstr_sendx(outage, "SHM-STATUS", "0", NULL);
+    int rv = s_replay(outage, WARMUP_TRACE) < 0 ? 1 : 0;
+
+    size_t   shm_metrics = 0;
+    int64_t  records     = 0;
+    uint64_t reading     = s_count([&] {
+        records = s_read_trace(STEADY_TRACE, &shm_metrics);
+    });
+    int64_t  replayed    = 0;
+    uint64_t agent       = s_count([&] {
+        replayed = s_replay(outage, STEADY_TRACE);
+    });
+
+    // fty_proto_decode is the codec of the stream messages, nothing else decodes them
+    zmsg_t*  encoded  = fty_proto_encode_metric(NULL, 1, 900, "status.ups", "ups-0", "1", "");
+    uint64_t decoding = s_count([&] {
+        for (size_t i = 0; i < options.rounds; i++) {
+            zmsg_t*      msg    = zmsg_dup(encoded);
+            fty_proto_t* metric = fty_proto_decode(&msg);
+            fty_proto_destroy(&metric);
+        }
+    });
+    uint64_t copying  = s_count([&] {
+        for (size_t i = 0; i < options.rounds; i++) {
+            zmsg_t* msg = zmsg_dup(encoded);
+            zmsg_destroy(&msg);
+        }
+    });
+    zmsg_destroy(&encoded);
+
+    if (rv != 0 || records < 0 || replayed != records) {
+        printf("Can't replay the generated traces\n");
+        rv = 1;
+    } else {
+        size_t stream  = options.assets * options.rounds;
+        double handled = double(agent) - double(reading);
+        double decode  = double(decoding - copying) / double(options.rounds);
+        printf("records           %lld (%zu stream metrics, %zu fty_shm metrics)\n", static_cast<long long>(records),
+            stream, shm_metrics);
+        printf("trace reading     %.2f allocations per record, not done by the agent\n",
+            double(reading) / double(records));
+        printf("agent             %.2f allocations per stream metric\n", handled / double(stream));
+        printf("fty_proto decode  %.2f allocations per stream metric\n", decode);
+        printf("agent w/o decode  %.2f allocations per stream metric\n", handled / double(stream) - decode);
+    }
+
+    zactor_destroy(&outage);
+    fty_shm_delete_test_dir();
+    zsys_file_delete(WARMUP_TRACE);
+    zsys_file_delete(STEADY_TRACE);
+    return rv;
+}
@@ -0,0 +1,109 @@
+/// Measures data_put, data_touch_asset, data_get_dead and data_delete with 1k to 1M assets
+/// and the memory used per asset. Usage: fty-outage-bench-data [max_assets] [touch_rounds]
+
+#include "src/data.h"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// resident set size of the process, in bytes
+static uint64_t s_rss(void)
+{
+    unsigned long size = 0, resident = 0;
+    FILE*         statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%lu %lu", &size, &resident) != 2)
+            resident = 0;
+        fclose(statm);
+    }
+    return uint64_t(resident) * uint64_t(sysconf(_SC_PAGESIZE));
+}
+
+static fty_proto_t* s_asset(const char* name, const char* operation)
+{
+    fty_proto_t* asset = fty_proto_new(FTY_PROTO_ASSET);
+    fty_proto_set_name(asset, "%s", name);
+    fty_proto_set_operation(asset, "%s", operation);
+    fty_proto_aux_insert(asset, FTY_PROTO_ASSET_TYPE, "%s", "device");
+    fty_proto_aux_insert(asset, FTY_PROTO_ASSET_SUBTYPE, "%s", "ups");
+    fty_proto_aux_insert(asset, FTY_PROTO_ASSET_STATUS, "%s", "active");
+    fty_proto_ext_insert(asset, "name", "%s", name);
+    return asset;
+}
+
+// operations per second
+static double s_rate(size_t operations, int64_t usec)
+{
+    return usec > 0 ? double(operations) * 1e6 / double(usec) : 0;
+}
+
+static void s_bench(size_t count, size_t touch_rounds)
+{
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        names.push_back("ups-" + std::to_string(i));
+
+    uint64_t rss_before = s_rss();
+    data_t*  data       = data_new();
+
+    // insertion, messages are created outside of the measurement
+    std::vector<fty_proto_t*> assets;
+    assets.reserve(count);
+    for (const auto& name : names)
+        assets.push_back(s_asset(name.c_str(), FTY_PROTO_ASSET_OP_CREATE));
+    int64_t start = zclock_usecs();
+    for (auto& asset : assets)
+        data_put(data, &asset);
+    int64_t put_usec = zclock_usecs() - start;
+    assets.clear();
+    assets.shrink_to_fit();
+    uint64_t rss_after = s_rss();
+
+    // touches
+    uint64_t now_sec = uint64_t(zclock_time() / 1000);
+    start            = zclock_usecs();
+    for (size_t round = 0; round < touch_rounds; round++) {
+        for (const auto& name : names)
+            data_touch_asset(data, name.c_str(), now_sec, 60, now_sec);
+    }
+    int64_t touch_usec = zclock_usecs() - start;
+
+    // dead check with no dead asset, then with all of them dead
+    start                  = zclock_usecs();
+    size_t  alive_dead     = data_get_dead(data).size();
+    int64_t dead_none_usec = zclock_usecs() - start;
+    for (void* it = zhashx_first(data->assets); it != NULL; it = zhashx_next(data->assets))
+        reinterpret_cast<expiration_t*>(it)->last_time_seen_sec = 0;
+    start                 = zclock_usecs();
+    size_t  all_dead      = data_get_dead(data).size();
+    int64_t dead_all_usec = zclock_usecs() - start;
+
+    // deletion
+    start = zclock_usecs();
+    for (const auto& name : names)
+        data_delete(data, name.c_str());
+    int64_t delete_usec = zclock_usecs() - start;
+
+    data_destroy(&data);
+
+    if (alive_dead != 0 || all_dead != count)
+        fprintf(stderr, "unexpected dead assets: %zu alive, %zu of %zu dead\n", alive_dead, all_dead, count);
+
+    printf("%9zu %12.0f %12.0f %12.0f %11.2f %11.2f %10.0f\n", count, s_rate(count, put_usec),
+        s_rate(count * touch_rounds, touch_usec), s_rate(count, delete_usec), double(dead_none_usec) / 1000,
+        double(dead_all_usec) / 1000, double(int64_t(rss_after) - int64_t(rss_before)) / double(count));
+}
+
+int main(int argc, char* argv[])
+{
+    size_t max_assets   = argc > 1 ? size_t(strtoull(argv[1], NULL, 10)) : 1000000;
+    size_t touch_rounds = argc > 2 ? size_t(strtoull(argv[2], NULL, 10)) : 10;
+
+    printf("%9s %12s %12s %12s %11s %11s %10s\n", "assets", "put/s", "touch/s", "delete/s", "dead[ms]",
+        "alldead[ms]", "B/asset");
+    for (size_t count = 1000; count <= max_assets; count *= 10)
+        s_bench(count, touch_rounds);
+    return 0;
+}
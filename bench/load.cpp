@@ -0,0 +1,296 @@
+/// End-to-end load generator: starts in-process malamute broker, fty_shm test directory and fty-outage actor,
+/// announces assets and publishes their metrics at configured rate with configured failure patterns, then
+/// reports sustained throughput, CPU per message, detection latency and alerts. Run with --help for options.
+
+#include "src/fty-outage-server.h"
+#include <cstdio>
+#include <fty_proto.h>
+#include <fty_shm.h>
+#include <malamute.h>
+#include <map>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+static const char* ENDPOINT = "inproc://fty-outage-bench";
+static const char* SHM_DIR  = "fty-outage-bench-shm";
+
+struct options_t
+{
+    size_t assets       = 10000; //!< number of announced assets
+    double rate         = 5000;  //!< metrics per second
+    int    duration_sec = 60;    //!< how long metrics are published
+    int    ttl_sec      = 10;    //!< TTL of metrics
+    int    poll_sec     = 5;     //!< polling interval, dead checks are done each one
+    double fail         = 1;     //!< % of assets which stop sending in the middle of the run
+    double flap         = 0;     //!< % of assets which keep stopping and resuming
+    int    flap_sec     = 30;    //!< how long flapping assets are silent, then sending
+    bool   shm          = false; //!< write metrics into fty_shm instead of METRICS stream
+};
+
+// send mailbox request, returns the reply frames after correlation ID and REPLY, empty on timeout
+static std::vector<std::string> s_request(mlm_client_t* client, std::initializer_list<const char*> frames)
+{
+    std::vector<std::string> reply;
+
+    zmsg_t* request = zmsg_new();
+    zmsg_addstr(request, "REQUEST");
+    zmsg_addstr(request, "bench");
+    for (const char* frame : frames)
+        zmsg_addstr(request, frame);
+    if (mlm_client_sendto(client, "fty-outage", "BENCH", NULL, 1000, &request) != 0) {
+        zmsg_destroy(&request);
+        return reply;
+    }
+
+    zpoller_t* poller = zpoller_new(mlm_client_msgpipe(client), NULL);
+    zmsg_t*    msg    = zpoller_wait(poller, 30000) ? mlm_client_recv(client) : NULL;
+    zpoller_destroy(&poller);
+    for (char* frame = msg ? zmsg_popstr(msg) : NULL; frame != NULL; frame = zmsg_popstr(msg)) {
+        reply.emplace_back(frame);
+        zstr_free(&frame);
+    }
+    zmsg_destroy(&msg);
+    if (reply.size() >= 2)
+        reply.erase(reply.begin(), reply.begin() + 2);
+    return reply;
+}
+
+// STATS reply as name => value
+static std::map<std::string, uint64_t> s_stats(mlm_client_t* client)
+{
+    std::map<std::string, uint64_t> stats;
+    auto                            reply = s_request(client, {"STATS"});
+    for (size_t i = 1; i + 1 < reply.size(); i += 2)
+        stats[reply[i]] = strtoull(reply[i + 1].c_str(), NULL, 10);
+    return stats;
+}
+
+// LATENCY reply as name => {count, p50, p99, max}
+static std::map<std::string, std::vector<uint64_t>> s_latency(mlm_client_t* client)
+{
+    std::map<std::string, std::vector<uint64_t>> latency;
+    auto                                         reply = s_request(client, {"LATENCY"});
+    for (size_t i = 1; i + 4 < reply.size(); i += 5) {
+        for (size_t j = 1; j <= 4; j++)
+            latency[reply[i]].push_back(strtoull(reply[i + j].c_str(), NULL, 10));
+    }
+    return latency;
+}
+
+// process CPU time, in microseconds
+static int64_t s_cpu_usec(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return int64_t(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec +
+           usage.ru_stime.tv_usec;
+}
+
+// count alerts waiting for the consumer
+static void s_drain_alerts(mlm_client_t* consumer, size_t* active, size_t* resolved)
+{
+    while (zsock_events(mlm_client_msgpipe(consumer)) & ZMQ_POLLIN) {
+        zmsg_t*      msg   = mlm_client_recv(consumer);
+        fty_proto_t* alert = msg ? fty_proto_decode(&msg) : NULL;
+        if (alert) {
+            if (streq(fty_proto_state(alert), "ACTIVE"))
+                (*active)++;
+            else
+                (*resolved)++;
+        }
+        fty_proto_destroy(&alert);
+        zmsg_destroy(&msg);
+    }
+}
+
+// asset 'index' is silent at 'elapsed_sec' of the run
+static bool s_silent(const options_t& options, size_t index, double elapsed_sec)
+{
+    double share = 100.0 * double(index) / double(options.assets); // % of assets with lower index
+    if (share < options.fail)
+        return elapsed_sec >= options.duration_sec / 2;
+    if (share < options.fail + options.flap)
+        return int(elapsed_sec / options.flap_sec) % 2 == 1;
+    return false;
+}
+
+static int s_usage(void)
+{
+    puts("fty-outage-bench-load [options] ...");
+    puts("  --assets N        number of assets (default 10000)");
+    puts("  --rate N          metrics per second (default 5000)");
+    puts("  --duration S      seconds of publishing (default 60)");
+    puts("  --ttl S           TTL of metrics (default 10)");
+    puts("  --poll S          polling interval, dead checks are done each one (default 5)");
+    puts("  --fail P          % of assets which stop sending in the middle of the run (default 1)");
+    puts("  --flap P          % of assets which keep stopping and resuming (default 0)");
+    puts("  --flap-period S   how long flapping assets are silent, then sending (default 30)");
+    puts("  --shm             write metrics into fty_shm instead of METRICS stream");
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    options_t options;
+    for (int argn = 1; argn < argc; argn++) {
+        const char* option = argv[argn];
+        if (streq(option, "--help") || streq(option, "-h"))
+            return s_usage();
+        if (streq(option, "--shm")) {
+            options.shm = true;
+            continue;
+        }
+
+        // other options have a value
+        const char* param = (argn < argc - 1) ? argv[++argn] : "0";
+        if (streq(option, "--assets"))
+            options.assets = size_t(strtoull(param, NULL, 10));
+        else if (streq(option, "--rate"))
+            options.rate = atof(param);
+        else if (streq(option, "--duration"))
+            options.duration_sec = atoi(param);
+        else if (streq(option, "--ttl"))
+            options.ttl_sec = atoi(param);
+        else if (streq(option, "--poll"))
+            options.poll_sec = atoi(param);
+        else if (streq(option, "--fail"))
+            options.fail = atof(param);
+        else if (streq(option, "--flap"))
+            options.flap = atof(param);
+        else if (streq(option, "--flap-period"))
+            options.flap_sec = atoi(param);
+        else {
+            printf("Unknown option: %s\n", option);
+            return 1;
+        }
+    }
+    if (options.assets == 0 || options.rate <= 0 || options.duration_sec <= 0 || options.flap_sec <= 0)
+        return s_usage();
+
+    zactor_t* broker = zactor_new(mlm_server, const_cast<char*>("Malamute"));
+    zstr_sendx(broker, "BIND", ENDPOINT, NULL);
+
+    zsys_dir_create(SHM_DIR);
+    fty_shm_set_test_dir(SHM_DIR);
+    fty_shm_set_default_polling_interval(options.poll_sec);
+
+    zactor_t* outage = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    zstr_sendx(outage, "CONNECT", ENDPOINT, "fty-outage", NULL);
+    zstr_sendx(outage, "CONSUMER", FTY_PROTO_STREAM_METRICS, ".*", NULL);
+    zstr_sendx(outage, "CONSUMER", FTY_PROTO_STREAM_ASSETS, ".*", NULL);
+    zstr_sendx(outage, "PRODUCER", FTY_PROTO_STREAM_ALERTS_SYS, NULL);
+    zstr_sendx(outage, "STATS-INTERVAL", "0", NULL);
+    zstr_sendx(outage, "SHM-STATUS", "0", NULL);
+    // failure patterns silence many assets at once, their alerts must not be held as waves
+    zstr_sendx(outage, "WAVE", "0", "0", "0", "0", NULL);
+
+    mlm_client_t* asset_sender = mlm_client_new();
+    mlm_client_connect(asset_sender, ENDPOINT, 5000, "bench-assets");
+    mlm_client_set_producer(asset_sender, FTY_PROTO_STREAM_ASSETS);
+    mlm_client_t* metric_sender = mlm_client_new();
+    mlm_client_connect(metric_sender, ENDPOINT, 5000, "bench-metrics");
+    mlm_client_set_producer(metric_sender, FTY_PROTO_STREAM_METRICS);
+    mlm_client_t* consumer = mlm_client_new();
+    mlm_client_connect(consumer, ENDPOINT, 5000, "bench-alerts");
+    mlm_client_set_consumer(consumer, FTY_PROTO_STREAM_ALERTS_SYS, ".*");
+    mlm_client_t* requester = mlm_client_new();
+    mlm_client_connect(requester, ENDPOINT, 5000, "bench-requests");
+    zclock_sleep(500);
+
+    // announce the assets
+    std::vector<std::string> names;
+    for (size_t i = 0; i < options.assets; i++) {
+        names.push_back("ups-" + std::to_string(i));
+        zhash_t* aux = zhash_new();
+        zhash_insert(aux, FTY_PROTO_ASSET_TYPE, const_cast<char*>("device"));
+        zhash_insert(aux, FTY_PROTO_ASSET_SUBTYPE, const_cast<char*>("ups"));
+        zhash_insert(aux, FTY_PROTO_ASSET_STATUS, const_cast<char*>("active"));
+        zmsg_t* msg = fty_proto_encode_asset(aux, names.back().c_str(), FTY_PROTO_ASSET_OP_CREATE, NULL);
+        mlm_client_send(asset_sender, names.back().c_str(), &msg);
+        zhash_destroy(&aux);
+    }
+    while (s_stats(requester)["assets_added"] < options.assets)
+        zclock_sleep(100);
+    printf("%zu assets announced\n", options.assets);
+
+    auto    stats_before = s_stats(requester);
+    int64_t cpu_start    = s_cpu_usec();
+    int64_t start_ms     = zclock_mono();
+    size_t  sent = 0, silent = 0, active = 0, resolved = 0;
+
+    while (!zsys_interrupted) {
+        double elapsed_sec = double(zclock_mono() - start_ms) / 1000;
+        if (elapsed_sec >= options.duration_sec)
+            break;
+
+        for (size_t due = size_t(elapsed_sec * options.rate); sent + silent < due;) {
+            size_t      index = (sent + silent) % options.assets;
+            const char* name  = names[index].c_str();
+            if (s_silent(options, index, elapsed_sec)) {
+                silent++;
+                continue;
+            }
+            if (options.shm)
+                fty::shm::write_metric(name, "status.ups", "1", "", options.ttl_sec);
+            else {
+                zmsg_t* msg = fty_proto_encode_metric(
+                    NULL, uint64_t(zclock_time() / 1000), uint32_t(options.ttl_sec), "status.ups", name, "1", "");
+                mlm_client_send(metric_sender, name, &msg);
+            }
+            sent++;
+        }
+        s_drain_alerts(consumer, &active, &resolved);
+        zclock_sleep(5);
+    }
+    int64_t publish_ms = zclock_mono() - start_ms;
+
+    // wait until the agent processes all the metrics, metrics in fty_shm are all read by the next poll
+    const char* counter   = options.shm ? "touches" : "msg_metrics";
+    uint64_t    processed = 0;
+    if (options.shm)
+        zclock_sleep(options.poll_sec * 1000 + 500);
+    for (int idle = 0; idle < 50 && !options.shm; idle++) {
+        uint64_t now = s_stats(requester)[counter] - stats_before[counter];
+        if (now != processed)
+            idle = 0;
+        processed = now;
+        if (processed >= sent)
+            break;
+        zclock_sleep(100);
+    }
+    if (options.shm)
+        processed = s_stats(requester)[counter] - stats_before[counter];
+    int64_t total_ms = zclock_mono() - start_ms;
+    int64_t cpu_usec = s_cpu_usec() - cpu_start;
+    s_drain_alerts(consumer, &active, &resolved);
+
+    auto stats   = s_stats(requester);
+    auto latency = s_latency(requester);
+
+    printf("published         %zu metrics in %.1f s (%.0f/s), %zu skipped by failure patterns\n", sent,
+        double(publish_ms) / 1000, double(sent) * 1000 / double(publish_ms), silent);
+    printf("processed         %llu metrics in %.1f s (%.0f/s)\n", static_cast<unsigned long long>(processed),
+        double(total_ms) / 1000, double(processed) * 1000 / double(total_ms));
+    printf("cpu per metric    %.2f us (whole process, generator and broker included)\n",
+        processed ? double(cpu_usec) / double(processed) : 0.0);
+    printf("alerts            %zu ACTIVE, %zu RESOLVED\n", active, resolved);
+    for (const char* name : {"outage_detection", "recovery_detection", "ingest_lag", "stream_message", "dead_check"}) {
+        const auto& row = latency[name];
+        if (row.size() == 4)
+            printf("%-17s count %llu, p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", name,
+                static_cast<unsigned long long>(row[0]), double(row[1]) / 1000, double(row[2]) / 1000,
+                double(row[3]) / 1000);
+    }
+    printf("dead checks       %llu, %llu deferred\n", static_cast<unsigned long long>(stats["dead_checks"]),
+        static_cast<unsigned long long>(stats["dead_checks_deferred"]));
+
+    mlm_client_destroy(&requester);
+    mlm_client_destroy(&consumer);
+    mlm_client_destroy(&metric_sender);
+    mlm_client_destroy(&asset_sender);
+    zactor_destroy(&outage);
+    zactor_destroy(&broker);
+    fty_shm_delete_test_dir();
+    return 0;
+}
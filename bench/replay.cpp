@@ -0,0 +1,170 @@
+/// Replay driver: feeds a trace captured by the agent (CAPTURE actor command, server/capture_file) through
+/// the handlers of fty-outage actor connected to in-process malamute broker, as fast as possible or at scaled
+/// speed, then reports throughput, CPU per record, alerts and latencies. Intended to be run under perf or
+/// valgrind. Run with --help for options.
+
+#include "src/fty-outage-server.h"
+#include <algorithm>
+#include <cstdio>
+#include <fty_proto.h>
+#include <fty_shm.h>
+#include <malamute.h>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+static const char* ENDPOINT = "inproc://fty-outage-replay";
+static const char* SHM_DIR  = "fty-outage-replay-shm";
+
+// process CPU time, in microseconds
+static int64_t s_cpu_usec(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return int64_t(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec +
+           usage.ru_stime.tv_usec;
+}
+
+// count alerts waiting for the consumer
+static void s_drain_alerts(mlm_client_t* consumer, size_t* active, size_t* resolved)
+{
+    while (zsock_events(mlm_client_msgpipe(consumer)) & ZMQ_POLLIN) {
+        zmsg_t*      msg   = mlm_client_recv(consumer);
+        fty_proto_t* alert = msg ? fty_proto_decode(&msg) : NULL;
+        if (alert) {
+            if (streq(fty_proto_state(alert), "ACTIVE"))
+                (*active)++;
+            else
+                (*resolved)++;
+        }
+        fty_proto_destroy(&alert);
+        zmsg_destroy(&msg);
+    }
+}
+
+// send LATENCY request, print the distributions
+static void s_print_latency(mlm_client_t* client)
+{
+    zmsg_t* request = zmsg_new();
+    zmsg_addstr(request, "REQUEST");
+    zmsg_addstr(request, "replay");
+    zmsg_addstr(request, "LATENCY");
+    if (mlm_client_sendto(client, "fty-outage", "REPLAY", NULL, 1000, &request) != 0) {
+        zmsg_destroy(&request);
+        return;
+    }
+
+    zpoller_t* poller = zpoller_new(mlm_client_msgpipe(client), NULL);
+    zmsg_t*    msg    = zpoller_wait(poller, 30000) ? mlm_client_recv(client) : NULL;
+    zpoller_destroy(&poller);
+    std::vector<std::string> reply;
+    for (char* frame = msg ? zmsg_popstr(msg) : NULL; frame != NULL; frame = zmsg_popstr(msg)) {
+        reply.emplace_back(frame);
+        zstr_free(&frame);
+    }
+    zmsg_destroy(&msg);
+
+    // uuid/REPLY/OK/[name/count/p50/p99/max]*
+    for (size_t i = 3; i + 4 < reply.size(); i += 5) {
+        if (reply[i + 1] == "0")
+            continue;
+        printf("%-19s count %s, p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", reply[i].c_str(), reply[i + 1].c_str(),
+            atof(reply[i + 2].c_str()) / 1000, atof(reply[i + 3].c_str()) / 1000, atof(reply[i + 4].c_str()) / 1000);
+    }
+}
+
+static int s_usage(void)
+{
+    puts("fty-outage-replay [options] trace");
+    puts("  --speed X         replay X times faster than captured, 0 as fast as possible (default 0)");
+    puts("  --config FILE     agent configuration with policy, maintenance windows and flap damping");
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* trace  = NULL;
+    const char* speed  = "0";
+    const char* config = NULL;
+    for (int argn = 1; argn < argc; argn++) {
+        const char* option = argv[argn];
+        if (streq(option, "--help") || streq(option, "-h"))
+            return s_usage();
+        else if (streq(option, "--speed") && argn < argc - 1)
+            speed = argv[++argn];
+        else if (streq(option, "--config") && argn < argc - 1)
+            config = argv[++argn];
+        else if (option[0] != '-' && !trace)
+            trace = option;
+        else {
+            printf("Unknown option: %s\n", option);
+            return 1;
+        }
+    }
+    if (!trace)
+        return s_usage();
+
+    zactor_t* broker = zactor_new(mlm_server, const_cast<char*>("Malamute"));
+    zstr_sendx(broker, "BIND", ENDPOINT, NULL);
+
+    // nothing is read from fty_shm, shm batches come from the trace
+    zsys_dir_create(SHM_DIR);
+    fty_shm_set_test_dir(SHM_DIR);
+
+    zactor_t* outage = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    zstr_sendx(outage, "CONNECT", ENDPOINT, "fty-outage", NULL);
+    zstr_sendx(outage, "PRODUCER", FTY_PROTO_STREAM_ALERTS_SYS, NULL);
+    zstr_sendx(outage, "STATS-INTERVAL", "0", NULL);
+    if (config) {
+        zconfig_t* cfg = zconfig_load(config);
+        if (cfg) {
+            zstr_sendx(outage, "POLICY", config, NULL);
+            zstr_sendx(outage, "MAINTENANCE-WINDOWS", config, NULL);
+            zstr_sendx(outage, "FLAP-DAMPING", zconfig_get(cfg, "server/flap_half_life", "900"),
+                zconfig_get(cfg, "server/flap_suppress", "2500"), zconfig_get(cfg, "server/flap_reuse", "750"),
+                NULL);
+            zconfig_destroy(&cfg);
+        } else
+            printf("Can't load %s, using defaults\n", config);
+    }
+
+    mlm_client_t* consumer = mlm_client_new();
+    mlm_client_connect(consumer, ENDPOINT, 5000, "replay-alerts");
+    mlm_client_set_consumer(consumer, FTY_PROTO_STREAM_ALERTS_SYS, ".*");
+    mlm_client_t* requester = mlm_client_new();
+    mlm_client_connect(requester, ENDPOINT, 5000, "replay-requests");
+    zclock_sleep(500);
+
+    int64_t cpu_start = s_cpu_usec();
+    int64_t start_ms  = zclock_mono();
+    zstr_sendx(outage, "REPLAY", trace, speed, NULL);
+    char*   reply     = zstr_recv(outage);
+    int64_t records   = reply ? atoll(reply) : -1;
+    int64_t total_ms  = std::max(zclock_mono() - start_ms, int64_t(1));
+    int64_t cpu_usec  = s_cpu_usec() - cpu_start;
+    zstr_free(&reply);
+
+    int rv = 0;
+    if (records < 0) {
+        printf("Can't replay %s\n", trace);
+        rv = 1;
+    } else {
+        size_t active = 0, resolved = 0;
+        zclock_sleep(500);
+        s_drain_alerts(consumer, &active, &resolved);
+
+        printf("replayed          %lld records in %.1f s (%.0f/s)\n", static_cast<long long>(records),
+            double(total_ms) / 1000, double(records) * 1000 / double(total_ms));
+        printf("cpu per record    %.2f us (whole process, broker included)\n",
+            records ? double(cpu_usec) / double(records) : 0.0);
+        printf("alerts            %zu ACTIVE, %zu RESOLVED\n", active, resolved);
+        s_print_latency(requester);
+    }
+
+    mlm_client_destroy(&requester);
+    mlm_client_destroy(&consumer);
+    zactor_destroy(&outage);
+    zactor_destroy(&broker);
+    fty_shm_delete_test_dir();
+    return rv;
+}
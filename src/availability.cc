@@ -0,0 +1,218 @@
+/*  =========================================================================
+    availability - Outage time of an asset over rolling windows
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "availability.h"
+#include <algorithm>
+
+static const struct
+{
+    uint64_t    bucket_sec;
+    uint64_t    buckets;
+    const char* name;
+} s_windows[AVAILABILITY_WINDOWS] = {{5 * 60, 12, "1h"}, {60 * 60, 24, "24h"}, {24 * 60 * 60, 30, "30d"}};
+
+// time moved by a step of the wall clock, 0 stays unset
+static uint64_t s_availability_shift_sec(uint64_t sec, int64_t jump_sec)
+{
+    if (sec == 0)
+        return 0;
+    return uint64_t(std::max(int64_t(sec) + jump_sec, int64_t(1)));
+}
+
+// first time covered by the ring of 'window'
+static uint64_t s_availability_oldest_sec(availability_t* self, int window)
+{
+    uint64_t buckets = s_windows[window].buckets;
+    uint64_t bucket  = self->bucket[window];
+    return (bucket >= buckets ? bucket - buckets + 1 : 0) * s_windows[window].bucket_sec;
+}
+
+// move ring of each window to the bucket of 'now_sec', buckets left behind are dropped
+static void s_availability_rotate(availability_t* self, uint64_t now_sec)
+{
+    for (int w = 0; w < AVAILABILITY_WINDOWS; w++) {
+        uint64_t buckets = s_windows[w].buckets;
+        uint64_t bucket  = now_sec / s_windows[w].bucket_sec;
+        if (bucket <= self->bucket[w])
+            continue;
+        if (bucket - self->bucket[w] >= buckets) {
+            memset(self->down[w], 0, sizeof(self->down[w]));
+            self->sum[w] = 0;
+        } else {
+            for (uint64_t b = self->bucket[w] + 1; b <= bucket; b++) {
+                self->sum[w] -= self->down[w][b % buckets];
+                self->down[w][b % buckets] = 0;
+            }
+        }
+        self->bucket[w] = bucket;
+    }
+}
+
+// add (or remove, if 'add' is false) outage from 'from_sec' to 'to_sec' into the buckets still in the rings
+static void s_availability_put(availability_t* self, uint64_t from_sec, uint64_t to_sec, bool add)
+{
+    for (int w = 0; w < AVAILABILITY_WINDOWS; w++) {
+        uint64_t bucket_sec = s_windows[w].bucket_sec;
+        uint64_t buckets    = s_windows[w].buckets;
+        uint64_t from       = std::max(from_sec, s_availability_oldest_sec(self, w));
+        uint64_t to         = std::min(to_sec, (self->bucket[w] + 1) * bucket_sec);
+        while (from < to) {
+            uint64_t  end    = std::min(to, (from / bucket_sec + 1) * bucket_sec);
+            uint32_t& down   = self->down[w][(from / bucket_sec) % buckets];
+            uint32_t  amount = uint32_t(end - from);
+            if (!add)
+                amount = std::min(amount, down);
+            down         = add ? down + amount : down - amount;
+            self->sum[w] = add ? self->sum[w] + amount : self->sum[w] - amount;
+            from         = end;
+        }
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new availability of asset tracked since 'since_sec'
+availability_t* availability_new(uint64_t since_sec)
+{
+    availability_t* self = reinterpret_cast<availability_t*>(zmalloc(sizeof(availability_t)));
+    if (self)
+        availability_init(self, since_sec);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Initialize availability of asset tracked since 'since_sec', without any outage
+void availability_init(availability_t* self, uint64_t since_sec)
+{
+    assert(self);
+    memset(self, 0, sizeof(availability_t));
+    self->since_sec     = since_sec;
+    self->accounted_sec = since_sec;
+    for (int w = 0; w < AVAILABILITY_WINDOWS; w++)
+        self->bucket[w] = since_sec / s_windows[w].bucket_sec;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the availability
+void availability_destroy(availability_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        free(*self_p);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Length of 'window' in seconds
+uint64_t availability_window_sec(int window)
+{
+    assert(window >= 0 && window < AVAILABILITY_WINDOWS);
+    return s_windows[window].bucket_sec * s_windows[window].buckets;
+}
+
+//  --------------------------------------------------------------------------
+//  Name of 'window'
+const char* availability_window_str(int window)
+{
+    assert(window >= 0 && window < AVAILABILITY_WINDOWS);
+    return s_windows[window].name;
+}
+
+//  --------------------------------------------------------------------------
+//  Move the windows to 'now_sec', put outage time of the ongoing outage into the buckets
+void availability_advance(availability_t* self, uint64_t now_sec)
+{
+    assert(self);
+    s_availability_rotate(self, now_sec);
+    if (self->down_since_sec != 0 && now_sec > self->accounted_sec) {
+        s_availability_put(self, self->accounted_sec, now_sec, true);
+        self->accounted_sec = now_sec;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Wall clock stepped by 'jump_sec', move the outage and the rings along
+void availability_shift(availability_t* self, int64_t jump_sec)
+{
+    assert(self);
+    self->since_sec      = s_availability_shift_sec(self->since_sec, jump_sec);
+    self->down_since_sec = s_availability_shift_sec(self->down_since_sec, jump_sec);
+    self->accounted_sec  = s_availability_shift_sec(self->accounted_sec, jump_sec);
+    for (int w = 0; w < AVAILABILITY_WINDOWS; w++) {
+        int64_t buckets = int64_t(s_windows[w].buckets);
+        int64_t moved   = std::max(jump_sec / int64_t(s_windows[w].bucket_sec), -int64_t(self->bucket[w]));
+        if (moved == 0)
+            continue;
+        // bucket b is kept in slot b % buckets, renumbered bucket moves to another slot
+        uint32_t down[AVAILABILITY_MAX_BUCKETS];
+        for (int64_t b = 0; b < buckets; b++)
+            down[((b + moved) % buckets + buckets) % buckets] = self->down[w][b];
+        memcpy(self->down[w], down, sizeof(uint32_t) * size_t(buckets));
+        self->bucket[w] = uint64_t(int64_t(self->bucket[w]) + moved);
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Outage started at 'start_sec'
+void availability_down(availability_t* self, uint64_t start_sec, uint64_t now_sec)
+{
+    assert(self);
+    if (self->down_since_sec != 0)
+        return;
+    // outages don't overlap, nor start before the asset is tracked
+    self->down_since_sec = std::max(std::min(start_sec, now_sec), std::max(self->accounted_sec, uint64_t(1)));
+    self->accounted_sec  = self->down_since_sec;
+    availability_advance(self, now_sec);
+}
+
+//  --------------------------------------------------------------------------
+//  Ongoing outage ended at 'end_sec'
+void availability_up(availability_t* self, uint64_t end_sec, uint64_t now_sec)
+{
+    assert(self);
+    if (self->down_since_sec == 0)
+        return;
+    availability_advance(self, now_sec);
+    // outage may have been accounted up to now, while the asset recovered earlier
+    end_sec = std::max(std::min(end_sec, now_sec), self->down_since_sec);
+    if (end_sec < self->accounted_sec)
+        s_availability_put(self, end_sec, self->accounted_sec, false);
+    self->down_since_sec = 0;
+    self->accounted_sec  = end_sec;
+}
+
+//  --------------------------------------------------------------------------
+//  Availability over 'window' at 'now_sec'
+availability_report_t availability_get(availability_t* self, int window, uint64_t now_sec)
+{
+    assert(self);
+    assert(window >= 0 && window < AVAILABILITY_WINDOWS);
+    availability_advance(self, now_sec);
+
+    uint64_t              from_sec = std::max(self->since_sec, s_availability_oldest_sec(self, window));
+    availability_report_t report;
+    report.observed_sec = now_sec > from_sec ? now_sec - from_sec : 0;
+    report.outage_sec   = std::min(uint64_t(self->sum[window]), report.observed_sec);
+    report.percent      = report.observed_sec != 0
+                              ? 100.0 * double(report.observed_sec - report.outage_sec) / double(report.observed_sec)
+                              : 100.0;
+    return report;
+}
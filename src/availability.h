@@ -0,0 +1,89 @@
+/*  =========================================================================
+    availability - Outage time of an asset over rolling windows
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <czmq.h>
+
+// Each window is a ring of buckets holding seconds of outage, with the sum of the ring kept aside, so reading
+// is O(1). Outage time is put into the buckets when an outage starts or ends, and when the ring moves to the
+// next bucket. The ring spans the current bucket and the previous ones, so outage time leaves the window one
+// bucket early at most.
+#define AVAILABILITY_WINDOWS     3
+#define AVAILABILITY_MAX_BUCKETS 30
+
+///  Rolling windows
+enum availability_window_t
+{
+    AVAILABILITY_1H  = 0, //!< 12 buckets of 5 minutes
+    AVAILABILITY_24H = 1, //!< 24 buckets of 1 hour
+    AVAILABILITY_30D = 2  //!< 30 buckets of 1 day
+};
+
+///  Outage time of one asset
+struct availability_t
+{
+    uint64_t since_sec;                                           //!< when the asset started to be tracked
+    uint64_t down_since_sec;                                      //!< start of the ongoing outage, 0 if none
+    uint64_t accounted_sec;                                       //!< outage time up to here is in the buckets
+    uint64_t bucket[AVAILABILITY_WINDOWS];                        //!< number of the current bucket of each window
+    uint32_t sum[AVAILABILITY_WINDOWS];                           //!< outage seconds in the ring of each window
+    uint32_t down[AVAILABILITY_WINDOWS][AVAILABILITY_MAX_BUCKETS]; //!< outage seconds in each bucket
+};
+
+///  Availability of an asset over one window
+struct availability_report_t
+{
+    uint64_t outage_sec;   //!< seconds of outage in the window
+    uint64_t observed_sec; //!< seconds of the window the asset was tracked
+    double   percent;      //!< 100 * (1 - outage / observed), 100 if nothing was observed yet
+};
+
+///  Create a new availability of asset tracked since 'since_sec'
+availability_t* availability_new(uint64_t since_sec);
+
+///  Initialize availability of asset tracked since 'since_sec', without any outage
+void availability_init(availability_t* self, uint64_t since_sec);
+
+///  Destroy the availability
+void availability_destroy(availability_t** self_p);
+
+///  Length of 'window' in seconds
+uint64_t availability_window_sec(int window);
+
+///  Name of 'window' (1h, 24h, 30d)
+const char* availability_window_str(int window);
+
+///  Move the windows to 'now_sec', put outage time of the ongoing outage into the buckets
+void availability_advance(availability_t* self, uint64_t now_sec);
+
+///  Wall clock stepped by 'jump_sec' (negative when backward), move the outage and the rings along,
+///  so the step is not charged as outage nor as observed time. Buckets move by whole buckets.
+void availability_shift(availability_t* self, int64_t jump_sec);
+
+///  Outage started at 'start_sec', nothing is done if an outage is already ongoing
+void availability_down(availability_t* self, uint64_t start_sec, uint64_t now_sec);
+
+///  Ongoing outage ended at 'end_sec', nothing is done if there is none
+void availability_up(availability_t* self, uint64_t end_sec, uint64_t now_sec);
+
+///  Availability over 'window' at 'now_sec', moves the windows
+availability_report_t availability_get(availability_t* self, int window, uint64_t now_sec);
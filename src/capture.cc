@@ -0,0 +1,214 @@
+/*  =========================================================================
+    capture - Binary trace of the traffic received by the agent
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "capture.h"
+#include <fty_log.h>
+#include <fty_proto.h>
+
+#define CAPTURE_BUFFER_SIZE 1024 * 1024 // records are written in big chunks
+
+//  --------------------------------------------------------------------------
+//  Create a new capture, not running
+capture_t* capture_new(void)
+{
+    capture_t* self = new capture_t();
+    self->active.store(false);
+    self->file    = NULL;
+    self->records = 0;
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the capture, closing the trace file
+void capture_destroy(capture_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        capture_start(*self_p, NULL);
+        delete *self_p;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Start writing records into 'path', stop the capture if 'path' is NULL or empty
+int capture_start(capture_t* self, const char* path)
+{
+    assert(self);
+    std::lock_guard<std::mutex> lock(self->mutex);
+
+    self->active.store(false);
+    if (self->file) {
+        fclose(self->file);
+        logInfo("capture: stopped after {} records", self->records);
+    }
+    self->file    = NULL;
+    self->records = 0;
+    if (!path || streq(path, ""))
+        return 0;
+
+    self->file = fopen(path, "w");
+    if (!self->file) {
+        logError("capture: can't open {}: %m", path);
+        return -1;
+    }
+    setvbuf(self->file, NULL, _IOFBF, CAPTURE_BUFFER_SIZE);
+    fwrite(CAPTURE_MAGIC, 1, strlen(CAPTURE_MAGIC), self->file);
+    self->active.store(true);
+    logInfo("capture: writing received messages into {}", path);
+    return 0;
+}
+
+static void s_write_string(FILE* file, const char* str)
+{
+    uint16_t size = str ? uint16_t(std::min(strlen(str), size_t(UINT16_MAX))) : 0;
+    fwrite(&size, sizeof(size), 1, file);
+    fwrite(str, 1, size, file);
+}
+
+// write record, 'content' is encoded by the caller
+static void s_capture_write(capture_t* self, capture_kind_t kind, int64_t time_ms, const char* command,
+    const char* address, const char* sender, const char* subject, zframe_t* content)
+{
+    std::lock_guard<std::mutex> lock(self->mutex);
+    if (!self->file)
+        return;
+
+    uint8_t  kind_byte = uint8_t(kind);
+    uint32_t size      = content ? uint32_t(zframe_size(content)) : 0;
+    fwrite(&kind_byte, sizeof(kind_byte), 1, self->file);
+    fwrite(&time_ms, sizeof(time_ms), 1, self->file);
+    s_write_string(self->file, command);
+    s_write_string(self->file, address);
+    s_write_string(self->file, sender);
+    s_write_string(self->file, subject);
+    fwrite(&size, sizeof(size), 1, self->file);
+    if (size)
+        fwrite(zframe_data(content), 1, size, self->file);
+    self->records++;
+}
+
+//  --------------------------------------------------------------------------
+//  Write message 'content' received at 'time_ms', content is not consumed
+void capture_message(capture_t* self, int64_t time_ms, const char* command, const char* address,
+    const char* sender, const char* subject, zmsg_t* content)
+{
+    assert(self);
+    if (!capture_active(self))
+        return;
+
+    zframe_t* frame = content ? zmsg_encode(content) : NULL;
+    s_capture_write(self, CAPTURE_MESSAGE, time_ms, command, address, sender, subject, frame);
+    zframe_destroy(&frame);
+}
+
+//  --------------------------------------------------------------------------
+//  Write 'metrics' read from fty_shm at 'time_ms', batches of the shards as one record
+void capture_metrics(capture_t* self, int64_t time_ms, const shmreader_result_t& metrics)
+{
+    assert(self);
+    if (!capture_active(self))
+        return;
+
+    zmsg_t* batch = zmsg_new();
+    for (auto shard : metrics) {
+        for (auto& element : *shard) {
+            fty_proto_t* metric  = fty_proto_dup(element);
+            zmsg_t*      encoded = fty_proto_encode(&metric);
+            if (encoded) {
+                zframe_t* frame = zmsg_encode(encoded);
+                zmsg_append(batch, &frame);
+                zmsg_destroy(&encoded);
+            }
+        }
+    }
+    zframe_t* frame = zmsg_encode(batch);
+    s_capture_write(self, CAPTURE_METRICS, time_ms, "", "", "", "", frame);
+    zframe_destroy(&frame);
+    zmsg_destroy(&batch);
+}
+
+//  --------------------------------------------------------------------------
+//  Open trace 'path' for reading
+FILE* capture_open(const char* path)
+{
+    FILE* trace = fopen(path, "r");
+    if (!trace) {
+        logError("capture: can't open {}: %m", path);
+        return NULL;
+    }
+    char magic[sizeof(CAPTURE_MAGIC)] = {0};
+    if (fread(magic, 1, strlen(CAPTURE_MAGIC), trace) != strlen(CAPTURE_MAGIC) || !streq(magic, CAPTURE_MAGIC)) {
+        logError("capture: {} is not a trace", path);
+        fclose(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+static bool s_read_string(FILE* trace, std::string& str)
+{
+    uint16_t size;
+    if (fread(&size, sizeof(size), 1, trace) != 1)
+        return false;
+    str.resize(size);
+    return size == 0 || fread(&str[0], 1, size, trace) == size;
+}
+
+//  --------------------------------------------------------------------------
+//  Read next record of the trace into 'record'
+int capture_read(FILE* trace, capture_record_t& record)
+{
+    assert(trace);
+    zmsg_destroy(&record.content);
+
+    uint8_t  kind;
+    uint32_t size;
+    if (fread(&kind, sizeof(kind), 1, trace) != 1 || fread(&record.time_ms, sizeof(record.time_ms), 1, trace) != 1 ||
+        !s_read_string(trace, record.command) || !s_read_string(trace, record.address) ||
+        !s_read_string(trace, record.sender) || !s_read_string(trace, record.subject) ||
+        fread(&size, sizeof(size), 1, trace) != 1)
+        return -1;
+    record.kind = capture_kind_t(kind);
+
+    zframe_t* frame = zframe_new(NULL, size);
+    if (size && fread(zframe_data(frame), 1, size, trace) != size) {
+        zframe_destroy(&frame);
+        return -1;
+    }
+    record.content = size ? zmsg_decode(frame) : zmsg_new();
+    zframe_destroy(&frame);
+    return record.content ? 0 : -1;
+}
+
+//  --------------------------------------------------------------------------
+//  Decode metrics of CAPTURE_METRICS 'record' into 'metrics'
+void capture_record_metrics(capture_record_t& record, fty::shm::shmMetrics& metrics)
+{
+    assert(record.kind == CAPTURE_METRICS);
+    for (zframe_t* frame = zmsg_first(record.content); frame != NULL; frame = zmsg_next(record.content)) {
+        zmsg_t*      encoded = zmsg_decode(frame);
+        fty_proto_t* metric  = encoded ? fty_proto_decode(&encoded) : NULL;
+        if (metric)
+            metrics.add(metric);
+        zmsg_destroy(&encoded);
+    }
+}
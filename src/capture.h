@@ -0,0 +1,102 @@
+/*  =========================================================================
+    capture - Binary trace of the traffic received by the agent
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "shmreader.h"
+#include <atomic>
+#include <czmq.h>
+#include <mutex>
+#include <string>
+
+// File starts with the magic, then records follow:
+//   kind (1 byte), receive time ms (8 bytes),
+//   command, address, sender, subject (each 2 bytes length + data),
+//   content (4 bytes length + zmsg_encode of the message)
+// Integers are in the byte order of the host, traces are replayed where they were captured.
+// Content of a metrics record is a message with one frame per metric, each of them fty_proto_encode'd.
+#define CAPTURE_MAGIC "FTYOCAP1"
+
+///  Kind of a captured record
+enum capture_kind_t
+{
+    CAPTURE_MESSAGE = 1, //!< message received from malamute (stream or mailbox)
+    CAPTURE_METRICS = 2, //!< batch of metrics read from fty_shm
+};
+
+///  Structure of our class, records are written from both actor and shm polling threads
+struct _capture_t
+{
+    std::atomic<bool> active;  //!< capture is running
+    std::mutex        mutex;   //!< serializes the writers
+    FILE*             file;    //!< trace file, NULL if capture is not running
+    uint64_t          records; //!< records written into the current file
+};
+
+typedef struct _capture_t capture_t;
+
+///  One record read from a trace
+struct capture_record_t
+{
+    capture_kind_t kind;    //!< kind of the record
+    int64_t        time_ms; //!< when the agent received it (unix time)
+    std::string    command; //!< mlm command, e.g. STREAM DELIVER or MAILBOX DELIVER
+    std::string    address; //!< stream or mailbox the message was delivered on
+    std::string    sender;  //!< sender of the message
+    std::string    subject; //!< subject of the message
+    zmsg_t*        content; //!< the message, owned by the record
+};
+
+///  Create a new capture, not running
+capture_t* capture_new(void);
+
+///  Destroy the capture, closing the trace file
+void capture_destroy(capture_t** self_p);
+
+///  Start writing records into 'path', truncating it; stop the capture if 'path' is NULL or empty
+///  return -1, if the file can't be opened
+///  return 0 otherwise
+int capture_start(capture_t* self, const char* path);
+
+///  Is the capture running
+inline bool capture_active(capture_t* self)
+{
+    return self->active.load(std::memory_order_relaxed);
+}
+
+///  Write message 'content' received at 'time_ms', content is not consumed
+void capture_message(capture_t* self, int64_t time_ms, const char* command, const char* address,
+    const char* sender, const char* subject, zmsg_t* content);
+
+///  Write 'metrics' read from fty_shm at 'time_ms', batches of the shards as one record
+void capture_metrics(capture_t* self, int64_t time_ms, const shmreader_result_t& metrics);
+
+///  Open trace 'path' for reading
+///  return NULL, if the file can't be opened or is not a trace
+FILE* capture_open(const char* path);
+
+///  Read next record of the trace into value initialized 'record', its previous content is destroyed
+///  return -1 at the end of the trace, or if the record is truncated
+///  return 0 otherwise
+int capture_read(FILE* trace, capture_record_t& record);
+
+///  Decode metrics of CAPTURE_METRICS 'record' into 'metrics'
+void capture_record_metrics(capture_record_t& record, fty::shm::shmMetrics& metrics);
@@ -20,6 +20,8 @@
 */
 
 #include "data.h"
+#include <algorithm>
+#include <cmath>
 #include <fty_log.h>
 
 expiration_t* expiration_new(uint64_t default_expiry_sec, fty_proto_t** msg_p)
@@ -27,8 +29,9 @@ expiration_t* expiration_new(uint64_t default_expiry_sec, fty_proto_t** msg_p)
     assert(msg_p);
     expiration_t* self = reinterpret_cast<expiration_t*>(zmalloc(sizeof(expiration_t)));
     if (self) {
-        self->ttl_sec = default_expiry_sec;
-        self->msg     = *msg_p;
+        self->ttl_sec    = default_expiry_sec;
+        self->multiplier = DEFAULT_POLICY_MULTIPLIER;
+        self->msg        = *msg_p;
         *msg_p        = NULL;
     }
     return self;
@@ -40,6 +43,7 @@ void expiration_destroy(expiration_t** self_p)
     if (*self_p) {
         expiration_t* self = *self_p;
         fty_proto_destroy(&self->msg);
+        availability_destroy(&self->availability);
         free(self);
         *self_p = NULL;
     }
@@ -74,7 +78,41 @@ void expiration_update_ttl(expiration_t* self, uint64_t proposed_ttl)
 uint64_t expiration_get(expiration_t* self)
 {
     assert(self);
-    return self->last_time_seen_sec + self->ttl_sec * 2;
+    return self->last_time_seen_sec + self->ttl_sec * self->multiplier;
+}
+
+// estimate lead of the device clock from the metric with 'timestamp' received at 'now_sec',
+// estimate moves by 1/SKEW_WEIGHT of the difference, at least by one second
+void expiration_skew(expiration_t* self, uint64_t timestamp, uint64_t now_sec)
+{
+    assert(self);
+    int64_t lead = timestamp > now_sec ? int64_t(timestamp - now_sec) : 0;
+    int64_t diff = lead - int64_t(self->skew_sec);
+    if (diff > 0)
+        self->skew_sec += uint32_t((diff + SKEW_WEIGHT - 1) / SKEW_WEIGHT);
+    else if (diff < 0)
+        self->skew_sec -= uint32_t((-diff + SKEW_WEIGHT - 1) / SKEW_WEIGHT);
+}
+
+// 'sec' moved by 'jump_sec', 0 (never) stays
+static uint64_t s_shift_sec(uint64_t sec, int64_t jump_sec)
+{
+    if (sec == 0)
+        return 0;
+    return uint64_t(std::max(int64_t(sec) + jump_sec, int64_t(1)));
+}
+
+// penalty halves every half_life_sec
+void expiration_flap_decay(expiration_t* self, uint32_t half_life_sec, uint64_t now_sec)
+{
+    assert(self);
+    if (now_sec <= self->flap_stamp_sec)
+        return;
+    if (self->flap_penalty != 0 && half_life_sec != 0) {
+        double elapsed      = double(now_sec - self->flap_stamp_sec);
+        self->flap_penalty = uint32_t(double(self->flap_penalty) * exp2(-elapsed / half_life_sec));
+    }
+    self->flap_stamp_sec = now_sec;
 }
 
 void ename_destroy(void** ptr)
@@ -91,6 +129,11 @@ void data_destroy(data_t** self_p)
         data_t* self = *self_p;
         zhashx_destroy(&self->assets);
         zhashx_destroy(&self->asset_enames);
+        zhashx_destroy(&self->debug_assets);
+        policy_destroy(&self->policy);
+        maintenance_destroy(&self->maintenance);
+        stats_destroy(&self->stats);
+        vclock_destroy(&self->clock);
         free(self);
         *self_p = NULL;
     }
@@ -109,9 +152,18 @@ data_t* data_new(void)
         }
         zhashx_set_destructor(self->asset_enames, reinterpret_cast<zhashx_destructor_fn*>(ename_destroy));
 
-        self->assets = zhashx_new();
-        if (self->assets) {
+        self->policy       = policy_new();
+        self->maintenance  = maintenance_new();
+        self->stats        = stats_new();
+        self->clock        = vclock_new();
+        self->debug_assets = zhashx_new();
+        self->assets       = zhashx_new();
+        if (self->assets && self->debug_assets) {
             self->default_expiry_sec = DEFAULT_ASSET_EXPIRATION_TIME_SEC;
+            self->flap_half_life_sec = DEFAULT_FLAP_HALF_LIFE_SEC;
+            self->flap_suppress      = DEFAULT_FLAP_SUPPRESS_LIMIT;
+            self->flap_reuse         = DEFAULT_FLAP_REUSE_LIMIT;
+            self->max_skew_sec       = DEFAULT_MAX_CLOCK_SKEW_SEC;
             zhashx_set_destructor(self->assets, reinterpret_cast<zhashx_destructor_fn*>(expiration_destroy));
         } else
             data_destroy(&self);
@@ -140,9 +192,84 @@ void data_set_default_expiry(data_t* self, uint64_t expiry_sec)
     self->default_expiry_sec = expiry_sec;
 }
 
+//  ------------------------------------------------------------------------
+//  Set monitoring policy, takes ownership of the policy
+void data_set_policy(data_t* self, policy_t** policy_p)
+{
+    assert(self);
+    assert(policy_p);
+    policy_destroy(&self->policy);
+    self->policy = *policy_p;
+    *policy_p    = NULL;
+}
+
+// apply settings of 'rule' to the tracked asset 'e'
+// ttl is the minimum of the rule one and the ones of the metrics, which are not kept apart, so a rule can
+// lower it; higher ttl of a rule applies to the assets added since
+static void s_data_follow_rule(expiration_t* e, const policy_rule_t* rule)
+{
+    if (rule->ttl_sec != 0)
+        expiration_update_ttl(e, rule->ttl_sec);
+    e->multiplier     = rule->multiplier;
+    e->reannounce_sec = rule->reannounce_sec;
+}
+
+//  ------------------------------------------------------------------------
+//  Apply the current policy to the tracked assets, returns assets which are not monitored any more
+std::vector<std::string> data_follow_policy(data_t* self)
+{
+    assert(self);
+    std::vector<std::string> unmonitored;
+    for (void* it = zhashx_first(self->assets); it != NULL; it = zhashx_next(self->assets)) {
+        expiration_t* e = static_cast<expiration_t*>(it);
+        // assets put into maintenance before their asset message came have no representation
+        const char* name = e->msg ? fty_proto_name(e->msg) : NULL;
+        if (name == NULL || *name == '\0')
+            continue;
+        const policy_rule_t* rule = policy_match(self->policy, e->msg);
+        if (rule == NULL) {
+            unmonitored.push_back(static_cast<const char*>(zhashx_cursor(self->assets)));
+            continue;
+        }
+        s_data_follow_rule(e, rule);
+    }
+    return unmonitored;
+}
+
+//  ------------------------------------------------------------------------
+//  Set flap damping parameters, suppress_limit == 0 disables damping
+void data_set_flap_damping(data_t* self, uint32_t half_life_sec, uint32_t suppress_limit, uint32_t reuse_limit)
+{
+    assert(self);
+    self->flap_half_life_sec = half_life_sec;
+    self->flap_suppress      = suppress_limit;
+    self->flap_reuse         = reuse_limit;
+}
+
+//  ------------------------------------------------------------------------
+//  Set how far in the future metrics of devices with clock ahead are accepted
+void data_set_max_skew(data_t* self, uint32_t max_skew_sec)
+{
+    assert(self);
+    self->max_skew_sec = max_skew_sec;
+}
+
+//  ------------------------------------------------------------------------
+//  Switch logging of the hot path of the asset on info level
+void data_set_debug_asset(data_t* self, const char* asset_name, bool enable)
+{
+    assert(self);
+    assert(asset_name);
+    if (enable)
+        zhashx_update(self->debug_assets, asset_name, const_cast<char*>("debug"));
+    else
+        zhashx_delete(self->debug_assets, asset_name);
+}
+
 //  ------------------------------------------------------------------------
 //  update information about expiration time
-//  return -1, if data are from future and are ignored as damaging
+//  return -1, if data are further in the future than max_skew_sec and are ignored as damaging
+//  return 1, if metric from 'timestamp' or later with the same or shorter ttl was already applied
 //  return 0 otherwise
 int data_touch_asset(data_t* self, const char* asset_name, uint64_t timestamp, uint64_t ttl, uint64_t now_sec)
 {
@@ -155,20 +282,95 @@ int data_touch_asset(data_t* self, const char* asset_name, uint64_t timestamp, u
         return 0;
     }
 
+    // the same heartbeat comes from fty_shm and from the stream, other metrics of the same poll
+    // have the same time, nothing would change
+    if (timestamp <= e->last_metric_sec && ttl >= e->ttl_sec) {
+        stats_inc(self->stats, STATS_DUPLICATES);
+        return 1;
+    }
+
     // we know information about this asset
     // try to update ttl
     expiration_update_ttl(e, ttl);
     // need to compute new expiration time
-    if (timestamp > now_sec)
+    if (timestamp > now_sec + self->max_skew_sec) {
+        stats_inc(self->stats, STATS_METRICS_FROM_FUTURE);
         return -1;
-    else {
-        expiration_update(e, timestamp);
-        logDebug("asset: INFO UPDATED name='{}', last_seen={}[s], ttl={}[s], expires_at={}[s]", asset_name,
-            e->last_time_seen_sec, e->ttl_sec, expiration_get(e));
+    } else {
+        if (timestamp > now_sec)
+            stats_inc(self->stats, STATS_METRICS_SKEWED);
+        expiration_skew(e, timestamp, now_sec);
+        stats_inc(self->stats, STATS_TOUCHES);
+        // time of the metric on our clock, metric can't keep the asset alive longer than a current one
+        uint64_t seen_sec = timestamp > e->skew_sec ? timestamp - e->skew_sec : 0;
+        expiration_update(e, std::min(seen_sec, now_sec));
+        e->last_metric_sec = std::max(e->last_metric_sec, timestamp);
+        logAsset(self, asset_name,
+            "asset: INFO UPDATED name='{}', last_seen={}[s], ttl={}[s], expires_at={}[s], skew={}[s]", asset_name,
+            e->last_time_seen_sec, e->ttl_sec, expiration_get(e), e->skew_sec);
     }
     return 0;
 }
 
+//  ------------------------------------------------------------------------
+//  Set when the asset was last seen and its ttl, as observed by the leader agent
+int data_set_seen(data_t* self, const char* asset_name, uint64_t last_seen_sec, uint64_t ttl_sec)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL)
+        return -1;
+    // the leader knows the ttl, it's not the minimum of the metrics seen here
+    if (ttl_sec != 0)
+        e->ttl_sec = ttl_sec;
+    expiration_update(e, last_seen_sec);
+    return 0;
+}
+
+//  ------------------------------------------------------------------------
+//  Wall clock stepped by 'jump_sec', move the times seen by the assets along
+void data_shift_time(data_t* self, int64_t jump_sec)
+{
+    assert(self);
+    if (jump_sec == 0)
+        return;
+    // deadlines are scheduled again below, shifted or not
+    maintenance_clear_deadlines(self->maintenance);
+    for (void* it = zhashx_first(self->assets); it != NULL; it = zhashx_next(self->assets)) {
+        expiration_t* e = static_cast<expiration_t*>(it);
+        e->last_time_seen_sec    = s_shift_sec(e->last_time_seen_sec, jump_sec);
+        e->flap_stamp_sec        = s_shift_sec(e->flap_stamp_sec, jump_sec);
+        e->announced_sec         = s_shift_sec(e->announced_sec, jump_sec);
+        e->published_sec         = s_shift_sec(e->published_sec, jump_sec);
+        e->added_sec             = s_shift_sec(e->added_sec, jump_sec);
+        e->maintenance_ended_sec = s_shift_sec(e->maintenance_ended_sec, jump_sec);
+        if (e->maintenance_until_sec != 0) {
+            // window ends at the wall time it was scheduled for, maintenance with ttl lasts as long as asked
+            if (!(e->flags & EXPIRATION_FLAG_WINDOW))
+                e->maintenance_until_sec = s_shift_sec(e->maintenance_until_sec, jump_sec);
+            maintenance_schedule(
+                self->maintenance, static_cast<const char*>(zhashx_cursor(self->assets)), e->maintenance_until_sec);
+        }
+        if (e->availability)
+            availability_shift(e->availability, jump_sec);
+        // metrics stamped by our clock after the step backward must not look as duplicates,
+        // stepping forward keeps the times of devices with their own clock
+        if (jump_sec < 0)
+            e->last_metric_sec = s_shift_sec(e->last_metric_sec, jump_sec);
+    }
+}
+
+//  ------------------------------------------------------------------------
+//  Is the asset monitored by the current policy
+bool data_monitored(data_t* self, fty_proto_t* asset)
+{
+    assert(self);
+    assert(asset);
+    return policy_match(self->policy, asset) != NULL;
+}
+
 //  ------------------------------------------------------------------------
 //  put data
 void data_put(data_t* self, fty_proto_t** proto_p)
@@ -191,39 +393,53 @@ void data_put(data_t* self, fty_proto_t** proto_p)
     logDebug("Received asset: name={}, operation={}", asset_name, operation);
 
     // remove asset from cache
-    const char* sub_type = fty_proto_aux_string(proto, FTY_PROTO_ASSET_SUBTYPE, "");
     if (streq(operation, FTY_PROTO_ASSET_OP_DELETE) ||
         streq(fty_proto_aux_string(proto, FTY_PROTO_ASSET_STATUS, ""), "retired") ||
         streq(fty_proto_aux_string(proto, FTY_PROTO_ASSET_STATUS, ""), "nonactive")) {
         data_delete(self, asset_name);
         logDebug("asset: DELETED name={}, operation={}", asset_name, operation);
         fty_proto_destroy(proto_p);
-    } else
-        // other asset operations - add ups, epdu, ats or sensors to the cache if not present
-        // note: filter sts which have no measure (for that test device.type which is empty)
-        if (streq(fty_proto_aux_string(proto, FTY_PROTO_ASSET_TYPE, ""), "device") &&
-            (streq(sub_type, "ups") || streq(sub_type, "epdu") || streq(sub_type, "sensor") ||
-                streq(sub_type, "sensorgpio") ||
-                (streq(sub_type, "sts") && !streq(fty_proto_ext_string(proto, "device.type", ""), "")))) {
+        return;
+    }
+
+    // other asset operations - add assets monitored by the policy to the cache if not present,
+    // tracked assets the policy doesn't monitor any more are dropped
+    const policy_rule_t* rule = policy_match(self->policy, proto);
+    if (rule == NULL) {
+        if (zhashx_lookup(self->assets, asset_name)) {
+            data_delete(self, asset_name);
+            logDebug("asset: UNMONITORED name={}, operation={}", asset_name, operation);
+        }
+        fty_proto_destroy(proto_p);
+        return;
+    }
 
-        zhashx_update(self->asset_enames, asset_name, strdup(fty_proto_ext_string(proto, "name", "")));
+    zhashx_update(self->asset_enames, asset_name, strdup(fty_proto_ext_string(proto, "name", "")));
 
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL) {
         // this asset is not known yet -> add it to the cache
-        expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
-        if (e == NULL) {
-            e = expiration_new(self->default_expiry_sec, proto_p);
-
-            uint64_t now_sec = uint64_t(zclock_time() / 1000);
-            expiration_update(e, now_sec);
-            logDebug("asset: ADDED name='{}', last_seen={}[s], ttl={}[s], expires_at={}[s]", asset_name,
-                e->last_time_seen_sec, e->ttl_sec, expiration_get(e));
-            zhashx_update(self->assets, asset_name, e);
-        } else {
-            fty_proto_destroy(proto_p);
-            // intentionally left empty
-            // So, if we already knew this asset -> nothing to do
+        e = expiration_new(rule->ttl_sec != 0 ? rule->ttl_sec : self->default_expiry_sec, proto_p);
+
+        uint64_t now_sec = vclock_time_sec(self->clock);
+        expiration_update(e, now_sec);
+        e->added_sec      = now_sec;
+        e->multiplier     = rule->multiplier;
+        e->reannounce_sec = rule->reannounce_sec;
+        // asset appearing during a scheduled window joins it
+        uint64_t until_sec = maintenance_window_end(self->maintenance, asset_name, now_sec);
+        if (until_sec != 0) {
+            e->maintenance_until_sec = until_sec;
+            e->flags |= EXPIRATION_FLAG_WINDOW;
+            maintenance_schedule(self->maintenance, asset_name, until_sec);
         }
+        logDebug("asset: ADDED name='{}', last_seen={}[s], ttl={}[s], expires_at={}[s]", asset_name,
+            e->last_time_seen_sec, e->ttl_sec, expiration_get(e));
+        zhashx_update(self->assets, asset_name, e);
+        stats_inc(self->stats, STATS_ASSETS_ADDED);
     } else {
+        // So, if we already knew this asset -> only follow the policy
+        s_data_follow_rule(e, rule);
         fty_proto_destroy(proto_p);
     }
 }
@@ -235,7 +451,10 @@ void data_delete(data_t* self, const char* source)
     assert(self);
     assert(source);
 
-    zhashx_delete(self->assets, source);
+    if (zhashx_lookup(self->assets, source)) {
+        zhashx_delete(self->assets, source);
+        stats_inc(self->stats, STATS_ASSETS_DELETED);
+    }
 }
 
 // --------------------------------------------------------------------------
@@ -262,14 +481,17 @@ std::vector<std::string> data_get_dead(data_t* self)
 
     std::vector<std::string> dead;
 
-    uint64_t now_sec = uint64_t(zclock_time() / 1000);
+    uint64_t now_sec = vclock_time_sec(self->clock);
     logDebug("now={}s", now_sec);
     for (auto it = zhashx_first(self->assets); it != nullptr; it = zhashx_next(self->assets)) {
-        auto e = static_cast<expiration_t*>(it);
+        auto        e          = static_cast<expiration_t*>(it);
+        const char* asset_name = static_cast<const char*>(zhashx_cursor(self->assets));
 
-        std::string asset_name = static_cast<const char*>(zhashx_cursor(self->assets));
+        logAsset(self, asset_name, "asset: name={}, ttl={}, expires_at={}", asset_name, e->ttl_sec,
+            expiration_get(e));
 
-        logDebug("asset: name={}, ttl={}, expires_at={}", asset_name, e->ttl_sec, expiration_get(e));
+        if (e->maintenance_until_sec != 0)
+            continue;
 
         if (expiration_get(e) <= now_sec) {
             dead.emplace_back(asset_name);
@@ -278,3 +500,377 @@ std::vector<std::string> data_get_dead(data_t* self)
 
     return dead;
 }
+
+// --------------------------------------------------------------------------
+// put asset into maintenance until until_sec
+int data_maintenance_enable(data_t* self, const char* asset_name, uint64_t until_sec)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL)
+        return -1;
+
+    e->maintenance_until_sec = until_sec;
+    e->flags &= uint8_t(~EXPIRATION_FLAG_WINDOW);
+    maintenance_schedule(self->maintenance, asset_name, until_sec);
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// maintenance of the asset ended at 'now_sec', asset quiet meanwhile (e.g. being upgraded) gets a whole
+// ttl to communicate again before it expires
+static void s_data_maintenance_end(expiration_t* e, uint64_t now_sec)
+{
+    e->maintenance_until_sec = 0;
+    e->maintenance_ended_sec = now_sec;
+    e->flags &= uint8_t(~EXPIRATION_FLAG_WINDOW);
+    expiration_update(e, now_sec);
+}
+
+// --------------------------------------------------------------------------
+// return asset from maintenance, its stale deadline is dropped when due
+int data_maintenance_disable(data_t* self, const char* asset_name)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL)
+        return -1;
+
+    if (e->maintenance_until_sec != 0)
+        s_data_maintenance_end(e, vclock_time_sec(self->clock));
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// is the asset in maintenance
+bool data_in_maintenance(data_t* self, const char* asset_name)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    return e != NULL && e->maintenance_until_sec != 0;
+}
+
+// --------------------------------------------------------------------------
+// start maintenance windows due at now_sec
+std::vector<std::string> data_maintenance_windows(data_t* self, uint64_t now_sec)
+{
+    assert(self);
+
+    std::vector<std::string> entered;
+
+    uint64_t                    end_sec;
+    const maintenance_window_t* window;
+    while ((window = maintenance_pop_window(self->maintenance, now_sec, &end_sec)) != NULL) {
+        logInfo("maintenance: window '{}' started, ends at {}", window->name, end_sec);
+        for (auto it = zhashx_first(self->assets); it != nullptr; it = zhashx_next(self->assets)) {
+            auto        e          = static_cast<expiration_t*>(it);
+            const char* asset_name = static_cast<const char*>(zhashx_cursor(self->assets));
+            if (e->maintenance_until_sec < end_sec && std::regex_match(asset_name, *window->assets)) {
+                if (e->maintenance_until_sec == 0)
+                    entered.emplace_back(asset_name);
+                e->maintenance_until_sec = end_sec;
+                e->flags |= EXPIRATION_FLAG_WINDOW;
+                maintenance_schedule(self->maintenance, asset_name, end_sec);
+            }
+        }
+    }
+
+    return entered;
+}
+
+// --------------------------------------------------------------------------
+// process maintenance deadlines due at now_sec
+std::vector<std::string> data_maintenance_expire(data_t* self, uint64_t now_sec)
+{
+    assert(self);
+
+    std::vector<std::string> expired;
+
+    // deadline is stale when asset was deleted, returned from maintenance or its maintenance prolonged
+    maintenance_deadline_t deadline;
+    while (maintenance_pop_deadline(self->maintenance, now_sec, deadline)) {
+        expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, deadline.asset.c_str()));
+        if (e == NULL || e->maintenance_until_sec != deadline.at_sec)
+            continue;
+        s_data_maintenance_end(e, now_sec);
+        expired.push_back(deadline.asset);
+    }
+
+    return expired;
+}
+
+// --------------------------------------------------------------------------
+// load maintenance windows from configuration
+int data_load_maintenance_windows(data_t* self, zconfig_t* config, uint64_t now_sec)
+{
+    assert(self);
+    return maintenance_load(self->maintenance, config, now_sec);
+}
+
+// --------------------------------------------------------------------------
+// select known assets in one pass
+int data_select(data_t* self, const char* selector, const char* value, std::vector<std::string>& selected)
+{
+    assert(self);
+    assert(selector);
+    assert(value);
+
+    enum
+    {
+        SUBTYPE,
+        NAME,
+        PARENT
+    } by;
+    std::regex pattern;
+    if (streq(selector, "subtype"))
+        by = SUBTYPE;
+    else if (streq(selector, "parent"))
+        by = PARENT;
+    else if (streq(selector, "name")) {
+        by = NAME;
+        try {
+            pattern = std::regex(value, std::regex::optimize);
+        } catch (const std::regex_error& e) {
+            logError("data: invalid name pattern '{}': {}", value, e.what());
+            return -1;
+        }
+    } else
+        return -1;
+
+    for (auto it = zhashx_first(self->assets); it != nullptr; it = zhashx_next(self->assets)) {
+        auto        e          = static_cast<expiration_t*>(it);
+        const char* asset_name = static_cast<const char*>(zhashx_cursor(self->assets));
+
+        bool match = false;
+        switch (by) {
+            case SUBTYPE:
+                match = streq(fty_proto_aux_string(e->msg, FTY_PROTO_ASSET_SUBTYPE, ""), value);
+                break;
+            case NAME:
+                match = std::regex_match(asset_name, pattern);
+                break;
+            case PARENT:
+                match = streq(fty_proto_aux_string(e->msg, ASSET_PARENT_NAME,
+                                  fty_proto_ext_string(e->msg, ASSET_PARENT_NAME, "")),
+                    value);
+                break;
+        }
+        if (match)
+            selected.emplace_back(asset_name);
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// status of an asset
+static void s_status(expiration_t* e, const char* asset_name, uint64_t now_sec, asset_status_t& status)
+{
+    status.name                  = asset_name;
+    status.last_seen_sec         = e->last_time_seen_sec;
+    status.expires_at_sec        = expiration_get(e);
+    status.maintenance_until_sec = e->maintenance_until_sec;
+    status.flags                 = e->flags;
+    status.dead                  = e->maintenance_until_sec == 0 && status.expires_at_sec <= now_sec;
+    status.alert                 = false;
+}
+
+// --------------------------------------------------------------------------
+// get status of the asset
+int data_get_status(data_t* self, const char* asset_name, uint64_t now_sec, asset_status_t& status)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL)
+        return -1;
+    s_status(e, asset_name, now_sec, status);
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// get status of all the assets, sorted by name
+std::vector<asset_status_t> data_snapshot(data_t* self, uint64_t now_sec)
+{
+    assert(self);
+
+    std::vector<asset_status_t> snapshot(zhashx_size(self->assets));
+
+    size_t i = 0;
+    for (auto it = zhashx_first(self->assets); it != nullptr; it = zhashx_next(self->assets)) {
+        s_status(static_cast<expiration_t*>(it), static_cast<const char*>(zhashx_cursor(self->assets)), now_sec,
+            snapshot[i++]);
+    }
+
+    std::sort(snapshot.begin(), snapshot.end(), [](const asset_status_t& a, const asset_status_t& b) {
+        return a.name < b.name;
+    });
+    return snapshot;
+}
+
+// --------------------------------------------------------------------------
+// get status of the assets whose state changed or which must be refreshed
+std::vector<asset_status_t> data_status_changes(data_t* self, uint64_t now_sec, uint64_t refresh_sec)
+{
+    assert(self);
+
+    std::vector<asset_status_t> changes;
+
+    for (auto it = zhashx_first(self->assets); it != nullptr; it = zhashx_next(self->assets)) {
+        auto e = static_cast<expiration_t*>(it);
+
+        uint8_t state = ASSET_STATE_ALIVE;
+        if (e->maintenance_until_sec != 0)
+            state = ASSET_STATE_MAINTENANCE;
+        else if (expiration_get(e) <= now_sec)
+            state = ASSET_STATE_DEAD;
+
+        // last seen time published more than one ttl ago is refreshed too
+        if (state == e->published_state && now_sec < e->published_sec + refresh_sec &&
+            e->last_time_seen_sec < e->published_sec + e->ttl_sec)
+            continue;
+
+        e->published_state = state;
+        e->published_sec   = now_sec;
+        changes.emplace_back();
+        s_status(e, static_cast<const char*>(zhashx_cursor(self->assets)), now_sec, changes.back());
+    }
+
+    return changes;
+}
+
+// --------------------------------------------------------------------------
+// record observed liveness of an asset
+// return true, if asset is flapping and the change must not be published
+bool data_flap_observe(data_t* self, const char* asset_name, bool down, uint64_t now_sec)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL)
+        return false;
+
+    bool was_down = (e->flags & EXPIRATION_FLAG_DOWN) != 0;
+    if (was_down == down)
+        return (e->flags & EXPIRATION_FLAG_FLAPPING) != 0;
+
+    if (down)
+        e->flags |= EXPIRATION_FLAG_DOWN;
+    else
+        e->flags &= uint8_t(~EXPIRATION_FLAG_DOWN);
+
+    if (self->flap_suppress == 0)
+        return false;
+
+    expiration_flap_decay(e, self->flap_half_life_sec, now_sec);
+    // only outages are penalized, recovery itself is not a flap
+    if (down) {
+        uint64_t penalty = uint64_t(e->flap_penalty) + FLAP_PENALTY;
+        uint64_t ceiling = uint64_t(self->flap_suppress) * FLAP_PENALTY_CEILING_FACTOR;
+        e->flap_penalty  = uint32_t(penalty > ceiling ? ceiling : penalty);
+    }
+
+    if (!(e->flags & EXPIRATION_FLAG_FLAPPING) && e->flap_penalty >= self->flap_suppress) {
+        e->flags |= EXPIRATION_FLAG_FLAPPING;
+        logWarn("asset: FLAPPING name='{}', penalty={}", asset_name, e->flap_penalty);
+    }
+    return (e->flags & EXPIRATION_FLAG_FLAPPING) != 0;
+}
+
+// --------------------------------------------------------------------------
+// decay flap penalties, returns list of assets which stopped flapping
+std::vector<std::string> data_flap_settle(data_t* self, uint64_t now_sec)
+{
+    assert(self);
+
+    std::vector<std::string> settled;
+
+    for (auto it = zhashx_first(self->assets); it != nullptr; it = zhashx_next(self->assets)) {
+        auto e = static_cast<expiration_t*>(it);
+        if (!(e->flags & EXPIRATION_FLAG_FLAPPING))
+            continue;
+
+        expiration_flap_decay(e, self->flap_half_life_sec, now_sec);
+        if (e->flap_penalty < self->flap_reuse || self->flap_suppress == 0) {
+            e->flags &= uint8_t(~EXPIRATION_FLAG_FLAPPING);
+            settled.emplace_back(static_cast<const char*>(zhashx_cursor(self->assets)));
+            logInfo("asset: STABLE name='{}', penalty={}", settled.back(), e->flap_penalty);
+        }
+    }
+
+    return settled;
+}
+
+// --------------------------------------------------------------------------
+// get flapping devices
+std::vector<std::string> data_get_flapping(data_t* self)
+{
+    assert(self);
+
+    std::vector<std::string> flapping;
+
+    for (auto it = zhashx_first(self->assets); it != nullptr; it = zhashx_next(self->assets)) {
+        if (static_cast<expiration_t*>(it)->flags & EXPIRATION_FLAG_FLAPPING)
+            flapping.emplace_back(static_cast<const char*>(zhashx_cursor(self->assets)));
+    }
+
+    return flapping;
+}
+
+// --------------------------------------------------------------------------
+// outage of the asset started
+void data_availability_down(data_t* self, const char* asset_name, uint64_t start_sec, uint64_t now_sec)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL)
+        return;
+    if (e->availability == NULL)
+        e->availability = availability_new(e->added_sec != 0 ? e->added_sec : now_sec);
+    if (e->availability)
+        availability_down(e->availability, start_sec, now_sec);
+}
+
+// --------------------------------------------------------------------------
+// outage of the asset ended
+void data_availability_up(data_t* self, const char* asset_name, uint64_t end_sec, uint64_t now_sec)
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e && e->availability)
+        availability_up(e->availability, end_sec, now_sec);
+}
+
+// --------------------------------------------------------------------------
+// get availability of the asset over each window
+int data_get_availability(
+    data_t* self, const char* asset_name, uint64_t now_sec, availability_report_t reports[AVAILABILITY_WINDOWS])
+{
+    assert(self);
+    assert(asset_name);
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets, asset_name));
+    if (e == NULL)
+        return -1;
+    // asset which was never down has no buckets yet
+    availability_t  idle;
+    availability_t* availability = e->availability;
+    if (availability == NULL) {
+        availability_init(&idle, e->added_sec != 0 ? e->added_sec : now_sec);
+        availability = &idle;
+    }
+    for (int w = 0; w < AVAILABILITY_WINDOWS; w++)
+        reports[w] = availability_get(availability, w, now_sec);
+    return 0;
+}
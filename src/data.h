@@ -21,7 +21,13 @@
 
 #pragma once
 
+#include "availability.h"
 #include "fty-outage.h"
+#include "hotlog.h"
+#include "maintenance.h"
+#include "policy.h"
+#include "stats.h"
+#include "vclock.h"
 #include <czmq.h>
 #include <fty_proto.h>
 #include <string>
@@ -31,16 +37,69 @@
 /// so if we here would have 15 minutes-> the first alert will come in 30 minutes
 #define DEFAULT_ASSET_EXPIRATION_TIME_SEC 15 * 60 / 2
 
+/// flap damping (same idea as BGP route damping): every observed outage adds
+/// FLAP_PENALTY to the asset penalty, which decays with half-life. Once the penalty
+/// reaches the suppress limit, the asset is flapping and its alert is held ACTIVE
+/// until the penalty decays under the reuse limit.
+#define FLAP_PENALTY                  1000
+#define DEFAULT_FLAP_HALF_LIFE_SEC    900
+#define DEFAULT_FLAP_SUPPRESS_LIMIT   2500
+#define DEFAULT_FLAP_REUSE_LIMIT      750
+#define FLAP_PENALTY_CEILING_FACTOR   4 // penalty is capped to suppress limit * factor
+
+/// clock of a device may run ahead of ours, its metrics are accepted up to this lead and
+/// are applied at their time corrected by the estimated skew, never later than now
+#define DEFAULT_MAX_CLOCK_SKEW_SEC 60
+#define SKEW_WEIGHT                8 // skew estimate moves by 1/weight of the difference
+
+/// wall clock steps of at least this are shifted out of the expiration times
+#define CLOCK_JUMP_THRESHOLD_MS 5000
+
+/// name of the parent device in asset message
+#define ASSET_PARENT_NAME "parent_name.1"
+
+/// published asset states
+#define ASSET_STATE_UNKNOWN     0
+#define ASSET_STATE_ALIVE       1
+#define ASSET_STATE_DEAD        2
+#define ASSET_STATE_MAINTENANCE 3
+
+/// expiration_t flags
+#define EXPIRATION_FLAG_DOWN     0x01 //!< asset was last seen as not communicating
+#define EXPIRATION_FLAG_FLAPPING 0x02 //!< asset is flapping, transitions are damped
+#define EXPIRATION_FLAG_WINDOW   0x04 //!< maintenance comes from a scheduled window, it ends on wall time
+
 ///  Structure of our class
 struct _data_t
 {
-    zhashx_t* assets;             //!< asset_name => expiration time [s]
-    zhashx_t* asset_enames;       //!< asset iname => asset ename (unicode name)
-    uint64_t  default_expiry_sec; //!< default time for the asset, in what asset would be considered as not responding
+    zhashx_t*      assets;             //!< asset_name => expiration time [s]
+    zhashx_t*      asset_enames;       //!< asset iname => asset ename (unicode name)
+    uint64_t       default_expiry_sec; //!< ttl of assets whose rule has none
+    uint32_t       flap_half_life_sec; //!< half-life of flap penalty
+    uint32_t       flap_suppress;      //!< penalty from which asset is flapping (0 disables damping)
+    uint32_t       flap_reuse;         //!< penalty under which asset stops flapping
+    uint32_t       max_skew_sec;       //!< metrics up to this far in the future are accepted (0 rejects all)
+    policy_t*      policy;             //!< which assets are monitored and how
+    maintenance_t* maintenance;        //!< maintenance deadlines and windows
+    stats_t*       stats;              //!< runtime statistics, shared with the server
+    vclock_t*      clock;              //!< source of time, shared with the server
+    zhashx_t*      debug_assets;       //!< assets whose hot path is logged on info level
 };
 
 typedef struct _data_t data_t;
 
+///  Status of one asset, as reported to the clients
+typedef struct _asset_status_t
+{
+    std::string name;                  //!< asset name
+    uint64_t    last_seen_sec;         //!< time when some metrics were seen for this asset
+    uint64_t    expires_at_sec;        //!< time when the asset is considered as not responding
+    uint64_t    maintenance_until_sec; //!< end of maintenance, 0 when asset is not in maintenance
+    uint8_t     flags;                 //!< EXPIRATION_FLAG_* bits
+    bool        dead;                  //!< asset is not responding (and not in maintenance)
+    bool        alert;                 //!< outage alert is active (filled in by the server)
+} asset_status_t;
+
 ///  Create a new data
 data_t* data_new(void);
 
@@ -56,29 +115,145 @@ uint64_t data_default_expiry(data_t* self);
 ///  Set default number of seconds in that newly added asset would expire
 void data_set_default_expiry(data_t* self, uint64_t expiry_sec);
 
+///  Switch logging of the hot path (logAsset) of the asset on info level
+void data_set_debug_asset(data_t* self, const char* asset_name, bool enable);
+
+///  Is hot path of the asset logged, cheap when no asset is
+inline bool data_debug_asset(data_t* self, const char* asset_name)
+{
+    return zhashx_size(self->debug_assets) != 0 && zhashx_lookup(self->debug_assets, asset_name) != NULL;
+}
+
+///  Set monitoring policy, takes ownership of the policy
+void data_set_policy(data_t* self, policy_t** policy_p);
+
+///  Apply the current policy to the tracked assets (ttl only when the rule lowers it), returns assets which
+///  are not monitored any more, they are still in the cache
+std::vector<std::string> data_follow_policy(data_t* self);
+
+///  Is the asset monitored by the current policy
+bool data_monitored(data_t* self, fty_proto_t* asset);
+
 ///  calculates metric expiration time for each asset  takes owneship of the message
+///  tracked asset which the policy doesn't monitor any more is deleted, one which it still monitors
+///  gets the multiplier and re-announce interval of its rule, and its ttl if it is lower
 void data_put(data_t* self, fty_proto_t** proto);
 
 ///  delete from cache
 void data_delete(data_t* self, const char* source);
 
-///  Returns list of nonresponding devices, zlistx entries are refereces
+///  Returns list of nonresponding devices, assets in maintenance are skipped
 std::vector<std::string> data_get_dead(data_t* self);
 
 ///  update information about expiration time
-///  return -1, if data are from future and are ignored as damaging
+///  return -1, if data are further in the future than max_skew_sec and are ignored as damaging
+///  return 1, if metric from 'timestamp' or later with the same or shorter ttl was already applied
 ///  return 0 otherwise
 int data_touch_asset(data_t* self, const char* asset_name, uint64_t timestamp, uint64_t ttl, uint64_t now_sec);
 
+///  Put asset into maintenance until until_sec
+///  return -1, if asset is not known
+///  return 0 otherwise
+int data_maintenance_enable(data_t* self, const char* asset_name, uint64_t until_sec);
+
+///  Return asset from maintenance
+///  return -1, if asset is not known
+///  return 0 otherwise
+int data_maintenance_disable(data_t* self, const char* asset_name);
+
+///  Is the asset in maintenance
+bool data_in_maintenance(data_t* self, const char* asset_name);
+
+///  Start maintenance windows due at now_sec, returns list of assets which entered maintenance
+std::vector<std::string> data_maintenance_windows(data_t* self, uint64_t now_sec);
+
+///  Process maintenance deadlines due at now_sec, returns list of assets which left maintenance
+std::vector<std::string> data_maintenance_expire(data_t* self, uint64_t now_sec);
+
+///  Load maintenance windows from configuration, return -1 on error
+int data_load_maintenance_windows(data_t* self, zconfig_t* config, uint64_t now_sec);
+
+///  Select known assets by 'subtype', 'name' (regex) or 'parent' (name of parent device)
+///  return -1, if selector is unknown or invalid
+///  return 0 otherwise
+int data_select(data_t* self, const char* selector, const char* value, std::vector<std::string>& selected);
+
+///  Get status of the asset
+///  return -1, if asset is not known
+///  return 0 otherwise
+int data_get_status(data_t* self, const char* asset_name, uint64_t now_sec, asset_status_t& status);
+
+///  Get status of all the assets, sorted by name
+std::vector<asset_status_t> data_snapshot(data_t* self, uint64_t now_sec);
+
+///  Get status of the assets whose state changed since last call, which were seen more than their ttl
+///  after they were published, or which were published more than refresh_sec ago. The assets are marked
+///  as published at now_sec.
+std::vector<asset_status_t> data_status_changes(data_t* self, uint64_t now_sec, uint64_t refresh_sec);
+
+///  Set flap damping parameters, suppress_limit == 0 disables damping
+void data_set_flap_damping(data_t* self, uint32_t half_life_sec, uint32_t suppress_limit, uint32_t reuse_limit);
+
+///  Set how far in the future metrics of devices with clock ahead are accepted, 0 rejects all of them
+void data_set_max_skew(data_t* self, uint32_t max_skew_sec);
+
+///  Wall clock stepped by 'jump_sec' (negative when backward), move the times seen by the assets along,
+///  so the step neither expires them nor keeps them alive. Maintenance with a TTL keeps its remaining
+///  duration and availability is not charged the step, maintenance of scheduled windows stays on wall time.
+void data_shift_time(data_t* self, int64_t jump_sec);
+
+///  Set when the asset was last seen and its ttl, as observed by the leader agent
+///  return -1, if asset is not known
+///  return 0 otherwise
+int data_set_seen(data_t* self, const char* asset_name, uint64_t last_seen_sec, uint64_t ttl_sec);
+
+///  Record observed liveness of an asset (down == true when not communicating)
+///  return true, if asset is flapping and the change must not be published
+///  return false otherwise
+bool data_flap_observe(data_t* self, const char* asset_name, bool down, uint64_t now_sec);
+
+///  Decay flap penalties, returns list of assets which stopped flapping, so their
+///  held alert state has to be reconciled with the observed one
+std::vector<std::string> data_flap_settle(data_t* self, uint64_t now_sec);
+
+///  Returns list of flapping assets
+std::vector<std::string> data_get_flapping(data_t* self);
+
+///  Outage of the asset started at 'start_sec', as announced by its ACTIVE alert
+void data_availability_down(data_t* self, const char* asset_name, uint64_t start_sec, uint64_t now_sec);
+
+///  Outage of the asset ended at 'end_sec', as announced by its RESOLVED alert
+void data_availability_up(data_t* self, const char* asset_name, uint64_t end_sec, uint64_t now_sec);
+
+///  Get availability of the asset over each window into 'reports', O(1)
+///  return -1, if asset is not known
+///  return 0 otherwise
+int data_get_availability(
+    data_t* self, const char* asset_name, uint64_t now_sec, availability_report_t reports[AVAILABILITY_WINDOWS]);
+
 ///  Self test of this class
 void data_test(bool verbose);
 
 ///  Structure of our class
 typedef struct _expiration_t
 {
-    uint64_t     ttl_sec;            //!< minimal ttl seen for some asset
-    uint64_t     last_time_seen_sec; //!< time when  some metrics were seen for this asset
-    fty_proto_t* msg;                //!< asset representation
+    uint64_t        ttl_sec;               //!< minimal ttl seen for some asset
+    uint64_t        last_time_seen_sec;    //!< time when  some metrics were seen for this asset
+    uint64_t        last_metric_sec;       //!< time of the last applied metric, older ones are duplicates
+    fty_proto_t*    msg;                   //!< asset representation
+    uint64_t        flap_stamp_sec;        //!< time when flap penalty was last decayed
+    uint64_t        announced_sec;         //!< time when ACTIVE alert was last published
+    uint64_t        maintenance_until_sec; //!< end of maintenance, 0 when asset is not in maintenance
+    uint64_t        maintenance_ended_sec; //!< end of the last maintenance, outage can't start earlier
+    uint64_t        published_sec;         //!< time when status was last published
+    uint64_t        added_sec;             //!< time when the asset started to be tracked
+    availability_t* availability;          //!< outage time over the rolling windows, NULL until the first outage
+    uint32_t        flap_penalty;          //!< flap damping penalty
+    uint32_t        reannounce_sec;        //!< ACTIVE alert re-announce interval, 0 for each dead check
+    uint32_t        skew_sec;              //!< estimated lead of the device clock over ours
+    uint8_t         flags;                 //!< EXPIRATION_FLAG_* bits
+    uint8_t         multiplier;            //!< asset expires when no data came for ttl * multiplier
+    uint8_t         published_state;       //!< ASSET_STATE_* last published, ASSET_STATE_UNKNOWN if never
 } expiration_t;
 
 ///  Create a new expiration
@@ -93,5 +268,11 @@ void expiration_update(expiration_t* self, uint64_t new_time_seen_sec);
 ///  Update the expiration TTL
 void expiration_update_ttl(expiration_t* self, uint64_t proposed_ttl);
 
+///  Update estimated lead of the device clock by metric with 'timestamp' received at 'now_sec'
+void expiration_skew(expiration_t* self, uint64_t timestamp, uint64_t now_sec);
+
 ///  Get the expiration TTL
 uint64_t expiration_get(expiration_t* self);
+
+///  Decay flap penalty up to now_sec
+void expiration_flap_decay(expiration_t* self, uint32_t half_life_sec, uint64_t now_sec);
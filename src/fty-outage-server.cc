@@ -24,115 +24,287 @@
 #include "fty-outage.h"
 #include "fty_common_macros.h"
 #include "osrv.h"
+#include "shmreader.h"
+#include <algorithm>
 #include <fty_log.h>
+#include <initializer_list>
 #include <fty_shm.h>
 #include <malamute.h>
 
 #define SAVE_INTERVAL_MS 45 * 60 * 1000 // store state each 45 minutes
 
-// publish 'outage' alert for asset 'source-asset' in state 'alert-state'
-static void s_osrv_send_alert(s_osrv_t* self, const char* source_asset, const char* alert_state)
+// per-asset status in fty_shm, consumers can read it without asking the agent
+#define SHM_STATUS_PREFIX           "outage."
+#define SHM_STATUS_TTL_SEC          10 * 60
+#define SHM_STATUS_REFRESH_SEC      SHM_STATUS_TTL_SEC / 2 // unchanged status is rewritten before it expires
+#define SHM_STATUS_WITHDRAW_TTL_SEC 1                      // status of assets no longer tracked expires at once
+
+// statistics of the agent itself in fty_shm
+#define STATS_SHM_ASSET  "fty-outage"
+#define STATS_SHM_PREFIX "outage.stats."
+
+// the agent is behind, if the freshest metric of a check period is older than the lag threshold,
+// it catches up once the freshest metric is newer than half of the threshold
+#define PROTECTIVE_MAX_MS 10 * 60 * 1000 // dead checks are not deferred for longer
+
+#define LIST_DEFAULT_LIMIT 100  // assets in one LIST reply, if not specified otherwise
+#define LIST_MAX_LIMIT     1000 // max assets in one LIST reply
+
+// record time from 'since_ms' to 'now_ms' into 'histogram' and into the trace file as 'event' of 'source'
+static void s_osrv_latency(s_osrv_t* self, stats_histogram_t histogram, const char* event, const char* source,
+    int64_t since_ms, int64_t now_ms)
+{
+    int64_t latency_ms = std::max(now_ms - since_ms, int64_t(0));
+    histogram_record(stats_histogram(self->assets->stats, histogram), uint64_t(latency_ms) * 1000);
+    if (self->trace)
+        fprintf(self->trace, "%lld %s %s %lld %lld\n", static_cast<long long>(now_ms), event, source,
+            static_cast<long long>(since_ms), static_cast<long long>(latency_ms));
+}
+
+// publish alert of 'rule' for asset 'source-asset' in state 'alert-state'
+// 'since_sec' is time of the outage (ACTIVE) or recovery (RESOLVED) the alert announces,
+// 0 when the alert is not announcing a change seen on the device
+static void s_osrv_publish_alert(s_osrv_t* self, const char* rule, const char* source_asset,
+    const char* alert_state, const char* description, uint64_t since_sec)
 {
     assert(self);
+    assert(rule);
     assert(source_asset);
     assert(alert_state);
 
-    zlist_t* actions = zlist_new();
-    // FIXME: should be a configurable Settings->Alert!!!
-    zlist_append(actions, const_cast<char*>("EMAIL"));
-    zlist_append(actions, const_cast<char*>("SMS"));
-    char*       rule_name = zsys_sprintf("%s@%s", "outage", source_asset);
-    std::string description =
-        TRANSLATE_ME("Device %s does not provide expected data. It may be offline or not correctly configured.",
-            data_get_asset_ename(self->assets, source_asset));
-    zmsg_t* msg     = fty_proto_encode_alert(NULL, // aux
-        uint64_t(zclock_time() / 1000),        // unix time (sec.)
+    // fty_proto and malamute strings are at most 255 characters long
+    char rule_name[256];
+    char subject[256];
+    snprintf(rule_name, sizeof(rule_name), "%s@%s", rule, source_asset);
+    zmsg_t* msg = fty_proto_encode_alert(NULL, // aux
+        vclock_time_sec(self->assets->clock),  // unix time (sec.)
         uint32_t(self->timeout_ms * 3 / 1000), // ttl (sec.)
         rule_name,                             // rule_name
-        source_asset, alert_state, "CRITICAL", description.c_str(), actions);
-    char*   subject = zsys_sprintf("%s/%s@%s", "outage", "CRITICAL", source_asset);
+        source_asset, alert_state, "CRITICAL", description, self->alert_actions);
+    snprintf(subject, sizeof(subject), "%s/%s@%s", rule, "CRITICAL", source_asset);
     logDebug("Alert '{}' is '{}'", subject, alert_state);
     int rv = mlm_client_send(self->client, subject, &msg);
     if (rv != 0)
         logError("Cannot send alert on '{}' (mlm_client_send)", source_asset);
-    zlist_destroy(&actions);
-    zstr_free(&subject);
-    zstr_free(&rule_name);
+    else {
+        bool active = streq(alert_state, "ACTIVE");
+        stats_inc(self->assets->stats, active ? STATS_ALERTS_ACTIVE : STATS_ALERTS_RESOLVED);
+        if (since_sec != 0)
+            s_osrv_latency(self, active ? STATS_LATENCY_OUTAGE_DETECTION : STATS_LATENCY_RECOVERY_DETECTION,
+                alert_state, source_asset, int64_t(since_sec) * 1000, vclock_time(self->assets->clock));
+    }
+}
+
+// publish 'outage' alert for asset 'source-asset' in state 'alert-state'
+static void s_osrv_send_alert(s_osrv_t* self, const char* source_asset, const char* alert_state, uint64_t since_sec)
+{
+    std::string description =
+        TRANSLATE_ME("Device %s does not provide expected data. It may be offline or not correctly configured.",
+            data_get_asset_ename(self->assets, source_asset));
+    s_osrv_publish_alert(self, "outage", source_asset, alert_state, description.c_str(), since_sec);
+}
+
+// publish summary alert of the wave in state 'alert-state', it names the likely common cause
+static void s_osrv_send_wave_alert(s_osrv_t* self, const wave_running_t& wave, const char* alert_state)
+{
+    std::string description;
+    if (wave.cause == WAVE_PARENT)
+        description = TRANSLATE_ME("All %zu devices of %s stopped communicating at once. The device or its "
+                                   "connection is likely down.",
+            wave.monitored, data_get_asset_ename(self->assets, wave.origin.c_str()));
+    else if (wave.cause == WAVE_SOURCE)
+        description = TRANSLATE_ME("%zu of %zu devices stopped communicating at once and no data were received. "
+                                   "The source of the data (fty_shm writer or malamute broker) is likely down.",
+            wave.assets, wave.monitored);
+    else
+        description = TRANSLATE_ME("%zu of %zu devices stopped communicating at once while other devices still "
+                                   "communicate. A network segment is likely down.",
+            wave.assets, wave.monitored);
+    const char* source_asset = wave.origin.empty() ? STATS_SHM_ASSET : wave.origin.c_str();
+    s_osrv_publish_alert(self, "outage-wave", source_asset, alert_state, description.c_str(), 0);
+}
+
+// send change of the state to the standby agent, when the agent is the leader, destroys the message
+static void s_osrv_replicate_msg(s_osrv_t* self, zmsg_t** msg_p)
+{
+    if (self->replica_role == OSRV_REPLICA_LEADER && *msg_p) {
+        zmsg_pushstr(*msg_p, "PUBLISH");
+        zmsg_send(msg_p, self->replica);
+        stats_inc(self->assets->stats, STATS_REPLICA_SENT);
+    }
+    zmsg_destroy(msg_p);
+}
+
+// send change of the state made of 'frames' to the standby agent
+static void s_osrv_replicate(s_osrv_t* self, std::initializer_list<std::string> frames)
+{
+    if (self->replica_role != OSRV_REPLICA_LEADER)
+        return;
+    zmsg_t* msg = zmsg_new();
+    for (const auto& frame : frames)
+        zmsg_addstr(msg, frame.c_str());
+    s_osrv_replicate_msg(self, &msg);
 }
 
 // if for asset 'source-asset' the 'outage' alert is tracked
 // * publish alert in RESOLVE state for asset 'source-asset'
 // * removes alert from the list of the active alerts
-static void s_osrv_resolve_alert(s_osrv_t* self, const char* source_asset)
+// * ends the outage in the history for 'cause'
+// 'recovered_sec' is time of the metric showing the asset is back, 0 if alert is resolved for other reason
+static void s_osrv_resolve_alert(
+    s_osrv_t* self, const char* source_asset, history_cause_t cause, uint64_t recovered_sec = 0)
 {
     assert(self);
     assert(source_asset);
 
+    // alerts of the standby are resolved by the leader
+    if (self->replica_role == OSRV_REPLICA_STANDBY)
+        return;
+
     if (zhash_lookup(self->active_alerts, source_asset)) {
         logInfo("\t\tsend RESOLVED alert for source={}", source_asset);
-        s_osrv_send_alert(self, source_asset, "RESOLVED");
+        s_osrv_send_alert(self, source_asset, "RESOLVED", recovered_sec);
         zhash_delete(self->active_alerts, source_asset);
+        uint64_t now_sec = vclock_time_sec(self->assets->clock);
+        uint64_t end_sec = recovered_sec != 0 ? recovered_sec : now_sec;
+        data_availability_up(self->assets, source_asset, end_sec, now_sec);
+        if (self->history)
+            history_end(self->history, source_asset, int64_t(end_sec), cause);
+        s_osrv_replicate(
+            self, {"ALERT", source_asset, "RESOLVED", std::to_string(end_sec), std::to_string(int(cause))});
+    }
+}
+
+// asset 'source-asset' provided data at 'timestamp', so its 'outage' alert can be resolved
+// unless the asset is flapping, then the alert is held until it is stable again
+// 'applied' tells the data updated the expiration, only then the asset is observed as up by flap damping
+static void s_osrv_asset_alive(s_osrv_t* self, const char* source_asset, uint64_t timestamp, bool applied)
+{
+    assert(self);
+    assert(source_asset);
+
+    uint64_t      now_sec  = vclock_time_sec(self->assets->clock);
+    expiration_t* e        = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets->assets, source_asset));
+    bool          flapping = applied ? data_flap_observe(self->assets, source_asset, false, now_sec)
+                                     : e && (e->flags & EXPIRATION_FLAG_FLAPPING);
+    if (flapping) {
+        logAsset(self->assets, source_asset, "\t\tasset {} is flapping, keep its alert state", source_asset);
+        return;
     }
+    s_osrv_resolve_alert(self, source_asset, HISTORY_RECOVERED, timestamp);
+}
+
+// asset 'source-asset' provided metric with 'timestamp' and 'ttl', update its expiration
+// return 1, if the metric was already applied (see data_touch_asset)
+static int s_osrv_touch_asset(s_osrv_t* self, const char* source_asset, uint64_t timestamp, uint64_t ttl)
+{
+    int64_t now_ms = vclock_time(self->assets->clock);
+    int     rv     = data_touch_asset(self->assets, source_asset, timestamp, ttl, uint64_t(now_ms / 1000));
+    if (rv == -1)
+        logLimited(logError, "asset: name = {}, time={} metric is from future! ignore it", source_asset, timestamp);
+    else if (rv == 0 && zhashx_lookup(self->assets->assets, source_asset)) {
+        // age of metrics of the tracked assets only, metrics are too many for the trace file
+        int64_t age_ms = std::max(now_ms - int64_t(timestamp) * 1000, int64_t(0));
+        histogram_record(stats_histogram(self->assets->stats, STATS_LATENCY_METRIC_AGE), uint64_t(age_ms) * 1000);
+        // the standby gets the touched assets summarized at the next sync
+        if (self->replica_role == OSRV_REPLICA_LEADER)
+            zhashx_update(self->replica_seen, source_asset, TRUE);
+    }
+    return rv;
+}
+
+// fields of 'metric' which keep its asset alive, pointing into 'metric'
+static osrv_metric_t s_osrv_metric(fty_proto_t* metric)
+{
+    return {fty_proto_name(metric), fty_proto_time(metric), fty_proto_ttl(metric),
+        fty_proto_aux_string(metric, FTY_PROTO_METRICS_SENSOR_AUX_PORT, NULL),
+        fty_proto_aux_string(metric, FTY_PROTO_METRICS_SENSOR_AUX_SNAME, NULL), fty_proto_operation(metric),
+        fty_proto_aux_string(metric, "x-cm-count", NULL) != NULL};
+}
+
+// 'metric' received from 'origin' (OSRV_LIVENESS_SHM or OSRV_LIVENESS_STREAM) is a sign of life of its asset,
+// or of the sensor attached to it, if the origin is selected as liveness source
+// 'sensor_stream' is set for metrics from _METRICS_SENSOR stream
+static void s_osrv_ingest_metric(s_osrv_t* self, const osrv_metric_t& metric, uint8_t origin, bool sensor_stream)
+{
+    if (!(self->liveness & origin))
+        return;
+
+    // metric from agent-cm is not comming from the device itself -> ignore it
+    if (metric.computed)
+        return;
+
+    uint64_t    timestamp = metric.time;
+    const char* source    = metric.name;
+    bool        touch     = true;
+    if (metric.port != NULL) {
+        // is it from sensor? yes
+        // get sensors attached to the 'asset' on the 'port'! we can have more than 1!
+        source = metric.sname;
+        if (NULL == source) {
+            logLimited(logError, "Sensor message malformed: found {}='{}' but {} is missing",
+                FTY_PROTO_METRICS_SENSOR_AUX_PORT, metric.port, FTY_PROTO_METRICS_SENSOR_AUX_SNAME);
+            return;
+        }
+        logAsset(self->assets, source, "Sensor '{}' on '{}'/'{}' is still alive", source, metric.name, metric.port);
+    } else if (sensor_stream) {
+        // hotfix IPMVAL-2713: filter inventory message from sensors which cause the 'outage' alert
+        // activation/deactivation.
+        touch = (NULL == metric.operation) || !streq(metric.operation, FTY_PROTO_ASSET_OP_INVENTORY);
+    }
+
+    // heartbeat already applied from the other source, or ignored metric from future, can't bring the asset back
+    if (touch && s_osrv_touch_asset(self, source, timestamp, metric.ttl) != 0)
+        return;
+    s_osrv_asset_alive(self, source, timestamp, touch);
 }
 
 // switch asset 'source-asset' to maintenance mode
-// this implies putting a long TTL, so that no 'outage' alert is generated
+// maintenance is a state of its own, so metrics received meanwhile don't shorten it
 // return -1, if operation failed
 // return 0 otherwise
 static int s_osrv_maintenance_mode(s_osrv_t* self, const char* source_asset, int mode, int expiration_ttl)
 {
-    int rv = -1;
-
     assert(self);
     assert(source_asset);
 
-    uint64_t now_sec = uint64_t(zclock_time() / 1000);
+    uint64_t now_sec = vclock_time_sec(self->assets->clock);
 
     if (zhashx_lookup(self->assets->assets, source_asset)) {
-
-        // The asset is already known
-        // so resolve the existing alert if mode == ENABLE_MAINTENANCE
-        logDebug(
-            "outage: maintenance mode: asset '{}' found, so updating it and resolving current alert", source_asset);
-
-        if (mode == ENABLE_MAINTENANCE)
-            s_osrv_resolve_alert(self, source_asset);
-
-        // Note: when mode == DISABLE_MAINTENANCE, restore the default expiration
-        rv = data_touch_asset(self->assets, source_asset, now_sec,
-            (mode == ENABLE_MAINTENANCE) ? uint64_t(expiration_ttl) : self->assets->default_expiry_sec, now_sec);
-        if (rv == -1) {
-            // FIXME: use agent name from fty-common
-            logError("outage: failed to {}able maintenance mode for asset '{}'",
-                (mode == ENABLE_MAINTENANCE) ? "en" : "dis", source_asset);
-        } else
-            logInfo("outage: maintenance mode {}abled for asset '{}'", (mode == ENABLE_MAINTENANCE) ? "en" : "dis",
-                source_asset);
+        logDebug("outage: maintenance mode: asset '{}' found, so updating it", source_asset);
     } else {
         logDebug("outage: maintenance mode: asset '{}' not found, so creating it", source_asset);
 
-        // The asset is already known, so add it to the tracking list
-        // theoretically, this is only needed when generating the outage alert
+        // The asset is not known, so add it to the tracking list
+        // theoretically, the ename is only needed when generating the outage alert
         // so not applicable here!
-        // zhashx_insert (self->assets->asset_enames, asset_name, (void*) fty_proto_ext_string (proto, "name", ""));
-
-        expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets->assets, source_asset));
-        if (e == NULL) {
-            // FIXME: check if the 2nd param is really needed, seems not used!
-            fty_proto_t* msg = fty_proto_new(FTY_PROTO_ASSET);
-
-            e = expiration_new(
-                (mode == ENABLE_MAINTENANCE) ? uint64_t(expiration_ttl) : self->assets->default_expiry_sec, &msg);
+        fty_proto_t*  msg = fty_proto_new(FTY_PROTO_ASSET);
+        expiration_t* e   = expiration_new(self->assets->default_expiry_sec, &msg);
+        expiration_update(e, now_sec);
+        e->added_sec = now_sec;
+        logDebug("asset: ADDED name='{}', last_seen={}[s], ttl={}[s], expires_at={}[s]", source_asset,
+            e->last_time_seen_sec, e->ttl_sec, expiration_get(e));
+        zhashx_insert(self->assets->assets, source_asset, e);
+    }
 
-            expiration_update(e, now_sec);
-            logDebug("asset: ADDED name='{}', last_seen={}[s], ttl={}[s], expires_at={}[s]", source_asset,
-                e->last_time_seen_sec, e->ttl_sec, expiration_get(e));
-            zhashx_insert(self->assets->assets, source_asset, e);
-            rv = 0;
-        }
+    int rv;
+    if (mode == ENABLE_MAINTENANCE) {
+        // resolve the existing alert, asset won't be checked until maintenance ends
+        s_osrv_resolve_alert(self, source_asset, HISTORY_MAINTENANCE);
+        rv = data_maintenance_enable(self->assets, source_asset, now_sec + uint64_t(expiration_ttl));
+    } else
+        rv = data_maintenance_disable(self->assets, source_asset);
+
+    if (rv == -1) {
+        // FIXME: use agent name from fty-common
+        logError("outage: failed to {}able maintenance mode for asset '{}'",
+            (mode == ENABLE_MAINTENANCE) ? "en" : "dis", source_asset);
+    } else {
+        logInfo("outage: maintenance mode {}abled for asset '{}' with TTL {}",
+            (mode == ENABLE_MAINTENANCE) ? "en" : "dis", source_asset, expiration_ttl);
+        uint64_t until_sec = (mode == ENABLE_MAINTENANCE) ? now_sec + uint64_t(expiration_ttl) : 0;
+        s_osrv_replicate(self, {"MAINTENANCE", source_asset, std::to_string(until_sec)});
     }
-    logInfo("outage: maintenance mode {}abled for asset '{}' with TTL {}", (mode == ENABLE_MAINTENANCE) ? "en" : "dis",
-        source_asset, expiration_ttl);
     return rv;
 }
 
@@ -144,33 +316,506 @@ static void s_osrv_activate_alert(s_osrv_t* self, const char* source_asset)
     assert(self);
     assert(source_asset);
 
+    uint64_t      now_sec = vclock_time_sec(self->assets->clock);
+    expiration_t* e       = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets->assets, source_asset));
+
     if (!zhash_lookup(self->active_alerts, source_asset)) {
         logInfo("\t\tsend ACTIVE alert for source={}", source_asset);
-        s_osrv_send_alert(self, source_asset, "ACTIVE");
+        s_osrv_send_alert(self, source_asset, "ACTIVE", e ? expiration_get(e) : 0);
         zhash_insert(self->active_alerts, source_asset, TRUE);
+        uint64_t start_sec = e ? std::max(expiration_get(e), e->maintenance_ended_sec) : now_sec;
+        data_availability_down(self->assets, source_asset, start_sec, now_sec);
+        if (self->history)
+            history_begin(self->history, source_asset, int64_t(start_sec));
+        s_osrv_replicate(self, {"ALERT", source_asset, "ACTIVE", std::to_string(start_sec)});
+    } else if (e && e->reannounce_sec != 0 && now_sec < e->announced_sec + e->reannounce_sec) {
+        // policy of the asset asks for less frequent re-announcements
+        logAsset(self->assets, source_asset, "\t\talert already active for source={} (re-announced at {})",
+            source_asset, e->announced_sec);
+        return;
     } else {
         /// XXX: Send the alert nevertheless, unexplained behavior change from last release.
-        logDebug("\t\talert already active for source={} (sending alert anyway)", source_asset);
-        s_osrv_send_alert(self, source_asset, "ACTIVE");
+        logAsset(self->assets, source_asset, "\t\talert already active for source={} (sending alert anyway)",
+            source_asset);
+        s_osrv_send_alert(self, source_asset, "ACTIVE", 0);
     }
+    if (e)
+        e->announced_sec = now_sec;
 }
 
 
+// availability in percent, as published
+static std::string s_osrv_percent(double percent)
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%.3f", percent);
+    return buffer;
+}
+
+// status of asset 'source-asset', which is not tracked any more, expires from fty_shm right away,
+// as fty_shm can't delete single metrics of an asset
+static void s_osrv_withdraw_status(s_osrv_t* self, const char* source_asset)
+{
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets->assets, source_asset));
+    if (!self->shm_status || !e || e->published_state == ASSET_STATE_UNKNOWN)
+        return;
+    e->published_state = ASSET_STATE_UNKNOWN;
+
+    std::vector<std::string> metrics = {"communicating", "last_seen", "expires_at", "maintenance_until"};
+    for (int w = 0; w < AVAILABILITY_WINDOWS; w++)
+        metrics.push_back(std::string("availability_") + availability_window_str(w));
+    int rv = 0;
+    for (const auto& metric : metrics)
+        rv |= fty::shm::write_metric(source_asset, SHM_STATUS_PREFIX + metric, "0", "", SHM_STATUS_WITHDRAW_TTL_SEC);
+    if (rv != 0)
+        logError("outage: failed to withdraw status of '{}' from shm", source_asset);
+}
+
+// write status of the assets which changed since the last dead check into fty_shm
+static void s_osrv_publish_status(s_osrv_t* self, uint64_t now_sec)
+{
+    assert(self);
+
+    if (!self->shm_status)
+        return;
+
+    auto changes = data_status_changes(self->assets, now_sec, SHM_STATUS_REFRESH_SEC);
+    logDebug("outage: publish status of {} assets", changes.size());
+    for (const auto& status : changes) {
+        bool communicating = !status.dead && status.maintenance_until_sec == 0;
+        int  rv            = fty::shm::write_metric(
+            status.name, SHM_STATUS_PREFIX "communicating", communicating ? "1" : "0", "", SHM_STATUS_TTL_SEC);
+        rv |= fty::shm::write_metric(status.name, SHM_STATUS_PREFIX "last_seen",
+            std::to_string(status.last_seen_sec), "s", SHM_STATUS_TTL_SEC);
+        rv |= fty::shm::write_metric(status.name, SHM_STATUS_PREFIX "expires_at",
+            std::to_string(status.expires_at_sec), "s", SHM_STATUS_TTL_SEC);
+        rv |= fty::shm::write_metric(status.name, SHM_STATUS_PREFIX "maintenance_until",
+            std::to_string(status.maintenance_until_sec), "s", SHM_STATUS_TTL_SEC);
+        // refreshes move the windows of each asset at least every SHM_STATUS_REFRESH_SEC
+        availability_report_t reports[AVAILABILITY_WINDOWS];
+        if (data_get_availability(self->assets, status.name.c_str(), now_sec, reports) == 0) {
+            for (int w = 0; w < AVAILABILITY_WINDOWS; w++) {
+                rv |= fty::shm::write_metric(status.name,
+                    std::string(SHM_STATUS_PREFIX "availability_") + availability_window_str(w),
+                    s_osrv_percent(reports[w].percent), "%", SHM_STATUS_TTL_SEC);
+            }
+        }
+        if (rv != 0)
+            logError("outage: failed to publish status of '{}' into shm", status.name);
+    }
+}
+
 static void s_osrv_check_dead_devices(s_osrv_t* self)
 {
     assert(self);
 
+    histogram_timer_t timer(stats_histogram(self->assets->stats, STATS_LATENCY_DEAD_CHECK));
+    int64_t           start_usec = zclock_usecs();
+    uint64_t          now_sec    = vclock_time_sec(self->assets->clock);
+
+    for (const auto& source : data_maintenance_windows(self->assets, now_sec)) {
+        logInfo("outage: maintenance window started for asset '{}'", source);
+        s_osrv_resolve_alert(self, source.c_str(), HISTORY_MAINTENANCE);
+    }
+    for (const auto& source : data_maintenance_expire(self->assets, now_sec))
+        logInfo("outage: maintenance mode expired for asset '{}'", source);
+
     logDebug("time to check dead devices");
     auto dead_devices = data_get_dead(self->assets);
 
+    // alerts of the assets still dead when their wave ends are released below
+    for (const auto& wave : wave_settle(self->wave, self->assets, now_sec)) {
+        logInfo("outage: wave of {} assets of '{}' ended, {} of them are still dead", wave.assets, wave.origin,
+            wave.dead);
+        s_osrv_send_wave_alert(self, wave, "RESOLVED");
+    }
+
+    // assets expired since the previous check
+    std::vector<std::string> expired;
+    for (const auto& source : dead_devices) {
+        if (!zhash_lookup(self->active_alerts, source.c_str()) && !wave_held(self->wave, source.c_str()))
+            expired.push_back(source);
+    }
+    uint64_t touches   = stats_get(self->assets->stats, STATS_TOUCHES);
+    bool     received  = touches != self->last_touches;
+    self->last_touches = touches;
+    for (const auto& wave : wave_detect(self->wave, self->assets, expired, received, now_sec)) {
+        logWarn("outage: wave of {} assets of '{}' expired at once, their alerts are held for {} s", wave.assets,
+            wave.origin, self->wave->hold_sec);
+        stats_inc(self->assets->stats, STATS_WAVES);
+    }
+    for (const auto& wave : self->wave->waves)
+        s_osrv_send_wave_alert(self, wave, "ACTIVE");
+
     logDebug("dead_devices.size={}", dead_devices.size());
     for (const auto& source : dead_devices) {
-        logDebug("\tsource={}", source);
+        logAsset(self->assets, source.c_str(), "\tsource={}", source);
+        if (wave_held(self->wave, source.c_str()))
+            continue;
+        // flapping assets are held in ACTIVE state, so outage is always published
+        data_flap_observe(self->assets, source.c_str(), true, now_sec);
         s_osrv_activate_alert(self, source.c_str());
     }
+
+    // assets which are stable again get the alert state they were observed in
+    auto settled = data_flap_settle(self->assets, now_sec);
+    for (const auto& source : settled) {
+        expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets->assets, source.c_str()));
+        if (e && !(e->flags & EXPIRATION_FLAG_DOWN))
+            s_osrv_resolve_alert(self, source.c_str(), HISTORY_RECOVERED, e->last_time_seen_sec);
+    }
+
+    s_osrv_publish_status(self, now_sec);
+
+    stats_t* stats = self->assets->stats;
+    stats_inc(stats, STATS_DEAD_CHECKS);
+    stats_set(stats, STATS_ASSETS_TRACKED, zhashx_size(self->assets->assets));
+    stats_set(stats, STATS_ASSETS_DEAD, dead_devices.size());
+    stats_set(stats, STATS_ALERTS_TRACKED, zhash_size(self->active_alerts));
+    stats_set(stats, STATS_ALERTS_HELD, zhashx_size(self->wave->held));
+    stats_set(stats, STATS_DEAD_CHECK_USEC, uint64_t(zclock_usecs() - start_usec));
 }
 
-static int s_osrv_actor_commands(s_osrv_t* self, zmsg_t** message_p)
+// metric with 'timestamp' was received from the stream, remember how late it was
+static void s_osrv_ingest_lag(s_osrv_t* self, uint64_t timestamp)
+{
+    int64_t lag_ms = std::max(vclock_time(self->assets->clock) - int64_t(timestamp) * 1000, int64_t(0));
+    histogram_record(stats_histogram(self->assets->stats, STATS_LATENCY_INGEST_LAG), uint64_t(lag_ms) * 1000);
+    if (self->ingest.min_lag_ms < 0 || lag_ms < self->ingest.min_lag_ms)
+        self->ingest.min_lag_ms = lag_ms;
+}
+
+// message was received from the stream, count the messages which were already waiting
+static void s_osrv_ingest_backlog(s_osrv_t* self)
+{
+    if (zsock_events(mlm_client_msgpipe(self->client)) & ZMQ_POLLIN) {
+        self->ingest.backlog++;
+        self->ingest.max_backlog = std::max(self->ingest.max_backlog, self->ingest.backlog);
+    } else
+        self->ingest.backlog = 0;
+}
+
+// close the check period of the ingestion, enter or leave the protective mode
+// return true, if the agent is behind and dead checks are deferred
+static bool s_osrv_ingest_behind(s_osrv_t* self, uint64_t now_ms)
+{
+    assert(self);
+
+    osrv_ingest_t& ingest = self->ingest;
+    stats_t*       stats  = self->assets->stats;
+
+    // no metric received means nothing is waiting
+    int64_t lag_ms = std::max(ingest.min_lag_ms, int64_t(0));
+    stats_set(stats, STATS_INGEST_LAG_MS, uint64_t(lag_ms));
+    stats_set(stats, STATS_INGEST_BACKLOG, ingest.max_backlog);
+    ingest.min_lag_ms  = -1;
+    ingest.max_backlog = ingest.backlog;
+
+    if (self->lag_threshold_ms == 0) {
+        ingest.protective_since_ms = 0;
+    } else if (ingest.protective_since_ms == 0 && uint64_t(lag_ms) > self->lag_threshold_ms) {
+        logWarn("outage: metrics are processed {} ms late, dead checks are deferred", lag_ms);
+        ingest.protective_since_ms = now_ms;
+    } else if (ingest.protective_since_ms != 0 && uint64_t(lag_ms) < self->lag_threshold_ms / 2) {
+        logInfo("outage: metrics are processed {} ms late, dead checks are resumed", lag_ms);
+        ingest.protective_since_ms = 0;
+    } else if (ingest.protective_since_ms != 0 && now_ms - ingest.protective_since_ms > PROTECTIVE_MAX_MS) {
+        logError("outage: metrics are still processed {} ms late, dead checks can't be deferred anymore", lag_ms);
+        stats_set(stats, STATS_PROTECTIVE, 0);
+        return false;
+    }
+
+    stats_set(stats, STATS_PROTECTIVE, ingest.protective_since_ms != 0);
+    if (ingest.protective_since_ms == 0)
+        return false;
+    stats_inc(stats, STATS_DEAD_CHECKS_DEFERRED);
+    return true;
+}
+
+// stop tracking asset 'source-asset', its alert is resolved, the standby forgets it too
+static void s_osrv_delete_asset(s_osrv_t* self, const char* source_asset)
+{
+    s_osrv_resolve_alert(self, source_asset, HISTORY_REMOVED);
+    s_osrv_withdraw_status(self, source_asset);
+    data_delete(self->assets, source_asset);
+    s_osrv_replicate(self, {"DELETE", source_asset});
+}
+
+// save the state, publish statistics and check dead devices, when it is time to do it
+// 'expired' forces the check of dead devices
+static void s_osrv_run_timers(s_osrv_t* self, bool expired)
+{
+    assert(self);
+
+    uint64_t now_ms = uint64_t(vclock_mono(self->assets->clock));
+
+    // step of the wall clock (NTP) is not an outage of all the assets, nor keeps them alive
+    int64_t jump_ms = vclock_jump(self->assets->clock);
+    if (jump_ms >= CLOCK_JUMP_THRESHOLD_MS || jump_ms <= -CLOCK_JUMP_THRESHOLD_MS) {
+        logWarn("outage: wall clock jumped by {} ms, expiration times are moved along", jump_ms);
+        stats_inc(self->assets->stats, STATS_CLOCK_JUMPS);
+        data_shift_time(self->assets, jump_ms / 1000);
+        wave_shift_time(self->wave, jump_ms / 1000);
+    }
+
+    // save the state
+    if ((now_ms - self->last_save_ms) > SAVE_INTERVAL_MS) {
+        int r = s_osrv_save(self);
+        if (r != 0)
+            logError("failed to save state file {}", self->state_file);
+        self->last_save_ms = now_ms;
+    }
+
+    // publish statistics of the agent, the standby would overwrite the ones of the leader
+    if (self->replica_role != OSRV_REPLICA_STANDBY && self->stats_interval_ms != 0 &&
+        (now_ms - self->last_stats_ms) >= self->stats_interval_ms) {
+        stats_set(self->assets->stats, STATS_ASSETS_TRACKED, zhashx_size(self->assets->assets));
+        stats_set(self->assets->stats, STATS_ALERTS_TRACKED, zhash_size(self->active_alerts));
+        stats_publish(
+            self->assets->stats, STATS_SHM_ASSET, STATS_SHM_PREFIX, int(self->stats_interval_ms * 3 / 1000));
+        self->last_stats_ms = now_ms;
+    }
+
+    // send alerts, the standby only follows the leader
+    if (self->replica_role != OSRV_REPLICA_STANDBY &&
+        (expired || (now_ms - self->last_dead_check_ms) > self->timeout_ms)) {
+        if (!s_osrv_ingest_behind(self, now_ms))
+            s_osrv_check_dead_devices(self);
+        self->last_dead_check_ms = uint64_t(vclock_mono(self->assets->clock));
+    }
+}
+
+// source of liveness named 'source' (shm, stream or hybrid), 0 if it is unknown
+static uint8_t s_osrv_liveness(const char* source)
+{
+    if (source && streq(source, "shm"))
+        return OSRV_LIVENESS_SHM;
+    if (source && streq(source, "stream"))
+        return OSRV_LIVENESS_STREAM;
+    if (source && streq(source, "hybrid"))
+        return OSRV_LIVENESS_HYBRID;
+    return 0;
+}
+
+static void s_osrv_set_liveness(s_osrv_t* self, uint8_t liveness)
+{
+    self->liveness = liveness;
+    zstr_sendx(self->metric_poll, "ENABLE", (self->liveness & OSRV_LIVENESS_SHM) ? "1" : "0", NULL);
+}
+
+// read 'config_file' again and apply it to the running agent as a whole, between two messages;
+// settings missing in the file get their defaults, the tracked assets, alerts and history stay
+// return -1, if the file can't be read or some part of it is invalid, nothing is applied then
+// return 0 otherwise
+static int s_osrv_reload(s_osrv_t* self, const char* config_file)
+{
+    assert(self);
+    assert(config_file);
+
+    zconfig_t* config = zconfig_load(config_file);
+    if (!config) {
+        logError("RELOAD: can't load {}", config_file);
+        return -1;
+    }
+
+    // parts which may be invalid are checked first, maintenance windows are loaded last, as the load is
+    // all or nothing too
+    policy_t* policy   = policy_new();
+    uint8_t   liveness = s_osrv_liveness(zconfig_get(config, "server/liveness_source", DEFAULT_LIVENESS_SOURCE));
+    uint64_t  check_ms = uint64_t(atoll(zconfig_get(config, "server/check_interval", DEFAULT_CHECK_INTERVAL))) * 1000;
+    int       rv       = -1;
+    if (!policy || policy_load(policy, config) != 0)
+        logError("RELOAD: invalid policy in {}", config_file);
+    else if (liveness == 0)
+        logError("RELOAD: unsupported liveness source in {}", config_file);
+    else if (check_ms == 0)
+        logError("RELOAD: invalid check interval in {}", config_file);
+    else if (data_load_maintenance_windows(self->assets, config, vclock_time_sec(self->assets->clock)) != 0)
+        logError("RELOAD: invalid maintenance windows in {}", config_file);
+    else
+        rv = 0;
+    if (rv != 0) {
+        logError("RELOAD: keeping the current configuration");
+        policy_destroy(&policy);
+        zconfig_destroy(&config);
+        return rv;
+    }
+
+    data_set_policy(self->assets, &policy);
+    for (const auto& source : data_follow_policy(self->assets)) {
+        logInfo("RELOAD: asset '{}' is not monitored any more", source);
+        s_osrv_delete_asset(self, source.c_str());
+    }
+    if (liveness != self->liveness)
+        s_osrv_set_liveness(self, liveness);
+    self->timeout_ms = check_ms;
+    self->default_maintenance_expiration =
+        uint64_t(atoll(zconfig_get(config, "server/maintenance_expiration", DEFAULT_MAINTENANCE_EXPIRATION)));
+    data_set_flap_damping(self->assets,
+        uint32_t(atol(zconfig_get(config, "server/flap_half_life", DEFAULT_FLAP_HALF_LIFE))),
+        uint32_t(atol(zconfig_get(config, "server/flap_suppress", DEFAULT_FLAP_SUPPRESS))),
+        uint32_t(atol(zconfig_get(config, "server/flap_reuse", DEFAULT_FLAP_REUSE))));
+    self->stats_interval_ms =
+        uint64_t(atoll(zconfig_get(config, "server/stats_interval", DEFAULT_STATS_INTERVAL))) * 1000;
+    self->lag_threshold_ms = uint64_t(atoll(zconfig_get(config, "server/lag_threshold", DEFAULT_LAG_THRESHOLD)));
+    wave_configure(self->wave, uint32_t(atol(zconfig_get(config, "server/wave_min_assets", DEFAULT_WAVE_ASSETS))),
+        uint32_t(atol(zconfig_get(config, "server/wave_share", DEFAULT_WAVE_SHARE))),
+        uint32_t(atol(zconfig_get(config, "server/wave_min_children", DEFAULT_WAVE_CHILDREN))),
+        uint64_t(atoll(zconfig_get(config, "server/wave_hold", DEFAULT_WAVE_HOLD))));
+    data_set_max_skew(
+        self->assets, uint32_t(atol(zconfig_get(config, "server/max_clock_skew", DEFAULT_MAX_CLOCK_SKEW))));
+    logInfo("RELOAD: configuration loaded from {}", config_file);
+    zconfig_destroy(&config);
+    return 0;
+}
+
+// send times the assets were seen since the previous sync to the standby, and extend the lease
+static void s_osrv_replica_sync(s_osrv_t* self)
+{
+    if (zhashx_size(self->replica_seen) != 0) {
+        zmsg_t* msg = zmsg_new();
+        zmsg_addstr(msg, "SEEN");
+        for (void* it = zhashx_first(self->replica_seen); it != NULL; it = zhashx_next(self->replica_seen)) {
+            const char*   source = static_cast<const char*>(zhashx_cursor(self->replica_seen));
+            expiration_t* e      = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets->assets, source));
+            if (!e)
+                continue;
+            zmsg_addstr(msg, source);
+            zmsg_addstr(msg, std::to_string(e->last_time_seen_sec).c_str());
+            zmsg_addstr(msg, std::to_string(e->ttl_sec).c_str());
+        }
+        zhashx_purge(self->replica_seen);
+        s_osrv_replicate_msg(self, &msg);
+    }
+    s_osrv_replicate(self, {"LEASE"});
+}
+
+// standby subscribed or missed changes, send it the whole state: assets, maintenance and active alerts
+static void s_osrv_replica_snapshot(s_osrv_t* self)
+{
+    logInfo("replica: sending the standby {} assets", zhashx_size(self->assets->assets));
+    for (void* it = zhashx_first(self->assets->assets); it != NULL; it = zhashx_next(self->assets->assets)) {
+        const char*   source = static_cast<const char*>(zhashx_cursor(self->assets->assets));
+        expiration_t* e      = static_cast<expiration_t*>(it);
+        // assets created by maintenance requests have no message, the standby creates them the same way
+        if (e->msg && !streq(fty_proto_name(e->msg), "")) {
+            fty_proto_t* copy = fty_proto_dup(e->msg);
+            zmsg_t*      msg  = fty_proto_encode(&copy);
+            zmsg_pushstr(msg, "ASSET");
+            s_osrv_replicate_msg(self, &msg);
+        }
+        if (e->maintenance_until_sec != 0)
+            s_osrv_replicate(self, {"MAINTENANCE", source, std::to_string(e->maintenance_until_sec)});
+        zhashx_update(self->replica_seen, source, TRUE);
+    }
+    for (void* it = zhash_first(self->active_alerts); it != NULL; it = zhash_next(self->active_alerts)) {
+        const char*   source = zhash_cursor(self->active_alerts);
+        expiration_t* e      = reinterpret_cast<expiration_t*>(zhashx_lookup(self->assets->assets, source));
+        uint64_t      start  = e ? expiration_get(e) : vclock_time_sec(self->assets->clock);
+        s_osrv_replicate(self, {"ALERT", source, "ACTIVE", std::to_string(start)});
+    }
+    s_osrv_replica_sync(self);
+}
+
+// apply change of the state received from the leader, destroys the message
+static void s_osrv_replica_apply(s_osrv_t* self, zmsg_t** msg_p)
+{
+    zmsg_t*  msg     = *msg_p;
+    char*    kind    = zmsg_popstr(msg);
+    uint64_t now_sec = vclock_time_sec(self->assets->clock);
+    if (!kind || streq(kind, "LEASE")) {
+        zstr_free(&kind);
+        zmsg_destroy(msg_p);
+        return;
+    }
+
+    if (streq(kind, "ASSET")) {
+        fty_proto_t* proto = fty_proto_decode(msg_p);
+        data_put(self->assets, &proto);
+        fty_proto_destroy(&proto);
+    } else if (streq(kind, "DELETE")) {
+        char* source = zmsg_popstr(msg);
+        if (source)
+            data_delete(self->assets, source);
+        zstr_free(&source);
+    } else if (streq(kind, "SEEN")) {
+        while (zmsg_size(msg) >= 3) {
+            char* source    = zmsg_popstr(msg);
+            char* last_seen = zmsg_popstr(msg);
+            char* ttl       = zmsg_popstr(msg);
+            data_set_seen(self->assets, source, uint64_t(atoll(last_seen)), uint64_t(atoll(ttl)));
+            zstr_free(&source);
+            zstr_free(&last_seen);
+            zstr_free(&ttl);
+        }
+    } else if (streq(kind, "ALERT")) {
+        // the leader published the alert, only its bookkeeping is followed
+        char*    source = zmsg_popstr(msg);
+        char*    state  = zmsg_popstr(msg);
+        char*    time   = zmsg_popstr(msg);
+        char*    cause  = zmsg_popstr(msg);
+        uint64_t at_sec = time ? uint64_t(atoll(time)) : now_sec;
+        if (source && state && streq(state, "ACTIVE") && !zhash_lookup(self->active_alerts, source)) {
+            zhash_insert(self->active_alerts, source, TRUE);
+            data_availability_down(self->assets, source, at_sec, now_sec);
+            if (self->history)
+                history_begin(self->history, source, int64_t(at_sec));
+        } else if (source && state && streq(state, "RESOLVED") && zhash_lookup(self->active_alerts, source)) {
+            zhash_delete(self->active_alerts, source);
+            data_availability_up(self->assets, source, at_sec, now_sec);
+            if (self->history)
+                history_end(self->history, source, int64_t(at_sec),
+                    history_cause_t(cause ? atoi(cause) : int(HISTORY_RECOVERED)));
+        }
+        zstr_free(&source);
+        zstr_free(&state);
+        zstr_free(&time);
+        zstr_free(&cause);
+    } else if (streq(kind, "MAINTENANCE")) {
+        char*    source    = zmsg_popstr(msg);
+        char*    until     = zmsg_popstr(msg);
+        uint64_t until_sec = until ? uint64_t(atoll(until)) : 0;
+        if (source && until_sec == 0)
+            s_osrv_maintenance_mode(self, source, DISABLE_MAINTENANCE, 0);
+        else if (source)
+            s_osrv_maintenance_mode(
+                self, source, ENABLE_MAINTENANCE, int(until_sec > now_sec ? until_sec - now_sec : 0));
+        zstr_free(&source);
+        zstr_free(&until);
+    } else
+        logWarn("replica: unknown change {}", kind);
+    stats_inc(self->assets->stats, STATS_REPLICA_APPLIED);
+    zstr_free(&kind);
+    zmsg_destroy(msg_p);
+}
+
+// message from the replication actor
+static void s_osrv_handle_replica(s_osrv_t* self, zmsg_t** msg_p)
+{
+    char* command = zmsg_popstr(*msg_p);
+    if (!command)
+        ;
+    else if (streq(command, "APPLY") && self->replica_role == OSRV_REPLICA_STANDBY)
+        s_osrv_replica_apply(self, msg_p);
+    else if (streq(command, "SYNC") && self->replica_role == OSRV_REPLICA_LEADER)
+        s_osrv_replica_sync(self);
+    else if (streq(command, "SNAPSHOT") && self->replica_role == OSRV_REPLICA_LEADER)
+        s_osrv_replica_snapshot(self);
+    else if (streq(command, "TAKEOVER") && self->replica_role == OSRV_REPLICA_STANDBY) {
+        logWarn("replica: lease of the leader expired, taking over at {}", self->replica_endpoint);
+        self->replica_role = OSRV_REPLICA_LEADER;
+        stats_set(self->assets->stats, STATS_STANDBY, 0);
+        zstr_sendx(self->replica, "LEADER", self->replica_endpoint,
+            std::to_string(self->replica_lease_ms).c_str(), NULL);
+    }
+    zstr_free(&command);
+    zmsg_destroy(msg_p);
+}
+
+static int64_t s_osrv_replay(s_osrv_t* self, const char* path, double speed);
+static bool    s_is_number(const char* str);
+
+static int s_osrv_actor_commands(s_osrv_t* self, zsock_t* pipe, zmsg_t** message_p)
 {
     assert(self);
     assert(message_p && *message_p);
@@ -252,6 +897,209 @@ static int s_osrv_actor_commands(s_osrv_t* self, zmsg_t** message_p)
                 logError("failed to load state file {}: %m", self->state_file);
         }
         zstr_free(&state_file);
+    } else if (streq(command, "POLICY")) {
+        char* config_file = zmsg_popstr(message);
+        if (config_file) {
+            zconfig_t* config = zconfig_load(config_file);
+            policy_t*  policy = policy_new();
+            if (config && policy_load(policy, config) == 0) {
+                data_set_policy(self->assets, &policy);
+                logDebug("POLICY: loaded from {}", config_file);
+            } else
+                logError("failed to load policy from {}, keeping the current one", config_file);
+            policy_destroy(&policy);
+            zconfig_destroy(&config);
+        }
+        zstr_free(&config_file);
+    } else if (streq(command, "MAINTENANCE-WINDOWS")) {
+        char* config_file = zmsg_popstr(message);
+        if (config_file) {
+            zconfig_t* config = zconfig_load(config_file);
+            if (config &&
+                data_load_maintenance_windows(self->assets, config, vclock_time_sec(self->assets->clock)) == 0)
+                logDebug("MAINTENANCE-WINDOWS: loaded from {}", config_file);
+            else
+                logError("failed to load maintenance windows from {}, keeping the current ones", config_file);
+            zconfig_destroy(&config);
+        }
+        zstr_free(&config_file);
+    } else if (streq(command, "RELOAD")) {
+        // configuration changed, apply it without losing the tracked assets
+        char* config_file = zmsg_popstr(message);
+        if (config_file)
+            s_osrv_reload(self, config_file);
+        else
+            logError("RELOAD: missing configuration file");
+        zstr_free(&config_file);
+    } else if (streq(command, "FLAP-DAMPING")) {
+        char* half_life = zmsg_popstr(message);
+        char* suppress  = zmsg_popstr(message);
+        char* reuse     = zmsg_popstr(message);
+        if (half_life && suppress && reuse) {
+            data_set_flap_damping(self->assets, uint32_t(atol(half_life)), uint32_t(atol(suppress)),
+                uint32_t(atol(reuse)));
+            logDebug("FLAP-DAMPING: half-life={}, suppress={}, reuse={}", half_life, suppress, reuse);
+        }
+        zstr_free(&half_life);
+        zstr_free(&suppress);
+        zstr_free(&reuse);
+    } else if (streq(command, "WAVE")) {
+        // expiries of many assets at once are one wave, min_assets 0 disables the detection
+        char* min_assets   = zmsg_popstr(message);
+        char* share        = zmsg_popstr(message);
+        char* min_children = zmsg_popstr(message);
+        char* hold         = zmsg_popstr(message);
+        if (min_assets && share && min_children && hold) {
+            wave_configure(self->wave, uint32_t(atol(min_assets)), uint32_t(atol(share)),
+                uint32_t(atol(min_children)), uint64_t(atol(hold)));
+            logDebug("WAVE: min_assets={}, share={}, min_children={}, hold={}", min_assets, share, min_children,
+                hold);
+        }
+        zstr_free(&min_assets);
+        zstr_free(&share);
+        zstr_free(&min_children);
+        zstr_free(&hold);
+    } else if (streq(command, "MAX-CLOCK-SKEW")) {
+        // metrics of devices whose clock is ahead are accepted up to this far in the future
+        char* skew = zmsg_popstr(message);
+        if (skew) {
+            data_set_max_skew(self->assets, uint32_t(atol(skew)));
+            logDebug("MAX-CLOCK-SKEW: {}", self->assets->max_skew_sec);
+        }
+        zstr_free(&skew);
+    } else if (streq(command, "SHM-STATUS")) {
+        char* enable = zmsg_popstr(message);
+        if (enable) {
+            self->shm_status = atoi(enable) != 0;
+            logDebug("SHM-STATUS: {}", self->shm_status);
+        }
+        zstr_free(&enable);
+    } else if (streq(command, "STATS-INTERVAL")) {
+        char* interval = zmsg_popstr(message);
+        if (interval) {
+            self->stats_interval_ms = uint64_t(atoll(interval)) * 1000;
+            logDebug("STATS-INTERVAL: {}", interval);
+        }
+        zstr_free(&interval);
+    } else if (streq(command, "LAG-THRESHOLD")) {
+        char* threshold = zmsg_popstr(message);
+        if (threshold) {
+            self->lag_threshold_ms = uint64_t(atoll(threshold));
+            logDebug("LAG-THRESHOLD: {}", threshold);
+        }
+        zstr_free(&threshold);
+    } else if (streq(command, "TRACE-FILE")) {
+        char* trace_file = zmsg_popstr(message);
+        if (self->trace)
+            fclose(self->trace);
+        self->trace = NULL;
+        if (trace_file && !streq(trace_file, "")) {
+            self->trace = fopen(trace_file, "a");
+            if (self->trace) {
+                setvbuf(self->trace, NULL, _IOLBF, 0);
+                logDebug("TRACE-FILE: {}", trace_file);
+            } else
+                logError("failed to open trace file {}: %m", trace_file);
+        }
+        zstr_free(&trace_file);
+    } else if (streq(command, "REPLICA")) {
+        // role (none, leader or standby), endpoint and lease of the replication, set once at start
+        char* role     = zmsg_popstr(message);
+        char* endpoint = zmsg_popstr(message);
+        char* lease    = zmsg_popstr(message);
+        if (self->replica_role != OSRV_REPLICA_NONE)
+            logError("REPLICA: role of the agent is already set");
+        else if (role && (streq(role, "leader") || streq(role, "standby"))) {
+            zstr_free(&self->replica_endpoint);
+            self->replica_endpoint = strdup(endpoint && *endpoint ? endpoint : REPLICA_DEFAULT_ENDPOINT);
+            self->replica_lease_ms = lease && s_is_number(lease) ? uint64_t(atoll(lease)) : REPLICA_DEFAULT_LEASE_MS;
+            self->replica_role     = streq(role, "leader") ? OSRV_REPLICA_LEADER : OSRV_REPLICA_STANDBY;
+            stats_set(self->assets->stats, STATS_STANDBY, self->replica_role == OSRV_REPLICA_STANDBY);
+            zstr_sendx(self->replica, streq(role, "leader") ? "LEADER" : "STANDBY", self->replica_endpoint,
+                std::to_string(self->replica_lease_ms).c_str(), NULL);
+            logDebug("REPLICA: {} at {}", role, self->replica_endpoint);
+        } else if (!role || !streq(role, "none"))
+            logError("REPLICA: unsupported role {}", role ? role : "");
+        zstr_free(&role);
+        zstr_free(&endpoint);
+        zstr_free(&lease);
+    } else if (streq(command, "LIVENESS-SOURCE")) {
+        // metrics which keep assets alive: read from fty_shm, received from the streams, or both
+        char*   source   = zmsg_popstr(message);
+        uint8_t liveness = s_osrv_liveness(source);
+        if (liveness) {
+            s_osrv_set_liveness(self, liveness);
+            logDebug("LIVENESS-SOURCE: {}", source);
+        } else
+            logError("unsupported liveness source {}", source ? source : "");
+        zstr_free(&source);
+    } else if (streq(command, "SHM-READERS")) {
+        // fty_shm is read by pool of this many threads, 0 for one per core
+        char* readers = zmsg_popstr(message);
+        if (readers && s_is_number(readers)) {
+            zstr_sendx(self->metric_poll, "READERS", readers, NULL);
+            logDebug("SHM-READERS: {}", readers);
+        } else
+            logError("invalid number of fty_shm readers {}", readers ? readers : "");
+        zstr_free(&readers);
+    } else if (streq(command, "HISTORY-FILE")) {
+        // outages are recorded into ring of this many records, empty path stops the history
+        char* history_file = zmsg_popstr(message);
+        char* records      = zmsg_popstr(message);
+        history_destroy(&self->history);
+        if (history_file && !streq(history_file, "")) {
+            self->history = history_new(history_file, records ? uint64_t(strtoull(records, NULL, 10)) : 0);
+            if (self->history)
+                logDebug("HISTORY-FILE: {}", history_file);
+            else
+                logError("failed to open history file {}", history_file);
+        }
+        zstr_free(&history_file);
+        zstr_free(&records);
+    } else if (streq(command, "CAPTURE")) {
+        // received messages are written into binary trace, empty path stops the capture
+        char* capture_file = zmsg_popstr(message);
+        if (capture_start(self->capture, capture_file) == 0)
+            logDebug("CAPTURE: {}", capture_file ? capture_file : "");
+        zstr_free(&capture_file);
+    } else if (streq(command, "REPLAY")) {
+        // trace is fed through the handlers, number of records (-1 on error) is sent back when done
+        char*   capture_file = zmsg_popstr(message);
+        char*   speed        = zmsg_popstr(message);
+        int64_t records      = capture_file ? s_osrv_replay(self, capture_file, speed ? atof(speed) : 0) : -1;
+        logDebug("REPLAY: {} records from {}", records, capture_file ? capture_file : "");
+        zstr_send(pipe, std::to_string(records).c_str());
+        zstr_free(&capture_file);
+        zstr_free(&speed);
+    } else if (streq(command, "CLOCK")) {
+        // tests and benchmarks move the time themselves
+        char* mode    = zmsg_popstr(message);
+        char* wall_ms = zmsg_popstr(message);
+        if (mode && streq(mode, "SIMULATED")) {
+            vclock_simulate(self->assets->clock, wall_ms ? int64_t(atoll(wall_ms)) : zclock_time());
+            logDebug("CLOCK: simulated from {}", vclock_time(self->assets->clock));
+        } else
+            logError("unsupported clock {}", mode ? mode : "");
+        zstr_free(&mode);
+        zstr_free(&wall_ms);
+    } else if (streq(command, "CLOCK-ADVANCE")) {
+        char* ms = zmsg_popstr(message);
+        if (ms && vclock_advance(self->assets->clock, int64_t(atoll(ms))) == 0) {
+            logDebug("CLOCK-ADVANCE: {}", ms);
+            s_osrv_run_timers(self, false);
+            if (self->replica)
+                zstr_send(self->replica, "TICK");
+        } else
+            logError("CLOCK-ADVANCE: clock is not simulated");
+        zstr_free(&ms);
+    } else if (streq(command, "CLOCK-STEP")) {
+        char* ms = zmsg_popstr(message);
+        if (ms && vclock_step(self->assets->clock, int64_t(atoll(ms))) == 0) {
+            logDebug("CLOCK-STEP: {}", ms);
+            s_osrv_run_timers(self, false);
+        } else
+            logError("CLOCK-STEP: clock is not simulated");
+        zstr_free(&ms);
     } else if (streq(command, "VERBOSE")) {
         self->verbose = true;
     } else if (streq(command, "DEFAULT_MAINTENANCE_EXPIRATION")) {
@@ -270,52 +1118,31 @@ static int s_osrv_actor_commands(s_osrv_t* self, zmsg_t** message_p)
     return 0;
 }
 
-void metric_processing(fty::shm::shmMetrics& metrics, void* args)
+// 'metrics' were read from fty_shm, every asset is in one shard only
+static void s_osrv_ingest_shm(s_osrv_t* self, const shmreader_result_t& metrics)
 {
-
-    s_osrv_t* self = reinterpret_cast<s_osrv_t*>(args);
-
-    for (auto& element : metrics) {
-        const char* is_computed = fty_proto_aux_string(element, "x-cm-count", NULL);
-        if (!is_computed) {
-            uint64_t    now_sec   = uint64_t(zclock_time() / 1000);
-            uint64_t    timestamp = fty_proto_time(element);
-            const char* port      = fty_proto_aux_string(element, FTY_PROTO_METRICS_SENSOR_AUX_PORT, NULL);
-
-            if (port != NULL) {
-                // is it from sensor? yes
-                // get sensors attached to the 'asset' on the 'port'! we can have more than 1!
-                const char* source = fty_proto_aux_string(element, FTY_PROTO_METRICS_SENSOR_AUX_SNAME, NULL);
-                if (NULL == source) {
-                    logError("Sensor message malformed: found {}='{}' but {} is missing",
-                        FTY_PROTO_METRICS_SENSOR_AUX_PORT, port, FTY_PROTO_METRICS_SENSOR_AUX_SNAME);
-                    continue;
-                }
-                logDebug("Sensor '{}' on '{}'/'{}' is still alive", source, fty_proto_name(element), port);
-                s_osrv_resolve_alert(self, source);
-                int rv = data_touch_asset(self->assets, source, timestamp, fty_proto_ttl(element), now_sec);
-                if (rv == -1)
-                    logError("asset: name = {}, topic={} metric is from future! ignore it", source,
-                        mlm_client_subject(self->client));
-            } else {
-                // is it from sensor? no
-                const char* source = fty_proto_name(element);
-                s_osrv_resolve_alert(self, source);
-                int rv = data_touch_asset(self->assets, source, timestamp, fty_proto_ttl(element), now_sec);
-                if (rv == -1)
-                    logError("asset: name = {}, topic={} metric is from future! ignore it", source,
-                        mlm_client_subject(self->client));
-            }
-        } else {
-            // intentionally left empty
-            // so it is metric from agent-cm -> it is not comming from the device itself ->ignore it
+    histogram_timer_t timer(stats_histogram(self->assets->stats, STATS_LATENCY_METRIC_PROCESSING));
+    stats_inc(self->assets->stats, STATS_SHM_POLLS);
+    stats_inc(self->assets->stats, STATS_SHM_METRICS, shmreader_result_size(metrics));
+    for (auto shard : metrics) {
+        for (auto& element : *shard) {
+            // status published by ourselves is not a sign of life
+            if (strncmp(fty_proto_type(element), SHM_STATUS_PREFIX, strlen(SHM_STATUS_PREFIX)) == 0)
+                continue;
+            s_osrv_ingest_metric(self, s_osrv_metric(element), OSRV_LIVENESS_SHM, false);
         }
     }
 }
 
+// reads fty_shm each polling interval and sends the metrics to the server as METRICS/<shmreader_result_t*>,
+// the server owns them then; ENABLE/0 stops the reading, ENABLE/1 resumes it,
+// READERS/<n> reads the shards with 'n' threads, 0 for one per core
 void outage_metric_polling(zsock_t* pipe, void* args)
 {
-    zpoller_t* poller = zpoller_new(pipe, NULL);
+    stats_t*     stats   = reinterpret_cast<stats_t*>(args);
+    zpoller_t*   poller  = zpoller_new(pipe, NULL);
+    shmreader_t* reader  = shmreader_new(0);
+    bool         enabled = true;
     zsock_signal(pipe, 0);
 
     while (!zsys_interrupted) {
@@ -324,12 +1151,20 @@ void outage_metric_polling(zsock_t* pipe, void* args)
             logInfo("outage_actor: Terminating.");
             break;
         }
-        if (zpoller_expired(poller)) {
-            fty::shm::shmMetrics result;
+        if (zpoller_expired(poller) && enabled) {
+            int64_t             start_usec = zclock_usecs();
+            shmreader_result_t* result     = new shmreader_result_t();
             logDebug("read metrics");
-            fty::shm::read_metrics(".*", ".*", result);
-            logDebug("i have read {} metric", result.size());
-            metric_processing(result, args);
+            {
+                histogram_timer_t timer(stats_histogram(stats, STATS_LATENCY_SHM_READ));
+                shmreader_read(reader, *result);
+            }
+            logDebug("i have read {} metric", shmreader_result_size(*result));
+            stats_set(stats, STATS_SHM_POLL_USEC, uint64_t(zclock_usecs() - start_usec));
+            if (zsock_send(pipe, "sp", "METRICS", result) != 0) {
+                shmreader_result_clear(*result);
+                delete result;
+            }
         }
         if (which == pipe) {
             zmsg_t* msg = zmsg_recv(pipe);
@@ -340,6 +1175,15 @@ void outage_metric_polling(zsock_t* pipe, void* args)
                         zstr_free(&cmd);
                         zmsg_destroy(&msg);
                         break;
+                    } else if (streq(cmd, "ENABLE")) {
+                        char* enable = zmsg_popstr(msg);
+                        enabled      = enable && atoi(enable) != 0;
+                        zstr_free(&enable);
+                    } else if (streq(cmd, "READERS")) {
+                        char* workers = zmsg_popstr(msg);
+                        shmreader_destroy(&reader);
+                        reader = shmreader_new(workers ? size_t(atoi(workers)) : 0);
+                        zstr_free(&workers);
                     }
                     zstr_free(&cmd);
                 }
@@ -347,6 +1191,7 @@ void outage_metric_polling(zsock_t* pipe, void* args)
             }
         }
     }
+    shmreader_destroy(&reader);
     zpoller_destroy(&poller);
 }
 
@@ -354,108 +1199,430 @@ void outage_metric_polling(zsock_t* pipe, void* args)
 //  --------------------------------------------------------------------------
 //  Handle mailbox messages
 
-static void fty_outage_handle_mailbox(s_osrv_t* self, zmsg_t** msg)
+// parse maintenance <mode>, adds error to the reply if it is missing or unsupported
+static bool s_osrv_maintenance_parse_mode(zmsg_t* msg, zmsg_t* reply, int* mode)
+{
+    char* mode_str = zmsg_popstr(msg);
+    if (!mode_str) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Missing maintenance mode");
+        return false;
+    }
+
+    logDebug("Maintenance mode: {}", mode_str);
+    bool valid = true;
+    if (streq(mode_str, "enable"))
+        *mode = ENABLE_MAINTENANCE;
+    else if (streq(mode_str, "disable"))
+        *mode = DISABLE_MAINTENANCE;
+    else {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Unsupported maintenance mode");
+        valid = false;
+    }
+    zstr_free(&mode_str);
+    return valid;
+}
+
+static bool s_is_number(const char* str)
+{
+    if (*str == '\0')
+        return false;
+    for (; *str; str++) {
+        if (!isdigit(*str))
+            return false;
+    }
+    return true;
+}
+
+// expiration TTL marked explicitly as ttl=<seconds>
+// return -1, if 'frame' is not such a mark, or the TTL is not a number
+static int s_osrv_maintenance_ttl_mark(const char* frame)
+{
+    if (strncmp(frame, "ttl=", 4) != 0 || !s_is_number(frame + 4))
+        return -1;
+    return atoi(frame + 4);
+}
+
+// * REQUEST/'msg-correlation-id'/MAINTENANCE_MODE/<mode>/asset1/.../assetN/expiration - switch 'asset1'
+// to 'assetN' into maintenance ex: bmsg request fty-outage GET REQUEST 1234 MAINTENANCE_MODE enable
+// ups-9 3600
+// expiration is the last frame, either ttl=<seconds>, or a number which is not a name of a tracked asset
+// reply is OK, or ERROR/Command failed/failed_asset1/.../failed_assetN
+static void s_osrv_handle_maintenance(s_osrv_t* self, zmsg_t* msg, zmsg_t* reply)
+{
+    int mode;
+    if (!s_osrv_maintenance_parse_mode(msg, reply, &mode))
+        return;
+
+    std::vector<std::string> assets;
+    for (char* asset = zmsg_popstr(msg); asset != NULL; asset = zmsg_popstr(msg)) {
+        assets.emplace_back(asset);
+        zstr_free(&asset);
+    }
+
+    // last frame is the expiration TTL, if it is marked, or if it is a number and no asset is named so
+    int expiration_ttl = int(self->default_maintenance_expiration);
+    if (!assets.empty()) {
+        const char* last = assets.back().c_str();
+        int         ttl  = s_osrv_maintenance_ttl_mark(last);
+        if (ttl < 0 && s_is_number(last) && !zhashx_lookup(self->assets->assets, last))
+            ttl = atoi(last);
+        if (ttl >= 0) {
+            expiration_ttl = ttl;
+            assets.pop_back();
+        }
+    }
+
+    std::vector<std::string> failed;
+    for (const auto& asset : assets) {
+        if (s_osrv_maintenance_mode(self, asset.c_str(), mode, expiration_ttl) != 0)
+            failed.push_back(asset);
+    }
+
+    if (!assets.empty() && failed.empty()) {
+        zmsg_addstr(reply, "OK");
+        return;
+    }
+    zmsg_addstr(reply, "ERROR");
+    zmsg_addstr(reply, "Command failed");
+    for (const auto& asset : failed)
+        zmsg_addstr(reply, asset.c_str());
+}
+
+// * REQUEST/'msg-correlation-id'/MAINTENANCE_MODE_SELECT/<mode>/<selector>/<value>/expiration - switch all
+// the known assets selected by 'subtype', 'name' (regex) or 'parent' into maintenance
+// expiration is optional, a number or ttl=<seconds>
+// reply is OK/count/asset1/result1/.../assetN/resultN, where result is OK or ERROR
+static void s_osrv_handle_maintenance_select(s_osrv_t* self, zmsg_t* msg, zmsg_t* reply)
+{
+    int mode;
+    if (!s_osrv_maintenance_parse_mode(msg, reply, &mode))
+        return;
+
+    char* selector = zmsg_popstr(msg);
+    char* value    = zmsg_popstr(msg);
+    char* ttl      = zmsg_popstr(msg);
+
+    int expiration_ttl = int(self->default_maintenance_expiration);
+    if (ttl)
+        expiration_ttl = s_is_number(ttl) ? atoi(ttl) : s_osrv_maintenance_ttl_mark(ttl);
+
+    std::vector<std::string> selected;
+    if (!selector || !value || data_select(self->assets, selector, value, selected) != 0) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Invalid selector");
+    } else if (expiration_ttl < 0) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Invalid expiration");
+    } else {
+        logInfo("outage: maintenance mode {}able for {} assets selected by {} '{}'",
+            (mode == ENABLE_MAINTENANCE) ? "en" : "dis", selected.size(), selector, value);
+        zmsg_addstr(reply, "OK");
+        zmsg_addstrf(reply, "%zu", selected.size());
+        for (const auto& asset : selected) {
+            int rv = s_osrv_maintenance_mode(self, asset.c_str(), mode, expiration_ttl);
+            zmsg_addstr(reply, asset.c_str());
+            zmsg_addstr(reply, rv == 0 ? "OK" : "ERROR");
+        }
+    }
+
+    zstr_free(&selector);
+    zstr_free(&value);
+    zstr_free(&ttl);
+}
+
+// get snapshot 'id' to continue paging, or a recent one for 'id' == 0
+// return NULL, if snapshot 'id' is not available anymore
+static osrv_snapshot_t* s_osrv_snapshot(s_osrv_t* self, uint64_t id)
+{
+    assert(self);
+
+    if (id != 0) {
+        if (self->snapshot && self->snapshot->id == id)
+            return self->snapshot;
+        if (self->previous_snapshot && self->previous_snapshot->id == id)
+            return self->previous_snapshot;
+        return NULL;
+    }
+
+    uint64_t now_ms = uint64_t(vclock_mono(self->assets->clock));
+    if (self->snapshot && now_ms - self->snapshot->taken_ms < SNAPSHOT_MAX_AGE_MS)
+        return self->snapshot;
+
+    // keep the previous snapshot, so clients paging through it can finish
+    osrv_snapshot_t* snapshot = new osrv_snapshot_t();
+    snapshot->id              = self->snapshot ? self->snapshot->id + 1 : 1;
+    snapshot->taken_ms        = now_ms;
+    snapshot->rows            = data_snapshot(self->assets, vclock_time_sec(self->assets->clock));
+    for (size_t i = 0; i < snapshot->rows.size(); i++) {
+        asset_status_t& row = snapshot->rows[i];
+        row.alert           = zhash_lookup(self->active_alerts, row.name.c_str()) != NULL;
+        if (row.dead)
+            snapshot->dead.push_back(i);
+        if (row.maintenance_until_sec != 0)
+            snapshot->maintenance.push_back(i);
+        if (row.flags & EXPIRATION_FLAG_FLAPPING)
+            snapshot->flapping.push_back(i);
+    }
+    logDebug("outage: snapshot {} taken, {} assets", snapshot->id, snapshot->rows.size());
+
+    delete self->previous_snapshot;
+    self->previous_snapshot = self->snapshot;
+    self->snapshot          = snapshot;
+    return snapshot;
+}
+
+// asset/state/alert/flapping/last_seen/expires_at/maintenance_until
+static void s_osrv_add_status(zmsg_t* reply, const asset_status_t& status)
+{
+    zmsg_addstr(reply, status.name.c_str());
+    zmsg_addstr(reply, status.maintenance_until_sec != 0 ? "maintenance" : (status.dead ? "dead" : "alive"));
+    zmsg_addstr(reply, status.alert ? "ACTIVE" : "RESOLVED");
+    zmsg_addstr(reply, (status.flags & EXPIRATION_FLAG_FLAPPING) ? "1" : "0");
+    zmsg_addstr(reply, std::to_string(status.last_seen_sec).c_str());
+    zmsg_addstr(reply, std::to_string(status.expires_at_sec).c_str());
+    zmsg_addstr(reply, std::to_string(status.maintenance_until_sec).c_str());
+}
+
+// * REQUEST/'msg-correlation-id'/STATUS/asset
+// reply is OK/asset/state/alert/flapping/last_seen/expires_at/maintenance_until
+static void s_osrv_handle_status(s_osrv_t* self, zmsg_t* msg, zmsg_t* reply)
+{
+    char*          asset = zmsg_popstr(msg);
+    asset_status_t status;
+    if (!asset || data_get_status(self->assets, asset, vclock_time_sec(self->assets->clock), status) != 0) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Unknown asset");
+    } else {
+        status.alert = zhash_lookup(self->active_alerts, asset) != NULL;
+        zmsg_addstr(reply, "OK");
+        s_osrv_add_status(reply, status);
+    }
+    zstr_free(&asset);
+}
+
+// * REQUEST/'msg-correlation-id'/AVAILABILITY/asset
+// reply is OK/asset/[window/percent/outage/observed]*, for windows 1h, 24h and 30d, times in seconds
+static void s_osrv_handle_availability(s_osrv_t* self, zmsg_t* msg, zmsg_t* reply)
+{
+    char*                 asset = zmsg_popstr(msg);
+    availability_report_t reports[AVAILABILITY_WINDOWS];
+    if (!asset ||
+        data_get_availability(self->assets, asset, vclock_time_sec(self->assets->clock), reports) != 0) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Unknown asset");
+    } else {
+        zmsg_addstr(reply, "OK");
+        zmsg_addstr(reply, asset);
+        for (int w = 0; w < AVAILABILITY_WINDOWS; w++) {
+            zmsg_addstr(reply, availability_window_str(w));
+            zmsg_addstr(reply, s_osrv_percent(reports[w].percent).c_str());
+            zmsg_addstr(reply, std::to_string(reports[w].outage_sec).c_str());
+            zmsg_addstr(reply, std::to_string(reports[w].observed_sec).c_str());
+        }
+    }
+    zstr_free(&asset);
+}
+
+// * REQUEST/'msg-correlation-id'/DEBUG_ASSET/<enable|disable>/asset1/.../assetN - log events of the assets done
+// for each metric (received metrics, dead checks) on info level, in release builds too
+// reply is OK
+static void s_osrv_handle_debug_asset(s_osrv_t* self, zmsg_t* msg, zmsg_t* reply)
+{
+    char* mode = zmsg_popstr(msg);
+    if (!mode || !(streq(mode, "enable") || streq(mode, "disable"))) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Unsupported debug mode");
+    } else {
+        for (char* asset = zmsg_popstr(msg); asset != NULL; asset = zmsg_popstr(msg)) {
+            data_set_debug_asset(self->assets, asset, streq(mode, "enable"));
+            logInfo("outage: debug logging {}d for asset '{}'", mode, asset);
+            zstr_free(&asset);
+        }
+        zmsg_addstr(reply, "OK");
+    }
+    zstr_free(&mode);
+}
+
+// * REQUEST/'msg-correlation-id'/COUNT
+// reply is OK/tracked/N/dead/N/maintenance/N/flapping/N/alerts/N
+static void s_osrv_handle_count(s_osrv_t* self, zmsg_t* reply)
+{
+    osrv_snapshot_t* snapshot = s_osrv_snapshot(self, 0);
+    zmsg_addstr(reply, "OK");
+    zmsg_addstr(reply, "tracked");
+    zmsg_addstr(reply, std::to_string(snapshot->rows.size()).c_str());
+    zmsg_addstr(reply, "dead");
+    zmsg_addstr(reply, std::to_string(snapshot->dead.size()).c_str());
+    zmsg_addstr(reply, "maintenance");
+    zmsg_addstr(reply, std::to_string(snapshot->maintenance.size()).c_str());
+    zmsg_addstr(reply, "flapping");
+    zmsg_addstr(reply, std::to_string(snapshot->flapping.size()).c_str());
+    zmsg_addstr(reply, "alerts");
+    zmsg_addstr(reply, std::to_string(zhash_size(self->active_alerts)).c_str());
+}
+
+// * REQUEST/'msg-correlation-id'/LIST/<ALL|DEAD|MAINTENANCE|FLAPPING>/snapshot/offset/limit
+// 'snapshot' is 0 (or missing) for a new listing, to get next pages use the one from the reply
+// reply is OK/snapshot/total/next_offset/[asset/state/alert/flapping/last_seen/expires_at/maintenance_until]*
+// where 'next_offset' is empty on the last page
+static void s_osrv_handle_list(s_osrv_t* self, zmsg_t* msg, zmsg_t* reply)
+{
+    char* kind     = zmsg_popstr(msg);
+    char* id_str   = zmsg_popstr(msg);
+    char* offset_s = zmsg_popstr(msg);
+    char* limit_s  = zmsg_popstr(msg);
+
+    uint64_t id     = id_str ? uint64_t(strtoull(id_str, NULL, 10)) : 0;
+    size_t   offset = offset_s ? size_t(strtoull(offset_s, NULL, 10)) : 0;
+    size_t   limit  = limit_s ? size_t(strtoull(limit_s, NULL, 10)) : LIST_DEFAULT_LIMIT;
+    if (limit == 0 || limit > LIST_MAX_LIMIT)
+        limit = LIST_MAX_LIMIT;
+
+    osrv_snapshot_t* snapshot = s_osrv_snapshot(self, id);
+    if (!kind || !(streq(kind, "ALL") || streq(kind, "DEAD") || streq(kind, "MAINTENANCE") ||
+                     streq(kind, "FLAPPING"))) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Invalid list");
+    } else if (!snapshot) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Snapshot expired");
+    } else {
+        const std::vector<size_t>* index = NULL;
+        if (streq(kind, "DEAD"))
+            index = &snapshot->dead;
+        else if (streq(kind, "MAINTENANCE"))
+            index = &snapshot->maintenance;
+        else if (streq(kind, "FLAPPING"))
+            index = &snapshot->flapping;
+
+        size_t total = index ? index->size() : snapshot->rows.size();
+        offset       = std::min(offset, total);
+        size_t end   = offset + std::min(limit, total - offset);
+
+        zmsg_addstr(reply, "OK");
+        zmsg_addstr(reply, std::to_string(snapshot->id).c_str());
+        zmsg_addstr(reply, std::to_string(total).c_str());
+        zmsg_addstr(reply, end < total ? std::to_string(end).c_str() : "");
+        for (size_t i = offset; i < end; i++)
+            s_osrv_add_status(reply, snapshot->rows[index ? (*index)[i] : i]);
+    }
+
+    zstr_free(&kind);
+    zstr_free(&id_str);
+    zstr_free(&offset_s);
+    zstr_free(&limit_s);
+}
+
+// * REQUEST/'msg-correlation-id'/HISTORY/asset/from/to
+// 'from' and 'to' are unix time (sec.), missing for the whole history
+// reply is OK/[start/end/cause]*, oldest outage first, 'end' is 0 and 'cause' is 'ongoing' for outage not over
+static void s_osrv_handle_history(s_osrv_t* self, zmsg_t* msg, zmsg_t* reply)
+{
+    char* asset  = zmsg_popstr(msg);
+    char* from_s = zmsg_popstr(msg);
+    char* to_s   = zmsg_popstr(msg);
+
+    if (!self->history) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "History is not enabled");
+    } else if (!asset || streq(asset, "")) {
+        zmsg_addstr(reply, "ERROR");
+        zmsg_addstr(reply, "Missing asset");
+    } else {
+        int64_t from = from_s ? int64_t(strtoll(from_s, NULL, 10)) : 0;
+        int64_t to   = to_s ? int64_t(strtoll(to_s, NULL, 10)) : INT64_MAX;
+        zmsg_addstr(reply, "OK");
+        for (const auto& outage : history_query(self->history, asset, from, to)) {
+            zmsg_addstr(reply, std::to_string(outage.start_sec).c_str());
+            zmsg_addstr(reply, std::to_string(outage.end_sec).c_str());
+            zmsg_addstr(reply, history_cause_str(outage.cause));
+        }
+    }
+
+    zstr_free(&asset);
+    zstr_free(&from_s);
+    zstr_free(&to_s);
+}
+
+static void fty_outage_handle_mailbox(s_osrv_t* self, const osrv_message_t& context, zmsg_t** msg)
 {
     if (self->verbose)
         zmsg_print(*msg);
     if (msg && *msg) {
-        char* message_type = zmsg_popstr(*msg);
+        // header frames are compared in place, sender and subject of the context stay valid until the reply is sent
+        zframe_t* message_type = zmsg_pop(*msg);
         if (!message_type) {
             logWarn("Expected message of type REQUEST");
             return;
         }
-        char* zuuid = zmsg_popstr(*msg);
+        zframe_t* zuuid = zmsg_pop(*msg);
         if (!zuuid) {
             logWarn("Expected zuuid");
-            zstr_free(&message_type);
+            zframe_destroy(&message_type);
             return;
         }
-        char* command = zmsg_popstr(*msg);
-        char* sender  = strdup(mlm_client_sender(self->client));
-        char* subject = strdup(mlm_client_subject(self->client));
+        zframe_t* command = zmsg_pop(*msg);
 
         // message model always enforce reply
         zmsg_t* reply = zmsg_new();
-        zmsg_addstr(reply, zuuid);
+        zmsg_append(reply, &zuuid);
         zmsg_addstr(reply, "REPLY");
 
-        if (streq(message_type, "REQUEST")) {
+        if (zframe_streq(message_type, "REQUEST")) {
             if (!command) {
                 logWarn("Expected command");
-                zstr_free(&zuuid);
-                zstr_free(&message_type);
                 zmsg_addstr(reply, "ERROR");
                 zmsg_addstr(reply, "Missing command");
-            } else if (streq(command, "MAINTENANCE_MODE")) {
-                // * REQUEST/'msg-correlation-id'/MAINTENANCE_MODE/<mode>/asset1/.../assetN/expiration - switch 'asset1'
-                // to 'assetN' into maintenance ex: bmsg request fty-outage GET REQUEST 1234 MAINTENANCE_MODE enable
-                // ups-9 3600
-
-                // look for expiration_ttl
-                int       expiration_ttl = int(self->default_maintenance_expiration);
-                zframe_t* last_frame     = zmsg_last(*msg);
-                char*     last_str       = NULL;
-                if (last_frame) {
-                    last_str = zframe_strdup(last_frame);
-                    logDebug("last_str: {}", last_str);
-                    // '-' means that it's asset name, otherwise the expiration TTL
-                    if (strchr(last_str, '-') == NULL)
-                        expiration_ttl = atoi(last_str);
-                    zstr_free(&last_str);
-                }
-
-                // look for mode 'enable' or 'disable'
-                char* mode_str = zmsg_popstr(*msg);
-                int   mode     = ENABLE_MAINTENANCE;
-
-                if (mode_str) {
-
-                    logDebug("Maintenance mode: {}", mode_str);
-
-                    if ((streq(mode_str, "disable")) || (streq(mode_str, "enable"))) {
-                        if (streq(mode_str, "disable")) {
-                            mode = DISABLE_MAINTENANCE;
-                            // also restore default TTL
-                            expiration_ttl = DEFAULT_ASSET_EXPIRATION_TIME_SEC;
-                        }
-                        // loop on assets...
-                        int   rv          = -1;
-                        char* maint_asset = zmsg_popstr(*msg);
-                        while (maint_asset) {
-                            // trim potential ttl (last frame)
-                            if (strchr(maint_asset, '-') != NULL)
-                                rv = s_osrv_maintenance_mode(self, maint_asset, mode, expiration_ttl);
-
-                            zstr_free(&maint_asset);
-                            maint_asset = zmsg_popstr(*msg);
-                        }
-                        // Process result at the end
-                        if (rv == 0)
-                            zmsg_addstr(reply, "OK");
-                        else {
-                            zmsg_addstr(reply, "ERROR");
-                            zmsg_addstr(reply, "Command failed");
-                        }
-                    } else {
-                        zmsg_addstr(reply, "ERROR");
-                        zmsg_addstr(reply, "Unsupported maintenance mode");
-                        zstr_free(&mode_str);
-                    }
-                    zstr_free(&mode_str);
-                } else {
-                    zmsg_addstr(reply, "ERROR");
-                    zmsg_addstr(reply, "Missing maintenance mode");
-                }
-
+            } else if (zframe_streq(command, "MAINTENANCE_MODE")) {
+                s_osrv_handle_maintenance(self, *msg, reply);
+            } else if (zframe_streq(command, "MAINTENANCE_MODE_SELECT")) {
+                s_osrv_handle_maintenance_select(self, *msg, reply);
+            } else if (zframe_streq(command, "STATUS")) {
+                s_osrv_handle_status(self, *msg, reply);
+            } else if (zframe_streq(command, "AVAILABILITY")) {
+                s_osrv_handle_availability(self, *msg, reply);
+            } else if (zframe_streq(command, "DEBUG_ASSET")) {
+                s_osrv_handle_debug_asset(self, *msg, reply);
+            } else if (zframe_streq(command, "COUNT")) {
+                s_osrv_handle_count(self, reply);
+            } else if (zframe_streq(command, "LIST")) {
+                s_osrv_handle_list(self, *msg, reply);
+            } else if (zframe_streq(command, "HISTORY")) {
+                s_osrv_handle_history(self, *msg, reply);
+            } else if (zframe_streq(command, "STATS")) {
+                // * REQUEST/'msg-correlation-id'/STATS - runtime statistics of the agent
+                // reply is OK/name1/value1/.../nameN/valueN
+                stats_set(self->assets->stats, STATS_ASSETS_TRACKED, zhashx_size(self->assets->assets));
+                stats_set(self->assets->stats, STATS_ALERTS_TRACKED, zhash_size(self->active_alerts));
+                zmsg_addstr(reply, "OK");
+                stats_add_to_msg(self->assets->stats, reply);
+            } else if (zframe_streq(command, "LATENCY")) {
+                // * REQUEST/'msg-correlation-id'/LATENCY[/RESET] - latency distributions, in microseconds
+                // reply is OK/[name/count/p50/p99/max]*, RESET starts the distributions again
+                char* reset = zmsg_popstr(*msg);
+                zmsg_addstr(reply, "OK");
+                stats_add_latency_to_msg(self->assets->stats, reply, reset && streq(reset, "RESET"));
+                zstr_free(&reset);
+            } else if (zframe_streq(command, "FLAPPING")) {
+                // * REQUEST/'msg-correlation-id'/FLAPPING - list assets whose alert state is damped
+                zmsg_addstr(reply, "OK");
+                for (const auto& asset : data_get_flapping(self->assets))
+                    zmsg_addstr(reply, asset.c_str());
             } else {
                 // command is not expected
-                logWarn("'{}': invalid command", command);
+                char* name = zframe_strdup(command);
+                logWarn("'{}': invalid command", name);
+                zstr_free(&name);
                 zmsg_addstr(reply, "ERROR");
                 zmsg_addstr(reply, "Invalid command");
             }
         } else {
             // message_type is not expected
-            logWarn("'{}': invalid message type", message_type);
+            char* name = zframe_strdup(message_type);
+            logWarn("'{}': invalid message type", name);
+            zstr_free(&name);
             zmsg_addstr(reply, "ERROR");
             zmsg_addstr(reply, "Invalid message type");
         }
@@ -463,22 +1630,162 @@ static void fty_outage_handle_mailbox(s_osrv_t* self, zmsg_t** msg)
         if (self->verbose)
             zmsg_print(reply);
 
-        mlm_client_sendto(self->client, sender, subject, NULL, 5000, &reply);
+        mlm_client_sendto(self->client, context.sender, context.subject, NULL, 5000, &reply);
         if (reply) {
-            logError("Could not send message to {}", mlm_client_sender(self->client));
+            logError("Could not send message to {}", context.sender);
             zmsg_destroy(&reply);
         }
 
-        zstr_free(&subject);
-        zstr_free(&sender);
-        if (command)
-            zstr_free(&command);
-        zstr_free(&zuuid);
-        zstr_free(&message_type);
+        zframe_destroy(&command);
+        zframe_destroy(&message_type);
         zmsg_destroy(msg);
     }
 }
 
+// count message received on 'context'
+static void s_osrv_count_message(s_osrv_t* self, const osrv_message_t& context)
+{
+    stats_t*    stats   = self->assets->stats;
+    const char* address = context.address;
+
+    if (streq(context.command, "MAILBOX DELIVER"))
+        stats_inc(stats, STATS_MSG_MAILBOX);
+    else if (streq(address, FTY_PROTO_STREAM_METRICS))
+        stats_inc(stats, STATS_MSG_METRICS);
+    else if (streq(address, FTY_PROTO_STREAM_METRICS_SENSOR))
+        stats_inc(stats, STATS_MSG_METRICS_SENSOR);
+    else if (streq(address, FTY_PROTO_STREAM_METRICS_UNAVAILABLE))
+        stats_inc(stats, STATS_MSG_METRICS_UNAVAILABLE);
+    else if (streq(address, FTY_PROTO_STREAM_ASSETS))
+        stats_inc(stats, STATS_MSG_ASSETS);
+    else
+        stats_inc(stats, STATS_MSG_OTHER);
+}
+
+// copy asset of 'topic' frame in form aaaa@bbb into 'source' buffer of 'size' bytes
+// return false, if the frame is missing or the topic is malformed
+static bool s_osrv_topic_asset(zframe_t* topic, char* source, size_t size)
+{
+    if (!topic)
+        return false;
+    const char* data = reinterpret_cast<const char*>(zframe_data(topic));
+    const char* at   = reinterpret_cast<const char*>(memchr(data, '@', zframe_size(topic)));
+    if (!at)
+        return false;
+    size_t length = zframe_size(topic) - size_t(at + 1 - data);
+    if (length == 0 || length >= size)
+        return false;
+    memcpy(source, at + 1, length);
+    source[length] = '\0';
+    return true;
+}
+
+// handle 'message' received on 'context', from malamute or from a replayed trace
+static void s_osrv_handle_message(s_osrv_t* self, const osrv_message_t& context, zmsg_t** message_p)
+{
+    assert(self);
+    assert(message_p && *message_p);
+
+    histogram_timer_t timer(stats_histogram(self->assets->stats, STATS_LATENCY_STREAM_MESSAGE));
+    zmsg_t*           message = *message_p;
+    *message_p                = NULL;
+    s_osrv_count_message(self, context);
+
+    if (!fty_proto_is(message)) {
+        if (streq(context.address, FTY_PROTO_STREAM_METRICS_UNAVAILABLE)) {
+            zframe_t* frame = zmsg_pop(message);
+            char      source[256];
+            if (frame && zframe_streq(frame, "METRICUNAVAILABLE")) {
+                zframe_destroy(&frame);
+                frame = zmsg_pop(message); // topic in form aaaa@bbb
+                if (s_osrv_topic_asset(frame, source, sizeof(source)))
+                    s_osrv_delete_asset(self, source);
+                else
+                    logLimited(logWarn, "Malformed topic of METRICUNAVAILABLE message");
+            }
+            zframe_destroy(&frame);
+        } else if (streq(context.command, "MAILBOX DELIVER")) {
+            // someone is addressing us directly
+            logDebug("{}: MAILBOX DELIVER", __func__);
+            fty_outage_handle_mailbox(self, context, &message);
+        }
+        zmsg_destroy(&message);
+        return;
+    }
+
+    fty_proto_t* bmsg = fty_proto_decode(&message);
+    if (!bmsg) {
+        stats_inc(self->assets->stats, STATS_DECODE_FAILURES);
+        return;
+    }
+    if (fty_proto_id(bmsg) == FTY_PROTO_METRIC)
+        s_osrv_ingest_lag(self, fty_proto_time(bmsg));
+
+    // sign of life of the asset
+    if (fty_proto_id(bmsg) == FTY_PROTO_METRIC || streq(context.address, FTY_PROTO_STREAM_METRICS_SENSOR)) {
+        s_osrv_ingest_metric(
+            self, s_osrv_metric(bmsg), OSRV_LIVENESS_STREAM, streq(context.address, FTY_PROTO_STREAM_METRICS_SENSOR));
+    } else if (fty_proto_id(bmsg) == FTY_PROTO_ASSET) {
+        // deleted, not active, or not monitored by the policy any more
+        if (streq(fty_proto_operation(bmsg), FTY_PROTO_ASSET_OP_DELETE) ||
+            !streq(fty_proto_aux_string(bmsg, FTY_PROTO_ASSET_STATUS, "active"), "active") ||
+            !data_monitored(self->assets, bmsg)) {
+            const char* source = fty_proto_name(bmsg);
+            s_osrv_resolve_alert(self, source, HISTORY_REMOVED);
+            s_osrv_withdraw_status(self, source);
+        }
+        if (self->replica_role == OSRV_REPLICA_LEADER) {
+            fty_proto_t* copy = fty_proto_dup(bmsg);
+            zmsg_t*      msg  = fty_proto_encode(&copy);
+            zmsg_pushstr(msg, "ASSET");
+            s_osrv_replicate_msg(self, &msg);
+        }
+        data_put(self->assets, &bmsg);
+    }
+    fty_proto_destroy(&bmsg);
+}
+
+// feed trace 'path' through the handlers, time of the records is simulated
+// 'speed' scales the pauses between the records, 0 replays them as fast as possible
+// return number of replayed records, -1 if the trace can't be read
+static int64_t s_osrv_replay(s_osrv_t* self, const char* path, double speed)
+{
+    assert(self);
+
+    FILE* trace = capture_open(path);
+    if (!trace)
+        return -1;
+
+    vclock_t*        clock   = self->assets->clock;
+    capture_record_t record  = {};
+    int64_t          records = 0;
+    while (capture_read(trace, record) == 0) {
+        if (records == 0)
+            vclock_simulate(clock, record.time_ms);
+        int64_t pause_ms = record.time_ms - vclock_time(clock);
+        if (pause_ms > 0) {
+            if (speed > 0)
+                zclock_sleep(int(double(pause_ms) / speed));
+            vclock_advance(clock, pause_ms);
+            s_osrv_run_timers(self, false);
+        }
+
+        if (record.kind == CAPTURE_MESSAGE) {
+            osrv_message_t context = {
+                record.command.c_str(), record.address.c_str(), record.sender.c_str(), record.subject.c_str()};
+            s_osrv_handle_message(self, context, &record.content);
+        } else if (record.kind == CAPTURE_METRICS) {
+            fty::shm::shmMetrics metrics;
+            capture_record_metrics(record, metrics);
+            s_osrv_ingest_shm(self, {&metrics});
+        }
+        records++;
+    }
+    zmsg_destroy(&record.content);
+    fclose(trace);
+    return records;
+}
+
 // --------------------------------------------------------------------------
 // Create a new fty_outage_server
 void fty_outage_server(zsock_t* pipe, void* /*args*/)
@@ -492,14 +1799,17 @@ void fty_outage_server(zsock_t* pipe, void* /*args*/)
     zsock_signal(pipe, 0);
     logInfo("outage_actor: Started");
     //    poller timeout
-    uint64_t now_ms             = uint64_t(zclock_mono());
-    uint64_t last_dead_check_ms = now_ms;
-    uint64_t last_save_ms       = now_ms;
-
-    zactor_t* metric_poll = zactor_new(outage_metric_polling, self);
+    uint64_t now_ms          = uint64_t(vclock_mono(self->assets->clock));
+    self->last_dead_check_ms = now_ms;
+    self->last_save_ms       = now_ms;
+    self->last_stats_ms      = now_ms;
+
+    self->metric_poll = zactor_new(outage_metric_polling, self->assets->stats);
+    zpoller_add(poller, self->metric_poll);
+    self->replica = zactor_new(outage_replica, self->assets->clock);
+    zpoller_add(poller, self->replica);
     while (!zsys_interrupted) {
-        self->timeout_ms = uint64_t(fty_get_polling_interval() * 1000);
-        void* which      = zpoller_wait(poller, int(self->timeout_ms));
+        void* which = zpoller_wait(poller, int(self->timeout_ms));
 
         if (which == NULL) {
             if (zpoller_terminated(poller) || zsys_interrupted) {
@@ -508,21 +1818,8 @@ void fty_outage_server(zsock_t* pipe, void* /*args*/)
             }
         }
 
-        now_ms = uint64_t(zclock_mono());
-
-        // save the state
-        if ((now_ms - last_save_ms) > SAVE_INTERVAL_MS) {
-            int r = s_osrv_save(self);
-            if (r != 0)
-                logError("failed to save state file {}", self->state_file);
-            last_save_ms = now_ms;
-        }
-
-        // send alerts
-        if (zpoller_expired(poller) || (now_ms - last_dead_check_ms) > self->timeout_ms) {
-            s_osrv_check_dead_devices(self);
-            last_dead_check_ms = uint64_t(zclock_mono());
-        }
+        // simulated time moves only when advanced
+        s_osrv_run_timers(self, zpoller_expired(poller) && !self->assets->clock->simulated.load());
 
         if (which == pipe) {
             logTrace("which == pipe");
@@ -530,98 +1827,46 @@ void fty_outage_server(zsock_t* pipe, void* /*args*/)
             if (!msg)
                 break;
 
-            int rv = s_osrv_actor_commands(self, &msg);
+            int rv = s_osrv_actor_commands(self, pipe, &msg);
             if (rv == 1)
                 break;
             continue;
         }
         // react on incoming messages
         else if (which == mlm_client_msgpipe(self->client)) {
-            logTrace("which == mlm_client_msgpipe");
+            logHot("which == mlm_client_msgpipe");
 
             zmsg_t* message = mlm_client_recv(self->client);
             if (!message)
                 break;
-
-            if (!fty_proto_is(message)) {
-                if (streq(mlm_client_address(self->client), FTY_PROTO_STREAM_METRICS_UNAVAILABLE)) {
-                    char* foo = zmsg_popstr(message);
-                    if (foo && streq(foo, "METRICUNAVAILABLE")) {
-                        zstr_free(&foo);
-                        foo                = zmsg_popstr(message); // topic in form aaaa@bbb
-                        const char* source = strstr(foo, "@") + 1;
-                        s_osrv_resolve_alert(self, source);
-                        data_delete(self->assets, source);
-                    }
-                    zstr_free(&foo);
-                } else if (streq(mlm_client_command(self->client), "MAILBOX DELIVER")) {
-                    // someone is addressing us directly
-                    logDebug("{}: MAILBOX DELIVER", __func__);
-                    fty_outage_handle_mailbox(self, &message);
-                }
-                zmsg_destroy(&message);
-                continue;
-            }
-
-            fty_proto_t* bmsg = fty_proto_decode(&message);
-            if (!bmsg)
-                continue;
-
-            // resolve sent alert
-            if (fty_proto_id(bmsg) == FTY_PROTO_METRIC ||
-                streq(mlm_client_address(self->client), FTY_PROTO_STREAM_METRICS_SENSOR)) {
-                const char* is_computed = fty_proto_aux_string(bmsg, "x-cm-count", NULL);
-                if (!is_computed) {
-                    uint64_t    now_sec   = uint64_t(zclock_time() / 1000);
-                    uint64_t    timestamp = fty_proto_time(bmsg);
-                    const char* port      = fty_proto_aux_string(bmsg, FTY_PROTO_METRICS_SENSOR_AUX_PORT, NULL);
-
-                    if (port != NULL) {
-                        // is it from sensor? yes
-                        // get sensors attached to the 'asset' on the 'port'! we can have more then 1!
-                        const char* source = fty_proto_aux_string(bmsg, FTY_PROTO_METRICS_SENSOR_AUX_SNAME, NULL);
-                        if (NULL == source) {
-                            logError("Sensor message malformed: found {}='{}' but {} is missing",
-                                FTY_PROTO_METRICS_SENSOR_AUX_PORT, port, FTY_PROTO_METRICS_SENSOR_AUX_SNAME);
-                            continue;
-                        }
-                        logDebug("Sensor '{}' on '{}'/'{}' is still alive", source, fty_proto_name(bmsg), port);
-                        s_osrv_resolve_alert(self, source);
-                        int rv = data_touch_asset(self->assets, source, timestamp, fty_proto_ttl(bmsg), now_sec);
-                        if (rv == -1)
-                            logError("asset: name = {}, topic={} metric is from future! ignore it", source,
-                                mlm_client_subject(self->client));
-                    } else {
-                        // is it from sensor? no
-                        const char* source = fty_proto_name(bmsg);
-                        s_osrv_resolve_alert(self, source);
-                        const char* operation = fty_proto_operation(bmsg);
-                        // hotfix IPMVAL-2713: filter inventory message from sensors which cause the 'outage' alert
-                        // activation/deactivation.
-                        if (!streq(mlm_client_address(self->client), FTY_PROTO_STREAM_METRICS_SENSOR) ||
-                            ((NULL == operation) || !streq(operation, FTY_PROTO_ASSET_OP_INVENTORY))) {
-                            int rv = data_touch_asset(self->assets, source, timestamp, fty_proto_ttl(bmsg), now_sec);
-                            if (rv == -1)
-                                logError("asset: name = {}, topic={} metric is from future! ignore it", source,
-                                    mlm_client_subject(self->client));
-                        }
-                    }
-                } else {
-                    // intentionally left empty
-                    // so it is metric from agent-cm -> it is not comming from the device itself ->ignore it
-                }
-            } else if (fty_proto_id(bmsg) == FTY_PROTO_ASSET) {
-                if (streq(fty_proto_operation(bmsg), FTY_PROTO_ASSET_OP_DELETE) ||
-                    !streq(fty_proto_aux_string(bmsg, FTY_PROTO_ASSET_STATUS, "active"), "active")) {
-                    const char* source = fty_proto_name(bmsg);
-                    s_osrv_resolve_alert(self, source);
-                }
-                data_put(self->assets, &bmsg);
+            osrv_message_t context = {mlm_client_command(self->client), mlm_client_address(self->client),
+                mlm_client_sender(self->client), mlm_client_subject(self->client)};
+            capture_message(self->capture, vclock_time(self->assets->clock), context.command, context.address,
+                context.sender, context.subject, message);
+            s_osrv_ingest_backlog(self);
+            s_osrv_handle_message(self, context, &message);
+        }
+        // metrics read from fty_shm, processed here with the stream ones
+        else if (which == self->metric_poll) {
+            char*               command = NULL;
+            shmreader_result_t* metrics = NULL;
+            if (zsock_recv(self->metric_poll, "sp", &command, &metrics) == 0 && metrics) {
+                capture_metrics(self->capture, vclock_time(self->assets->clock), *metrics);
+                s_osrv_ingest_shm(self, *metrics);
+                shmreader_result_clear(*metrics);
             }
-            fty_proto_destroy(&bmsg);
+            delete metrics;
+            zstr_free(&command);
+        }
+        // changes of the state from the leader, or requests to send them to the standby
+        else if (which == self->replica) {
+            zmsg_t* msg = zmsg_recv(self->replica);
+            if (msg)
+                s_osrv_handle_replica(self, &msg);
         }
     }
-    zactor_destroy(&metric_poll);
+    zactor_destroy(&self->replica);
+    zactor_destroy(&self->metric_poll);
     zpoller_destroy(&poller);
     int r = s_osrv_save(self);
     if (r != 0) {
@@ -21,16 +21,50 @@
 
 
 #include "fty-outage.h"
+#include <csignal>
+#include <pthread.h>
 #include <fty_log.h>
 #include <fty_proto.h>
 
 static const char* CONFIG = "/etc/fty-outage/fty-outage.cfg";
 
+// SIGHUP asks for reloading of the configuration
+static volatile sig_atomic_t s_reload = 0;
+
+static void s_handle_sighup(int /*signum*/)
+{
+    s_reload = 1;
+}
+
+// apply logging configuration from 'cfg'
+static void s_configure_log(zconfig_t* cfg, bool verbose)
+{
+    const char* logConfigFile = cfg ? zconfig_get(cfg, "log/config", "") : "";
+    // If a log config file is configured, try to load it
+    if (!streq(logConfigFile, "")) {
+        logDebug("Try to load log configuration file : {}", logConfigFile);
+        ftylog_setConfigFile(ftylog_getInstance(), logConfigFile);
+    }
+
+    if (verbose) {
+        ftylog_setVeboseMode(ftylog_getInstance());
+    }
+}
+
 int main(int argc, char* argv[])
 {
-    const char* logConfigFile          = "";
-    const char* maintenance_expiration = "";
-    const char* config_file            = CONFIG;
+    const char* trace_file   = "";
+    const char* capture_file = "";
+    const char* shm_readers  = DEFAULT_SHM_READERS;
+    const char* history_file = DEFAULT_HISTORY_FILE;
+    const char* history_size = DEFAULT_HISTORY_SIZE;
+    const char* endpoint     = DEFAULT_MALAMUTE_ENDPOINT;
+    const char* address      = DEFAULT_MALAMUTE_ADDRESS;
+    const char* state_file   = DEFAULT_STATE_FILE;
+    const char* replica_role = DEFAULT_REPLICA_ROLE;
+    const char* replica_at   = DEFAULT_REPLICA_ENDPOINT;
+    const char* replica_ms   = DEFAULT_REPLICA_LEASE;
+    const char* config_file  = CONFIG;
     ftylog_setInstance("fty-outage", "");
     bool verbose = false;
     int  argn;
@@ -58,32 +92,46 @@ int main(int argc, char* argv[])
         }
     }
 
+    // settings read here need restart, the others are applied by RELOAD, at start and on SIGHUP
     zconfig_t* cfg = zconfig_load(config_file);
     logDebug("Config is {} null", cfg ? "not" : "");
     if (cfg) {
-        logConfigFile = zconfig_get(cfg, "log/config", "");
-
-        // Get maintenance mode TTL
-        maintenance_expiration = zconfig_get(cfg, "server/maintenance_expiration", DEFAULT_MAINTENANCE_EXPIRATION);
+        // Get traces of the agent
+        trace_file   = zconfig_get(cfg, "server/trace_file", trace_file);
+        capture_file = zconfig_get(cfg, "server/capture_file", capture_file);
+
+        // Get how fty_shm is read
+        shm_readers = zconfig_get(cfg, "server/shm_readers", shm_readers);
+
+        // Get where the outages are recorded
+        history_file = zconfig_get(cfg, "server/history_file", history_file);
+        history_size = zconfig_get(cfg, "server/history_size", history_size);
+
+        // Get identity of the agent, so a standby can run next to the leader
+        endpoint   = zconfig_get(cfg, "malamute/endpoint", endpoint);
+        address    = zconfig_get(cfg, "malamute/address", address);
+        state_file = zconfig_get(cfg, "server/state_file", state_file);
+
+        // Get replication of the state to the standby agent
+        replica_role = zconfig_get(cfg, "server/replica_role", replica_role);
+        replica_at   = zconfig_get(cfg, "server/replica_endpoint", replica_at);
+        replica_ms   = zconfig_get(cfg, "server/replica_lease", replica_ms);
     }
 
-    // If a log config file is configured, try to load it
-    if (!streq(logConfigFile, "")) {
-        logDebug("Try to load log configuration file : {}", logConfigFile);
-        ftylog_setConfigFile(ftylog_getInstance(), logConfigFile);
-    }
+    s_configure_log(cfg, verbose);
 
-    if (verbose) {
-        ftylog_setVeboseMode(ftylog_getInstance());
-    }
+    // threads of the actors inherit SIGHUP blocked, so it interrupts only the wait below
+    sigset_t sighup;
+    sigemptyset(&sighup);
+    sigaddset(&sighup, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &sighup, NULL);
 
     // FIXME: use agent name from fty-common
     zactor_t* server = zactor_new(fty_outage_server, const_cast<char*>("outage"));
     //  Insert main code here
 
-    zstr_sendx(server, "STATE-FILE", "/var/lib/fty/fty-outage/state.zpl", NULL);
-    zstr_sendx(server, "TIMEOUT", "30000", NULL);
-    zstr_sendx(server, "CONNECT", "ipc://@/malamute", "fty-outage", NULL);
+    zstr_sendx(server, "STATE-FILE", state_file, NULL);
+    zstr_sendx(server, "CONNECT", endpoint, address, NULL);
     zstr_sendx(server, "PRODUCER", FTY_PROTO_STREAM_ALERTS_SYS, NULL);
     // zstr_sendx (server, "CONSUMER", FTY_PROTO_STREAM_METRICS, ".*", NULL);
     zstr_sendx(server, "CONSUMER", FTY_PROTO_STREAM_METRICS_UNAVAILABLE, ".*", NULL);
@@ -91,19 +139,48 @@ int main(int argc, char* argv[])
     zstr_sendx(server, "CONSUMER", FTY_PROTO_STREAM_ASSETS, ".*", NULL);
     if (verbose)
         zstr_send(server, "VERBOSE");
-    zstr_sendx(server, "DEFAULT_MAINTENANCE_EXPIRATION", maintenance_expiration, NULL);
-
-    // src/malamute.c, under MPL license
-    while (true) {
-        char* str = zstr_recv(server);
-        if (str) {
+    if (cfg)
+        zstr_sendx(server, "RELOAD", config_file, NULL);
+    zstr_sendx(server, "SHM-READERS", shm_readers, NULL);
+    if (!streq(history_file, ""))
+        zstr_sendx(server, "HISTORY-FILE", history_file, history_size, NULL);
+    if (!streq(trace_file, ""))
+        zstr_sendx(server, "TRACE-FILE", trace_file, NULL);
+    if (!streq(capture_file, ""))
+        zstr_sendx(server, "CAPTURE", capture_file, NULL);
+    zstr_sendx(server, "REPLICA", replica_role, replica_at, replica_ms, NULL);
+
+    // the actor is asked to reload the configuration on SIGHUP, which interrupts the wait
+    signal(SIGHUP, s_handle_sighup);
+    pthread_sigmask(SIG_UNBLOCK, &sighup, NULL);
+    zpoller_t* poller = zpoller_new(server, NULL);
+    while (!zsys_interrupted) {
+        void* which = zpoller_wait(poller, 1000);
+        if (s_reload) {
+            s_reload = 0;
+            logInfo("SIGHUP: reloading configuration {}", config_file);
+            zconfig_t* reloaded = zconfig_load(config_file);
+            if (reloaded) {
+                s_configure_log(reloaded, verbose);
+                zconfig_destroy(&cfg);
+                cfg = reloaded;
+            }
+            zstr_sendx(server, "RELOAD", config_file, NULL);
+            continue;
+        }
+        // src/malamute.c, under MPL license
+        if (which == server) {
+            char* str = zstr_recv(server);
+            if (!str)
+                break;
             puts(str);
             zstr_free(&str);
-        } else {
+        } else if (zpoller_terminated(poller)) {
             logInfo("Interrupted ...");
             break;
         }
     }
+    zpoller_destroy(&poller);
     zactor_destroy(&server);
     zconfig_destroy(&cfg);
     return 0;
@@ -27,5 +27,48 @@
 // Default TTL of assets in maintenance mode
 #define DEFAULT_MAINTENANCE_EXPIRATION "3600"
 
+// Default flap damping parameters (see data.h)
+#define DEFAULT_FLAP_HALF_LIFE "900"
+#define DEFAULT_FLAP_SUPPRESS  "2500"
+#define DEFAULT_FLAP_REUSE     "750"
+
+// Default period of checks of dead devices, in seconds
+#define DEFAULT_CHECK_INTERVAL "30"
+
+// Default period of statistics publication, in seconds
+#define DEFAULT_STATS_INTERVAL "60"
+
+// Default lag of metrics from which dead checks are deferred, in milliseconds
+#define DEFAULT_LAG_THRESHOLD "60000"
+
+// Default source of metrics which keep assets alive: shm, stream or hybrid
+#define DEFAULT_LIVENESS_SOURCE "hybrid"
+
+// Default number of threads reading fty_shm, 0 for one per core
+#define DEFAULT_SHM_READERS "0"
+
+// Default file and size (in records) of the outage history, empty file disables the history
+#define DEFAULT_HISTORY_FILE "/var/lib/fty/fty-outage/history.bin"
+#define DEFAULT_HISTORY_SIZE "65536"
+
+// Default detection of correlated outages (see wave.h)
+#define DEFAULT_WAVE_ASSETS   "20"
+#define DEFAULT_WAVE_SHARE    "10"
+#define DEFAULT_WAVE_CHILDREN "5"
+#define DEFAULT_WAVE_HOLD     "300"
+
+// Default lead of device clocks accepted (see data.h)
+#define DEFAULT_MAX_CLOCK_SKEW "60"
+
+// Default malamute connection and state file, standby agent on the same host needs its own ones
+#define DEFAULT_MALAMUTE_ENDPOINT "ipc://@/malamute"
+#define DEFAULT_MALAMUTE_ADDRESS  "fty-outage"
+#define DEFAULT_STATE_FILE        "/var/lib/fty/fty-outage/state.zpl"
+
+// Default replication of the state (see replica.h), none, leader or standby
+#define DEFAULT_REPLICA_ROLE     "none"
+#define DEFAULT_REPLICA_ENDPOINT "ipc://@/fty-outage-replica"
+#define DEFAULT_REPLICA_LEASE    "5000"
+
 #define DISABLE_MAINTENANCE 0
 #define ENABLE_MAINTENANCE  1
@@ -0,0 +1,84 @@
+/*  =========================================================================
+    histogram - Log-linear latency histogram
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "histogram.h"
+#include <algorithm>
+
+//  --------------------------------------------------------------------------
+//  Highest value in the bucket
+uint64_t histogram_bucket_max(size_t bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+        return bucket;
+    size_t   shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t lower = uint64_t(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+//  --------------------------------------------------------------------------
+//  Clear the histogram
+void histogram_reset(histogram_t* self)
+{
+    assert(self);
+    for (auto& bucket : self->buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    self->count.store(0, std::memory_order_relaxed);
+    self->max.store(0, std::memory_order_relaxed);
+}
+
+//  --------------------------------------------------------------------------
+//  Summarize the histogram, values recorded so far are dropped if 'reset' is true
+histogram_summary_t histogram_summary(histogram_t* self, bool reset)
+{
+    assert(self);
+
+    // values recorded meanwhile go either to this summary or to the next one
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+    uint64_t count = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        buckets[i] = reset ? self->buckets[i].exchange(0, std::memory_order_relaxed)
+                           : self->buckets[i].load(std::memory_order_relaxed);
+        count += buckets[i];
+    }
+    uint64_t max = reset ? self->max.exchange(0, std::memory_order_relaxed) : self->max.load(std::memory_order_relaxed);
+    if (reset)
+        self->count.fetch_sub(count, std::memory_order_relaxed);
+
+    histogram_summary_t summary = {count, 0, 0, max};
+    if (count == 0)
+        return summary;
+
+    uint64_t p50_rank = (count + 1) / 2;
+    uint64_t p99_rank = count - count / 100;
+    uint64_t seen     = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (buckets[i] == 0)
+            continue;
+        if (seen < p50_rank && seen + buckets[i] >= p50_rank)
+            summary.p50 = std::min(histogram_bucket_max(i), max);
+        seen += buckets[i];
+        if (seen >= p99_rank) {
+            summary.p99 = std::min(histogram_bucket_max(i), max);
+            break;
+        }
+    }
+    return summary;
+}
@@ -0,0 +1,101 @@
+/*  =========================================================================
+    histogram - Log-linear latency histogram
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <czmq.h>
+
+// each power of two range is split into HISTOGRAM_SUB_BUCKETS linear buckets,
+// so the relative error of a percentile is at most 1 / HISTOGRAM_SUB_BUCKETS
+#define HISTOGRAM_SUB_BITS    3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS     ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+///  Distribution of recorded values, recording is lock and allocation free
+struct histogram_t
+{
+    std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS]; //!< number of values in each bucket
+    std::atomic<uint64_t> count;                      //!< number of recorded values
+    std::atomic<uint64_t> max;                        //!< max recorded value
+};
+
+///  Summary of the distribution
+struct histogram_summary_t
+{
+    uint64_t count; //!< number of recorded values
+    uint64_t p50;   //!< median (upper bound of its bucket)
+    uint64_t p99;   //!< 99th percentile (upper bound of its bucket)
+    uint64_t max;   //!< max recorded value
+};
+
+///  Bucket of the value
+inline size_t histogram_bucket(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return size_t(value);
+    int exponent = 63 - __builtin_clzll(value);
+    int shift    = exponent - HISTOGRAM_SUB_BITS;
+    return size_t(shift + 1) * HISTOGRAM_SUB_BUCKETS + size_t((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+///  Highest value in the bucket
+uint64_t histogram_bucket_max(size_t bucket);
+
+///  Record the value
+inline void histogram_record(histogram_t* self, uint64_t value)
+{
+    self->buckets[histogram_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    self->count.fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = self->max.load(std::memory_order_relaxed);
+    while (value > max && !self->max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+///  Clear the histogram
+void histogram_reset(histogram_t* self);
+
+///  Summarize the histogram, values recorded so far are dropped if 'reset' is true
+histogram_summary_t histogram_summary(histogram_t* self, bool reset);
+
+///  Records duration of the scope in microseconds
+class histogram_timer_t
+{
+public:
+    explicit histogram_timer_t(histogram_t* histogram)
+        : m_histogram(histogram)
+        , m_start_usec(zclock_usecs())
+    {
+    }
+
+    ~histogram_timer_t()
+    {
+        int64_t elapsed_usec = zclock_usecs() - m_start_usec;
+        histogram_record(m_histogram, elapsed_usec > 0 ? uint64_t(elapsed_usec) : 0);
+    }
+
+    histogram_timer_t(const histogram_timer_t&) = delete;
+    histogram_timer_t& operator=(const histogram_timer_t&) = delete;
+
+private:
+    histogram_t* m_histogram;
+    int64_t      m_start_usec;
+};
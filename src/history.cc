@@ -0,0 +1,229 @@
+/*  =========================================================================
+    history - Outage history in memory mapped ring file
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "history.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <fty_log.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(history_header_t) == 64, "history header must not change");
+static_assert(sizeof(history_record_t) == 128, "history record must not change");
+
+// index values are sequence numbers, which are never 0
+#define HISTORY_INDEX_VALUE(seq) reinterpret_cast<void*>(uintptr_t(seq))
+#define HISTORY_INDEX_SEQ(value) uint64_t(reinterpret_cast<uintptr_t>(value))
+
+// record with sequence number 'seq', NULL if it was already overwritten or was not written yet
+static history_record_t* s_history_record(history_t* self, uint64_t seq)
+{
+    if (seq == 0 || seq >= self->header->next_seq)
+        return NULL;
+    history_record_t* record = &self->records[(seq - 1) % self->header->capacity];
+    return record->seq == seq ? record : NULL;
+}
+
+// newest record of 'asset', NULL if there is none
+static history_record_t* s_history_newest(history_t* self, const char* asset)
+{
+    return s_history_record(self, HISTORY_INDEX_SEQ(zhashx_lookup(self->index, asset)));
+}
+
+// asset name as stored in the records
+static void s_history_name(const char* asset, char* name)
+{
+    strncpy(name, asset, HISTORY_NAME_SIZE - 1);
+    name[HISTORY_NAME_SIZE - 1] = '\0';
+}
+
+// index the newest record of each asset still in the ring
+static void s_history_index(history_t* self)
+{
+    uint64_t next_seq = self->header->next_seq;
+    uint64_t capacity = self->header->capacity;
+    for (uint64_t seq = next_seq > capacity ? next_seq - capacity : 1; seq < next_seq; seq++) {
+        history_record_t* record = s_history_record(self, seq);
+        if (record)
+            zhashx_update(self->index, record->asset, HISTORY_INDEX_VALUE(seq));
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Open history file 'path' with room for 'capacity' outages
+history_t* history_new(const char* path, uint64_t capacity)
+{
+    assert(path);
+    if (capacity == 0)
+        capacity = HISTORY_DEFAULT_CAPACITY;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        logError("history: can't open {}: %m", path);
+        return NULL;
+    }
+
+    size_t size = sizeof(history_header_t) + capacity * sizeof(history_record_t);
+    bool   keep = false;
+    {
+        history_header_t header;
+        struct stat      st;
+        keep = fstat(fd, &st) == 0 && size_t(st.st_size) == size &&
+               pread(fd, &header, sizeof(header), 0) == ssize_t(sizeof(header)) &&
+               memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) == 0 &&
+               header.record_size == sizeof(history_record_t) && header.capacity == capacity &&
+               header.next_seq != 0;
+    }
+    if (!keep && (ftruncate(fd, 0) != 0 || ftruncate(fd, off_t(size)) != 0)) {
+        logError("history: can't resize {}: %m", path);
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        logError("history: can't map {}: %m", path);
+        close(fd);
+        return NULL;
+    }
+
+    history_t* self = reinterpret_cast<history_t*>(zmalloc(sizeof(history_t)));
+    self->fd        = fd;
+    self->size      = size;
+    self->header    = reinterpret_cast<history_header_t*>(map);
+    self->records   = reinterpret_cast<history_record_t*>(reinterpret_cast<char*>(map) + sizeof(history_header_t));
+    self->index     = zhashx_new();
+    if (!keep) {
+        // the file was truncated, so the records are zeroed
+        memcpy(self->header->magic, HISTORY_MAGIC, sizeof(self->header->magic));
+        self->header->record_size = sizeof(history_record_t);
+        self->header->capacity    = capacity;
+        self->header->next_seq    = 1;
+        logInfo("history: started {} with room for {} outages", path, capacity);
+    } else
+        s_history_index(self);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the history, flush the file
+void history_destroy(history_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        history_t* self = *self_p;
+        msync(self->header, self->size, MS_SYNC);
+        munmap(self->header, self->size);
+        close(self->fd);
+        zhashx_destroy(&self->index);
+        free(self);
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Record start of outage of 'asset' at 'start_sec'
+void history_begin(history_t* self, const char* asset, int64_t start_sec)
+{
+    assert(self);
+    assert(asset);
+
+    char name[HISTORY_NAME_SIZE];
+    s_history_name(asset, name);
+    history_record_t* newest = s_history_newest(self, name);
+    if (newest && newest->end_sec == 0)
+        return;
+    // the newest record may be the one overwritten now
+    uint64_t prev     = newest ? newest->seq : 0;
+    int64_t  prev_end = newest ? newest->end_sec : 0;
+
+    uint64_t          seq    = self->header->next_seq;
+    history_record_t* record = &self->records[(seq - 1) % self->header->capacity];
+    // the overwritten record may be the only one left of its asset
+    if (record->seq != 0 && HISTORY_INDEX_SEQ(zhashx_lookup(self->index, record->asset)) == record->seq)
+        zhashx_delete(self->index, record->asset);
+
+    memset(record, 0, sizeof(history_record_t));
+    record->prev      = prev;
+    record->start_sec = std::max(start_sec, prev_end);
+    record->cause     = HISTORY_ONGOING;
+    memcpy(record->asset, name, sizeof(name));
+    record->seq            = seq;
+    self->header->next_seq = seq + 1;
+    zhashx_update(self->index, name, HISTORY_INDEX_VALUE(seq));
+}
+
+//  --------------------------------------------------------------------------
+//  Record end of the ongoing outage of 'asset' at 'end_sec' for 'cause'
+int history_end(history_t* self, const char* asset, int64_t end_sec, history_cause_t cause)
+{
+    assert(self);
+    assert(asset);
+
+    char name[HISTORY_NAME_SIZE];
+    s_history_name(asset, name);
+    history_record_t* record = s_history_newest(self, name);
+    if (!record || record->end_sec != 0)
+        return -1;
+    record->end_sec = std::max(end_sec, record->start_sec);
+    record->cause   = uint8_t(cause);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Outages of 'asset' overlapping from 'from_sec' to 'to_sec', oldest first
+std::vector<history_record_t> history_query(history_t* self, const char* asset, int64_t from_sec, int64_t to_sec)
+{
+    assert(self);
+    assert(asset);
+
+    std::vector<history_record_t> outages;
+    char                          name[HISTORY_NAME_SIZE];
+    s_history_name(asset, name);
+    // outages of one asset don't overlap, so walking from the newest one stops at the first one ended before
+    history_record_t* record = s_history_newest(self, name);
+    while (record != NULL && (record->end_sec == 0 || record->end_sec >= from_sec)) {
+        if (record->start_sec <= to_sec)
+            outages.push_back(*record);
+        record = s_history_record(self, record->prev);
+    }
+    std::reverse(outages.begin(), outages.end());
+    return outages;
+}
+
+//  --------------------------------------------------------------------------
+//  Name of 'cause'
+const char* history_cause_str(uint8_t cause)
+{
+    switch (cause) {
+        case HISTORY_ONGOING:
+            return "ongoing";
+        case HISTORY_RECOVERED:
+            return "recovered";
+        case HISTORY_MAINTENANCE:
+            return "maintenance";
+        case HISTORY_REMOVED:
+            return "removed";
+        default:
+            return "unknown";
+    }
+}
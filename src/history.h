@@ -0,0 +1,100 @@
+/*  =========================================================================
+    history - Outage history in memory mapped ring file
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <czmq.h>
+#include <vector>
+
+// File is a header followed by 'capacity' fixed size records, record with sequence number N is in slot
+// (N - 1) % capacity, so the oldest outage is overwritten once the ring is full. Each record links the
+// previous record of its asset, the index in memory keeps only the newest record of each asset.
+// Integers are in the byte order of the host.
+#define HISTORY_MAGIC            "FTYOHIS1"
+#define HISTORY_NAME_SIZE        88    // asset names are truncated to 87 characters
+#define HISTORY_DEFAULT_CAPACITY 65536 // records, 8 MiB
+
+///  How the outage ended
+enum history_cause_t
+{
+    HISTORY_ONGOING     = 0, //!< outage is not over
+    HISTORY_RECOVERED   = 1, //!< device sent data again
+    HISTORY_MAINTENANCE = 2, //!< device was put into maintenance
+    HISTORY_REMOVED     = 3  //!< device was deleted or retired, or its metrics became unavailable
+};
+
+///  Header of the file
+struct history_header_t
+{
+    char     magic[8];    //!< HISTORY_MAGIC
+    uint32_t record_size; //!< sizeof(history_record_t)
+    uint32_t reserved;    //!< zero
+    uint64_t capacity;    //!< number of records
+    uint64_t next_seq;    //!< sequence number of the next record, starts at 1
+    uint8_t  padding[32]; //!< header takes 64 bytes
+};
+
+///  One outage of one asset, 128 bytes
+struct history_record_t
+{
+    uint64_t seq;                      //!< sequence number, 0 for empty slot
+    uint64_t prev;                     //!< sequence number of the previous record of the asset, 0 if none
+    int64_t  start_sec;                //!< when the asset stopped communicating
+    int64_t  end_sec;                  //!< when the outage ended, 0 while ongoing
+    uint8_t  cause;                    //!< history_cause_t
+    uint8_t  reserved[7];              //!< zero
+    char     asset[HISTORY_NAME_SIZE]; //!< asset name, NUL terminated
+};
+
+///  Structure of our class
+struct _history_t
+{
+    int               fd;      //!< history file
+    size_t            size;    //!< size of the mapping
+    history_header_t* header;  //!< mapped header
+    history_record_t* records; //!< mapped records
+    zhashx_t*         index;   //!< asset name -> sequence number of its newest record
+};
+
+typedef struct _history_t history_t;
+
+///  Open history file 'path' with room for 'capacity' outages, create it if it does not exist
+///  file with other capacity or format is started again
+///  return NULL, if the file can't be opened or mapped
+history_t* history_new(const char* path, uint64_t capacity);
+
+///  Destroy the history, flush the file
+void history_destroy(history_t** self_p);
+
+///  Record start of outage of 'asset' at 'start_sec', not earlier than end of its previous outage
+///  nothing is recorded if the asset is already in outage
+void history_begin(history_t* self, const char* asset, int64_t start_sec);
+
+///  Record end of the ongoing outage of 'asset' at 'end_sec' for 'cause'
+///  return -1, if the asset has no ongoing outage
+///  return 0 otherwise
+int history_end(history_t* self, const char* asset, int64_t end_sec, history_cause_t cause);
+
+///  Outages of 'asset' overlapping from 'from_sec' to 'to_sec', oldest first
+std::vector<history_record_t> history_query(history_t* self, const char* asset, int64_t from_sec, int64_t to_sec);
+
+///  Name of 'cause'
+const char* history_cause_str(uint8_t cause);
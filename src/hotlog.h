@@ -0,0 +1,85 @@
+/*  =========================================================================
+    hotlog - Logging on the paths taken for each metric
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <czmq.h>
+#include <fty_log.h>
+
+/// Debug logs done for each metric or each asset are compiled only with FTY_OUTAGE_HOT_LOGS
+/// (cmake -DHOT_PATH_LOGS=ON), release builds don't pay for formatting of their arguments.
+/// Assets switched to debug (DEBUG_ASSET request) are logged on info level by logAsset in any build.
+#ifdef FTY_OUTAGE_HOT_LOGS
+#define logHot(...) logDebug(__VA_ARGS__)
+#else
+#define logHot(...)                                                                                                    \
+    do {                                                                                                               \
+    } while (0)
+#endif
+
+/// log event of 'asset' of 'data', see data_debug_asset
+#define logAsset(data, asset, ...)                                                                                     \
+    do {                                                                                                               \
+        if (data_debug_asset(data, asset))                                                                             \
+            logInfo(__VA_ARGS__);                                                                                      \
+        else                                                                                                           \
+            logHot(__VA_ARGS__);                                                                                       \
+    } while (0)
+
+#define HOTLOG_PERIOD_MS 60 * 1000 // log site is rate limited for this period
+#define HOTLOG_BURST     10        // messages logged by a site in one period
+
+///  Rate limit of one log site
+struct hotlog_limit_t
+{
+    std::atomic<int64_t>  period_start_ms; //!< start of the current period (monotonic)
+    std::atomic<uint32_t> count;           //!< messages of the current period
+    std::atomic<uint32_t> suppressed;      //!< messages dropped since the last logged one
+};
+
+///  Can the site log now, 'suppressed' is set to number of messages dropped before this one
+inline bool hotlog_allow(hotlog_limit_t& limit, uint32_t& suppressed)
+{
+    int64_t now_ms   = zclock_mono();
+    int64_t start_ms = limit.period_start_ms.load(std::memory_order_relaxed);
+    if (now_ms - start_ms >= HOTLOG_PERIOD_MS && limit.period_start_ms.compare_exchange_strong(start_ms, now_ms))
+        limit.count.store(0, std::memory_order_relaxed);
+    if (limit.count.fetch_add(1, std::memory_order_relaxed) >= HOTLOG_BURST) {
+        limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = limit.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+/// log with 'logger' (e.g. logError) at most HOTLOG_BURST messages each HOTLOG_PERIOD_MS,
+/// for events which can repeat for each metric
+#define logLimited(logger, ...)                                                                                        \
+    do {                                                                                                               \
+        static hotlog_limit_t hotlog_limit_;                                                                           \
+        uint32_t              hotlog_suppressed_ = 0;                                                                  \
+        if (hotlog_allow(hotlog_limit_, hotlog_suppressed_)) {                                                         \
+            if (hotlog_suppressed_ != 0)                                                                               \
+                logger("{} similar messages were suppressed", hotlog_suppressed_);                                     \
+            logger(__VA_ARGS__);                                                                                       \
+        }                                                                                                              \
+    } while (0)
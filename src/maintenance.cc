@@ -0,0 +1,186 @@
+/*  =========================================================================
+    maintenance - Maintenance deadlines and scheduled windows
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "maintenance.h"
+#include <fty_log.h>
+
+// start is either unix time of the first occurrence or HH:MM (UTC)
+static int s_parse_start(const char* start, uint64_t* start_sec)
+{
+    unsigned hours, minutes;
+    char     tail;
+    if (sscanf(start, "%u:%u%c", &hours, &minutes, &tail) == 2) {
+        if (hours > 23 || minutes > 59)
+            return -1;
+        *start_sec = hours * 3600 + minutes * 60;
+        return 0;
+    }
+    char* end  = NULL;
+    *start_sec = strtoull(start, &end, 10);
+    return (end == start || *end != '\0') ? -1 : 0;
+}
+
+// schedule the current occurrence if it is still open, the next one otherwise
+static void s_schedule_window(maintenance_t* self, size_t index, uint64_t now_sec)
+{
+    const maintenance_window_t& window = self->windows[index];
+
+    uint64_t at_sec = window.start_sec;
+    if (now_sec > window.start_sec) {
+        at_sec += (now_sec - window.start_sec) / window.period_sec * window.period_sec;
+        if (now_sec >= at_sec + window.duration_sec)
+            at_sec += window.period_sec;
+    }
+    self->starts.push({at_sec, std::string(), index});
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new maintenance scheduler without windows
+maintenance_t* maintenance_new(void)
+{
+    return new maintenance_t();
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the maintenance scheduler
+void maintenance_destroy(maintenance_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        delete *self_p;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Load windows from 'maintenance' section of the configuration
+int maintenance_load(maintenance_t* self, zconfig_t* config, uint64_t now_sec)
+{
+    assert(self);
+
+    std::vector<maintenance_window_t> windows;
+
+    zconfig_t* section = config ? zconfig_locate(config, "maintenance") : NULL;
+    for (zconfig_t* child = section ? zconfig_child(section) : NULL; child != NULL; child = zconfig_next(child)) {
+        maintenance_window_t window;
+        window.name         = zconfig_name(child);
+        window.period_sec   = uint64_t(atoll(zconfig_get(child, "period", "0")));
+        window.duration_sec = uint64_t(atoll(zconfig_get(child, "duration", "0")));
+        if (window.period_sec == 0)
+            window.period_sec = DEFAULT_MAINTENANCE_WINDOW_PERIOD_SEC;
+
+        if (s_parse_start(zconfig_get(child, "start", ""), &window.start_sec) != 0) {
+            logError("maintenance: window '{}' has invalid start", window.name);
+            return -1;
+        }
+        if (window.duration_sec == 0 || window.duration_sec >= window.period_sec) {
+            logError("maintenance: window '{}' has invalid duration {}", window.name, window.duration_sec);
+            return -1;
+        }
+        try {
+            window.assets.reset(new std::regex(zconfig_get(child, "assets", ".*"), std::regex::optimize));
+        } catch (const std::regex_error& e) {
+            logError("maintenance: window '{}' has invalid pattern: {}", window.name, e.what());
+            return -1;
+        }
+
+        logDebug("maintenance: window '{}' start={}, period={}, duration={}", window.name, window.start_sec,
+            window.period_sec, window.duration_sec);
+        windows.push_back(std::move(window));
+    }
+
+    self->windows = std::move(windows);
+    self->starts  = maintenance_heap_t();
+    for (size_t i = 0; i < self->windows.size(); i++)
+        s_schedule_window(self, i, now_sec);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Remember that maintenance of the asset ends at until_sec
+void maintenance_schedule(maintenance_t* self, const char* asset_name, uint64_t until_sec)
+{
+    assert(self);
+    assert(asset_name);
+    self->deadlines.push({until_sec, asset_name, 0});
+}
+
+//  --------------------------------------------------------------------------
+//  Forget all ends of maintenance
+void maintenance_clear_deadlines(maintenance_t* self)
+{
+    assert(self);
+    self->deadlines = maintenance_heap_t();
+}
+
+//  --------------------------------------------------------------------------
+//  Pop the first deadline due at now_sec
+bool maintenance_pop_deadline(maintenance_t* self, uint64_t now_sec, maintenance_deadline_t& deadline)
+{
+    assert(self);
+    if (self->deadlines.empty() || self->deadlines.top().at_sec > now_sec)
+        return false;
+    deadline = self->deadlines.top();
+    self->deadlines.pop();
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Pop the first window occurrence due at now_sec, the next occurrence is scheduled
+const maintenance_window_t* maintenance_pop_window(maintenance_t* self, uint64_t now_sec, uint64_t* end_sec)
+{
+    assert(self);
+    assert(end_sec);
+
+    while (!self->starts.empty() && self->starts.top().at_sec <= now_sec) {
+        maintenance_deadline_t start = self->starts.top();
+        self->starts.pop();
+
+        const maintenance_window_t& window = self->windows[start.window];
+        *end_sec                           = start.at_sec + window.duration_sec;
+        s_schedule_window(self, start.window, std::max(now_sec, *end_sec));
+
+        // occurrence was missed completely
+        if (*end_sec <= now_sec)
+            continue;
+        return &window;
+    }
+    return NULL;
+}
+
+//  --------------------------------------------------------------------------
+//  Check if some window is open for the asset at now_sec
+uint64_t maintenance_window_end(maintenance_t* self, const char* asset_name, uint64_t now_sec)
+{
+    assert(self);
+    assert(asset_name);
+
+    uint64_t end_sec = 0;
+    for (const auto& window : self->windows) {
+        if (now_sec < window.start_sec)
+            continue;
+        uint64_t at_sec = window.start_sec + (now_sec - window.start_sec) / window.period_sec * window.period_sec;
+        if (now_sec < at_sec + window.duration_sec && at_sec + window.duration_sec > end_sec &&
+            std::regex_match(asset_name, *window.assets))
+            end_sec = at_sec + window.duration_sec;
+    }
+    return end_sec;
+}
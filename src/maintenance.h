@@ -0,0 +1,100 @@
+/*  =========================================================================
+    maintenance - Maintenance deadlines and scheduled windows
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <czmq.h>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <regex>
+#include <string>
+#include <vector>
+
+#define DEFAULT_MAINTENANCE_WINDOW_PERIOD_SEC 24 * 60 * 60
+
+///  Recurring maintenance window: assets matching the pattern are in maintenance
+///  from start + k * period for duration seconds
+struct maintenance_window_t
+{
+    std::string                 name;         //!< name of the window in configuration
+    std::unique_ptr<std::regex> assets;       //!< asset name pattern
+    uint64_t                    start_sec;    //!< first occurrence
+    uint64_t                    period_sec;   //!< time between occurrences
+    uint64_t                    duration_sec; //!< length of an occurrence
+};
+
+///  Heap entry, ordered by time
+struct maintenance_deadline_t
+{
+    uint64_t    at_sec; //!< when the entry is due
+    std::string asset;  //!< asset leaving maintenance (deadlines only)
+    size_t      window; //!< window starting (window starts only)
+
+    bool operator>(const maintenance_deadline_t& other) const
+    {
+        return at_sec > other.at_sec;
+    }
+};
+
+typedef std::priority_queue<maintenance_deadline_t, std::vector<maintenance_deadline_t>,
+    std::greater<maintenance_deadline_t>>
+    maintenance_heap_t;
+
+///  Structure of our class
+struct _maintenance_t
+{
+    maintenance_heap_t                deadlines; //!< ends of maintenance, entries are checked against asset when due
+    maintenance_heap_t                starts;    //!< next occurrences of windows
+    std::vector<maintenance_window_t> windows;   //!< scheduled windows
+};
+
+typedef struct _maintenance_t maintenance_t;
+
+///  Create a new maintenance scheduler without windows
+maintenance_t* maintenance_new(void);
+
+///  Destroy the maintenance scheduler
+void maintenance_destroy(maintenance_t** self_p);
+
+///  Load windows from 'maintenance' section of the configuration, replacing the current ones
+///  return -1, if some window is invalid and nothing was loaded
+///  return 0 otherwise
+int maintenance_load(maintenance_t* self, zconfig_t* config, uint64_t now_sec);
+
+///  Remember that maintenance of the asset ends at until_sec
+void maintenance_schedule(maintenance_t* self, const char* asset_name, uint64_t until_sec);
+
+///  Forget all ends of maintenance, e.g. to schedule them again after a step of the wall clock
+void maintenance_clear_deadlines(maintenance_t* self);
+
+///  Pop the first deadline due at now_sec
+///  return false, if no deadline is due
+bool maintenance_pop_deadline(maintenance_t* self, uint64_t now_sec, maintenance_deadline_t& deadline);
+
+///  Pop the first window occurrence due at now_sec, the next occurrence is scheduled
+///  return window, end_sec is set to the end of the occurrence
+///  return NULL, if no window occurrence is due
+const maintenance_window_t* maintenance_pop_window(maintenance_t* self, uint64_t now_sec, uint64_t* end_sec);
+
+///  Check if some window is open for the asset at now_sec
+///  return end of the latest open occurrence, 0 if no window is open
+uint64_t maintenance_window_end(maintenance_t* self, const char* asset_name, uint64_t now_sec);
@@ -1,22 +1,107 @@
 #pragma once
+#include "capture.h"
 #include "data.h"
+#include "history.h"
+#include "replica.h"
+#include "wave.h"
 #include <fty_log.h>
 #include <malamute.h>
 
 #define TIMEOUT_MS 30000 // wait at least 30 seconds
 
+#define SNAPSHOT_MAX_AGE_MS 2000 // listings requested within this period share the snapshot
+
+#define DEFAULT_STATS_INTERVAL_MS 60000 // publish statistics of the agent each minute
+
+#define DEFAULT_LAG_THRESHOLD_MS 60000 // agent processing metrics a minute late is behind
+
+#define DEFAULT_MAINTENANCE_EXPIRATION_SEC 3600 // maintenance without TTL lasts an hour, even without configuration
+
 // hack to allow us to pretend zhash is set
 static void* TRUE = const_cast<void*>(reinterpret_cast<const void*>("true"));
 
+///  Consistent view of the asset store served by LIST requests page by page
+struct osrv_snapshot_t
+{
+    uint64_t                    id;          //!< snapshot identifier, for paging
+    uint64_t                    taken_ms;    //!< when the snapshot was taken (monotonic)
+    std::vector<asset_status_t> rows;        //!< all the assets, sorted by name
+    std::vector<size_t>         dead;        //!< indexes of dead assets
+    std::vector<size_t>         maintenance; //!< indexes of assets in maintenance
+    std::vector<size_t>         flapping;    //!< indexes of flapping assets
+};
+
+///  Sources of metrics which keep assets alive
+#define OSRV_LIVENESS_SHM    0x01 //!< metrics read from fty_shm
+#define OSRV_LIVENESS_STREAM 0x02 //!< metrics received from METRICS and _METRICS_SENSOR streams
+#define OSRV_LIVENESS_HYBRID (OSRV_LIVENESS_SHM | OSRV_LIVENESS_STREAM)
+
+///  Roles of the agent in the replication of its state
+#define OSRV_REPLICA_NONE    0 //!< the agent is alone
+#define OSRV_REPLICA_LEADER  1 //!< the agent publishes alerts and sends changes of its state to the standby
+#define OSRV_REPLICA_STANDBY 2 //!< the agent applies changes from the leader, takes over when its lease expires
+
+///  Message received by the agent, as seen by the handlers
+struct osrv_message_t
+{
+    const char* command; //!< mlm command, e.g. STREAM DELIVER or MAILBOX DELIVER
+    const char* address; //!< stream or mailbox the message was delivered on
+    const char* sender;  //!< sender of the message
+    const char* subject; //!< subject of the message
+};
+
+///  Fields of a metric which keep its asset alive, pointing into the stream message or the fty_shm metric
+struct osrv_metric_t
+{
+    const char* name;      //!< asset which sent the metric
+    uint64_t    time;      //!< time of the metric
+    uint64_t    ttl;       //!< ttl of the metric
+    const char* port;      //!< sensor port (aux), NULL if the metric is not from a sensor
+    const char* sname;     //!< sensor name (aux)
+    const char* operation; //!< operation of _METRICS_SENSOR message, NULL if not set
+    bool        computed;  //!< computed by agent-cm (x-cm-count aux), not a sign of life
+};
+
+///  Ingestion of the stream during one check period
+struct osrv_ingest_t
+{
+    int64_t  min_lag_ms;          //!< lag of the freshest metric, -1 if no metric was received
+    uint64_t backlog;             //!< messages which were waiting when the last one was received
+    uint64_t max_backlog;         //!< max backlog
+    uint64_t protective_since_ms; //!< when the agent fell behind (monotonic), 0 if it is not behind
+};
+
 typedef struct _s_osrv_t
 {
-    uint64_t      timeout_ms;
-    mlm_client_t* client;
-    data_t*       assets;
-    zhash_t*      active_alerts;
-    char*         state_file;
-    uint64_t      default_maintenance_expiration;
-    bool          verbose;
+    uint64_t         timeout_ms;
+    mlm_client_t*    client;
+    data_t*          assets;
+    zhash_t*         active_alerts;
+    zlist_t*         alert_actions;      //!< actions of the published alerts, built once
+    char*            state_file;
+    uint64_t         default_maintenance_expiration;
+    bool             verbose;
+    bool             shm_status;         //!< publish per-asset status into fty_shm
+    uint64_t         stats_interval_ms;  //!< how often statistics are published into fty_shm, 0 disables it
+    FILE*            trace;              //!< detection latency trace file, if set
+    capture_t*       capture;            //!< binary trace of the received messages
+    history_t*       history;            //!< history of the outages, NULL if not kept
+    wave_t*          wave;               //!< correlated outages, their alerts are held
+    uint64_t         last_touches;       //!< metrics applied to assets until the last dead check
+    zactor_t*        metric_poll;        //!< reader of fty_shm
+    uint8_t          liveness;           //!< OSRV_LIVENESS_* sources of metrics which keep assets alive
+    uint64_t         lag_threshold_ms;   //!< dead checks are deferred while metrics are late more, 0 disables it
+    osrv_ingest_t    ingest;             //!< ingestion of the stream in the current check period
+    uint64_t         last_dead_check_ms; //!< when dead devices were checked (monotonic)
+    uint64_t         last_save_ms;       //!< when the state was saved (monotonic)
+    uint64_t         last_stats_ms;      //!< when statistics were published (monotonic)
+    osrv_snapshot_t* snapshot;           //!< latest snapshot for LIST requests
+    osrv_snapshot_t* previous_snapshot;  //!< snapshot clients may be still paging through
+    zactor_t*        replica;            //!< replication of the state to the standby agent
+    uint8_t          replica_role;       //!< OSRV_REPLICA_* role of the agent
+    char*            replica_endpoint;   //!< endpoint of the replication
+    uint64_t         replica_lease_ms;   //!< standby takes over when the leader is silent this long
+    zhashx_t*        replica_seen;       //!< assets seen since the last sync of the standby
 } s_osrv_t;
 
 inline void s_osrv_destroy(s_osrv_t** self_p)
@@ -25,9 +110,19 @@ inline void s_osrv_destroy(s_osrv_t** self_p)
     if (*self_p) {
         s_osrv_t* self = *self_p;
         zhash_destroy(&self->active_alerts);
+        zlist_destroy(&self->alert_actions);
+        capture_destroy(&self->capture);
+        history_destroy(&self->history);
+        wave_destroy(&self->wave);
         data_destroy(&self->assets);
         mlm_client_destroy(&self->client);
         zstr_free(&self->state_file);
+        zstr_free(&self->replica_endpoint);
+        zhashx_destroy(&self->replica_seen);
+        if (self->trace)
+            fclose(self->trace);
+        delete self->snapshot;
+        delete self->previous_snapshot;
         free(self);
         *self_p = NULL;
     }
@@ -35,18 +130,36 @@ inline void s_osrv_destroy(s_osrv_t** self_p)
 
 inline s_osrv_t* s_osrv_new()
 {
-    s_osrv_t* self = reinterpret_cast<s_osrv_t*>(malloc(sizeof(s_osrv_t)));
+    s_osrv_t* self = reinterpret_cast<s_osrv_t*>(zmalloc(sizeof(s_osrv_t)));
     if (self) {
         self->client = mlm_client_new();
         if (self->client)
             self->assets = data_new();
         if (self->assets)
+            self->capture = capture_new();
+        if (self->capture)
             self->active_alerts = zhash_new();
-        if (self->active_alerts) {
+        if (self->active_alerts)
+            self->alert_actions = zlist_new();
+        if (self->alert_actions)
+            self->wave = wave_new();
+        if (self->wave)
+            self->replica_seen = zhashx_new();
+        if (self->replica_seen) {
+            // FIXME: should be a configurable Settings->Alert!!!
+            zlist_append(self->alert_actions, const_cast<char*>("EMAIL"));
+            zlist_append(self->alert_actions, const_cast<char*>("SMS"));
             self->timeout_ms                     = TIMEOUT_MS;
             self->state_file                     = NULL;
-            self->default_maintenance_expiration = 0;
+            self->default_maintenance_expiration = DEFAULT_MAINTENANCE_EXPIRATION_SEC;
             self->verbose                        = false;
+            self->shm_status                     = true;
+            self->stats_interval_ms              = DEFAULT_STATS_INTERVAL_MS;
+            self->lag_threshold_ms               = DEFAULT_LAG_THRESHOLD_MS;
+            self->ingest.min_lag_ms              = -1;
+            self->liveness                       = OSRV_LIVENESS_HYBRID;
+            self->replica_role                   = OSRV_REPLICA_NONE;
+            self->replica_lease_ms               = REPLICA_DEFAULT_LEASE_MS;
         } else {
             s_osrv_destroy(&self);
         }
@@ -63,7 +176,8 @@ inline int s_osrv_save(s_osrv_t* self)
         return -1;
     }
 
-    zconfig_t* root = zconfig_new("root", NULL);
+    histogram_timer_t timer(stats_histogram(self->assets->stats, STATS_LATENCY_SAVE));
+    zconfig_t*        root = zconfig_new("root", NULL);
     assert(root);
 
     zconfig_t* active_alerts = zconfig_new("alerts", root);
@@ -0,0 +1,166 @@
+/*  =========================================================================
+    policy - Monitoring policy of assets
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "policy.h"
+#include <fty_log.h>
+
+static policy_rule_t s_rule_new(const char* type, const char* subtype)
+{
+    policy_rule_t rule;
+    rule.type           = type;
+    rule.subtype        = subtype;
+    rule.monitor        = true;
+    rule.ttl_sec        = 0;
+    rule.multiplier     = DEFAULT_POLICY_MULTIPLIER;
+    rule.reannounce_sec = 0;
+    return rule;
+}
+
+// note: sts are monitored only when they have some measure (device.type is not empty)
+static void s_builtin_rules(std::vector<policy_rule_t>& rules)
+{
+    for (const char* subtype : {"ups", "epdu", "sensor", "sensorgpio"})
+        rules.push_back(s_rule_new("device", subtype));
+
+    policy_rule_t sts = s_rule_new("device", "sts");
+    sts.ext_key       = "device.type";
+    sts.ext_value.reset(new std::regex(".+", std::regex::optimize));
+    rules.push_back(std::move(sts));
+}
+
+static void s_compile(policy_t* self)
+{
+    self->by_subtype.clear();
+    self->any_subtype.clear();
+
+    for (const auto& rule : self->rules) {
+        if (!rule.subtype.empty())
+            self->by_subtype.emplace(rule.subtype, std::vector<size_t>());
+    }
+
+    for (size_t i = 0; i < self->rules.size(); i++) {
+        const auto& subtype = self->rules[i].subtype;
+        if (subtype.empty()) {
+            self->any_subtype.push_back(i);
+            for (auto& it : self->by_subtype)
+                it.second.push_back(i);
+        } else
+            self->by_subtype[subtype].push_back(i);
+    }
+}
+
+static bool s_rule_matches(const policy_rule_t& rule, fty_proto_t* asset)
+{
+    if (!rule.type.empty() && rule.type != fty_proto_aux_string(asset, FTY_PROTO_ASSET_TYPE, ""))
+        return false;
+    if (rule.name && !std::regex_match(fty_proto_name(asset), *rule.name))
+        return false;
+    if (rule.ext_value && !std::regex_match(fty_proto_ext_string(asset, rule.ext_key.c_str(), ""), *rule.ext_value))
+        return false;
+    return true;
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new policy with built-in rules
+policy_t* policy_new(void)
+{
+    policy_t* self = new policy_t();
+    s_builtin_rules(self->rules);
+    s_compile(self);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the policy
+void policy_destroy(policy_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        delete *self_p;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Load rules from 'policy' section of the configuration
+int policy_load(policy_t* self, zconfig_t* config)
+{
+    assert(self);
+
+    std::vector<policy_rule_t> rules;
+
+    zconfig_t* section = config ? zconfig_locate(config, "policy") : NULL;
+    for (zconfig_t* child = section ? zconfig_child(section) : NULL; child != NULL; child = zconfig_next(child)) {
+        policy_rule_t rule = s_rule_new(zconfig_get(child, "type", "device"), zconfig_get(child, "subtype", ""));
+
+        rule.ext_key        = zconfig_get(child, "ext_key", "");
+        rule.monitor        = atoi(zconfig_get(child, "monitor", "1")) != 0;
+        rule.ttl_sec        = uint64_t(atoll(zconfig_get(child, "ttl", "0")));
+        rule.reannounce_sec = uint32_t(atol(zconfig_get(child, "reannounce", "0")));
+        int multiplier      = atoi(zconfig_get(child, "multiplier", "2"));
+        if (multiplier < 1 || multiplier > 255) {
+            logError("policy: rule '{}' has invalid multiplier {}", zconfig_name(child), multiplier);
+            return -1;
+        }
+        rule.multiplier = uint8_t(multiplier);
+
+        try {
+            const char* name = zconfig_get(child, "name", "");
+            if (!streq(name, ""))
+                rule.name.reset(new std::regex(name, std::regex::optimize));
+            if (!rule.ext_key.empty())
+                rule.ext_value.reset(new std::regex(zconfig_get(child, "ext_value", ".+"), std::regex::optimize));
+        } catch (const std::regex_error& e) {
+            logError("policy: rule '{}' has invalid pattern: {}", zconfig_name(child), e.what());
+            return -1;
+        }
+
+        logDebug("policy: rule '{}' type='{}', subtype='{}', monitor={}, ttl={}, multiplier={}, reannounce={}",
+            zconfig_name(child), rule.type, rule.subtype, rule.monitor, rule.ttl_sec, multiplier, rule.reannounce_sec);
+        rules.push_back(std::move(rule));
+    }
+
+    s_builtin_rules(rules);
+    self->rules = std::move(rules);
+    s_compile(self);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Returns the first rule matching the asset, NULL if the asset is not monitored
+const policy_rule_t* policy_match(policy_t* self, fty_proto_t* asset)
+{
+    assert(self);
+    assert(asset);
+
+    const std::vector<size_t>* candidates = &self->any_subtype;
+
+    auto it = self->by_subtype.find(fty_proto_aux_string(asset, FTY_PROTO_ASSET_SUBTYPE, ""));
+    if (it != self->by_subtype.end())
+        candidates = &it->second;
+
+    for (size_t i : *candidates) {
+        const policy_rule_t& rule = self->rules[i];
+        if (s_rule_matches(rule, asset))
+            return rule.monitor ? &rule : NULL;
+    }
+    return NULL;
+}
@@ -0,0 +1,72 @@
+/*  =========================================================================
+    policy - Monitoring policy of assets
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <czmq.h>
+#include <fty_proto.h>
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// asset expires when no data came for ttl * multiplier
+#define DEFAULT_POLICY_MULTIPLIER 2
+
+///  One monitoring rule, empty conditions match any asset
+struct policy_rule_t
+{
+    std::string                 type;           //!< asset type
+    std::string                 subtype;        //!< asset subtype
+    std::unique_ptr<std::regex> name;           //!< asset name pattern
+    std::string                 ext_key;        //!< ext attribute which value must match ext_value
+    std::unique_ptr<std::regex> ext_value;      //!< ext attribute pattern
+    bool                        monitor;        //!< is the asset monitored at all
+    uint64_t                    ttl_sec;        //!< default expiry of the asset, 0 for data default
+    uint8_t                     multiplier;     //!< asset expires after ttl * multiplier
+    uint32_t                    reannounce_sec; //!< ACTIVE alert re-announce interval, 0 for each dead check
+};
+
+///  Rules are compiled once: subtype => candidate rules in priority order, so matching
+///  an asset is a single hash lookup and only the candidates are evaluated
+struct _policy_t
+{
+    std::vector<policy_rule_t>                           rules;       //!< rules in priority order
+    std::unordered_map<std::string, std::vector<size_t>> by_subtype;  //!< subtype => candidate rules
+    std::vector<size_t>                                  any_subtype; //!< candidate rules of other subtypes
+};
+
+typedef struct _policy_t policy_t;
+
+///  Create a new policy with built-in rules (ups, epdu, sensor, sensorgpio and sts devices)
+policy_t* policy_new(void);
+
+///  Destroy the policy
+void policy_destroy(policy_t** self_p);
+
+///  Load rules from 'policy' section of the configuration, they take precedence over built-in rules
+///  return -1, if some rule is invalid and nothing was loaded
+///  return 0 otherwise
+int policy_load(policy_t* self, zconfig_t* config);
+
+///  Returns the first rule matching the asset, NULL if the asset is not monitored
+const policy_rule_t* policy_match(policy_t* self, fty_proto_t* asset);
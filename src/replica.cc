@@ -0,0 +1,148 @@
+/*  =========================================================================
+    replica - Replication of the outage state to a standby agent
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+#include "replica.h"
+#include "vclock.h"
+#include <algorithm>
+#include <fty_log.h>
+
+// first byte of XPUB message announcing a new subscription
+#define REPLICA_SUBSCRIBE 1
+
+//  --------------------------------------------------------------------------
+//  Replication actor of the server
+void outage_replica(zsock_t* pipe, void* args)
+{
+    vclock_t*  own      = args ? NULL : vclock_new();
+    vclock_t*  clock    = args ? reinterpret_cast<vclock_t*>(args) : own;
+    zpoller_t* poller   = zpoller_new(pipe, NULL);
+    zsock_t*   socket   = NULL;  // XPUB of the leader, SUB of the standby
+    bool       leader   = false;
+    bool       follows  = false; // standby heard from the leader
+    bool       resync   = false; // standby missed changes
+    int64_t    lease_ms = REPLICA_DEFAULT_LEASE_MS;
+    int64_t    due_ms   = 0;     // next SYNC of the leader, end of the lease for the standby
+    zsock_signal(pipe, 0);
+
+    while (!zsys_interrupted) {
+        // simulated time moves only with TICK
+        int timeout = -1;
+        if (socket && !clock->simulated.load())
+            timeout = int(std::max(due_ms - vclock_mono(clock), int64_t(0)));
+        void* which = zpoller_wait(poller, timeout);
+        if (zpoller_terminated(poller))
+            break;
+
+        if (which == pipe) {
+            zmsg_t* msg     = zmsg_recv(pipe);
+            char*   command = msg ? zmsg_popstr(msg) : NULL;
+            if (!command || streq(command, "$TERM")) {
+                zstr_free(&command);
+                zmsg_destroy(&msg);
+                break;
+            }
+            if (streq(command, "PUBLISH")) {
+                if (socket && leader && zmsg_send(&msg, socket) != 0 && !resync) {
+                    logWarn("replica: standby is {} changes behind, it gets the whole state at the next sync",
+                        REPLICA_SNDHWM);
+                    resync = true;
+                }
+            } else if (streq(command, "TICK")) {
+                // the lease is checked below
+            } else if (streq(command, "LEADER") || streq(command, "STANDBY")) {
+                char* endpoint = zmsg_popstr(msg);
+                char* lease    = zmsg_popstr(msg);
+                if (socket) {
+                    zpoller_remove(poller, socket);
+                    zsock_destroy(&socket);
+                }
+                leader   = streq(command, "LEADER");
+                follows  = false;
+                resync   = false;
+                lease_ms = lease ? std::max(atoll(lease), 1LL) : REPLICA_DEFAULT_LEASE_MS;
+                if (endpoint && leader) {
+                    socket = zsock_new_xpub(endpoint);
+                    if (socket) {
+                        // every subscription is announced, a full queue fails the send at once instead of
+                        // dropping the change or blocking on a stuck standby
+                        zsock_set_xpub_verbose(socket, 1);
+                        zsock_set_xpub_nodrop(socket, 1);
+                        zsock_set_sndhwm(socket, REPLICA_SNDHWM);
+                        zsock_set_sndtimeo(socket, 0);
+                    }
+                } else if (endpoint) {
+                    socket = zsock_new_sub(endpoint, "");
+                    if (socket)
+                        zsock_set_rcvhwm(socket, 0);
+                }
+                if (socket) {
+                    zpoller_add(poller, socket);
+                    // standby gives the leader a few leases to appear
+                    due_ms = vclock_mono(clock) +
+                        (leader ? lease_ms / REPLICA_SYNCS_PER_LEASE : lease_ms * REPLICA_STARTUP_LEASES);
+                    logInfo("replica: {} at {}, lease {} ms", leader ? "leader" : "standby", endpoint, lease_ms);
+                } else
+                    logError("replica: can't {} {}", leader ? "bind" : "connect", endpoint ? endpoint : "");
+                zstr_free(&endpoint);
+                zstr_free(&lease);
+            } else
+                logError("replica: unknown command {}", command);
+            zstr_free(&command);
+            zmsg_destroy(&msg);
+        } else if (socket && which == socket) {
+            zmsg_t* msg = zmsg_recv(socket);
+            if (msg && leader) {
+                zframe_t* frame = zmsg_first(msg);
+                if (frame && zframe_size(frame) > 0 && zframe_data(frame)[0] == REPLICA_SUBSCRIBE)
+                    zstr_send(pipe, "SNAPSHOT");
+            } else if (msg) {
+                if (!follows)
+                    logInfo("replica: following the leader");
+                follows = true;
+                due_ms  = vclock_mono(clock) + lease_ms;
+                zmsg_pushstr(msg, "APPLY");
+                zmsg_send(&msg, pipe);
+            }
+            zmsg_destroy(&msg);
+        }
+
+        if (socket && vclock_mono(clock) >= due_ms) {
+            if (leader) {
+                zstr_send(pipe, resync ? "SNAPSHOT" : "SYNC");
+                resync = false;
+                due_ms = vclock_mono(clock) + std::max(lease_ms / REPLICA_SYNCS_PER_LEASE, int64_t(1));
+            } else {
+                if (follows)
+                    logWarn("replica: no message from the leader for {} ms", lease_ms);
+                else
+                    logWarn("replica: no leader appeared for {} ms", lease_ms * REPLICA_STARTUP_LEASES);
+                zpoller_remove(poller, socket);
+                zsock_destroy(&socket);
+                zstr_send(pipe, "TAKEOVER");
+            }
+        }
+    }
+    if (socket)
+        zsock_destroy(&socket);
+    zpoller_destroy(&poller);
+    vclock_destroy(&own);
+}
@@ -0,0 +1,55 @@
+/*  =========================================================================
+    replica - Replication of the outage state to a standby agent
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+#pragma once
+
+#include <czmq.h>
+
+/// Leader agent binds XPUB socket and publishes changes of its state, standby agent connects SUB socket
+/// and applies them, so it has the same assets and alerts when it takes over. The standby takes over
+/// when no message came from the leader for the lease; the leader sends at least one each lease / syncs.
+/// A standby started before the leader gives it REPLICA_STARTUP_LEASES leases to appear, so both agents
+/// starting together don't lead both, and a leader which never comes is still taken over.
+/// Changes the standby is too slow to take are not queued without limit and never block the leader: it
+/// sends the standby the whole state again at the next sync.
+#define REPLICA_DEFAULT_ENDPOINT "ipc://@/fty-outage-replica"
+#define REPLICA_DEFAULT_LEASE_MS 5000
+#define REPLICA_SYNCS_PER_LEASE  5
+#define REPLICA_STARTUP_LEASES   3
+#define REPLICA_SNDHWM           100000 // changes queued for the standby
+
+///  Replication actor of the server, both sides of its pipe use multi-frame messages
+///  'args' is vclock_t measuring the lease, NULL for the real time
+///
+///  Commands of the server:
+///  * LEADER/endpoint/lease_ms - bind 'endpoint' and publish the changes to the standby
+///  * STANDBY/endpoint/lease_ms - connect to the leader at 'endpoint' and follow it
+///  * PUBLISH/change... - leader only, publish the change to the standby
+///  * TICK - simulated clock moved, check the lease
+///
+///  Messages to the server:
+///  * SYNC - leader only, each lease / REPLICA_SYNCS_PER_LEASE, time to publish the summarized
+///    changes, which renews the lease
+///  * SNAPSHOT - leader only, standby subscribed or missed changes and needs the whole state
+///  * APPLY/change... - standby only, change published by the leader
+///  * TAKEOVER - standby only, lease of the leader expired, the actor is idle until LEADER comes
+void outage_replica(zsock_t* pipe, void* args);
@@ -0,0 +1,179 @@
+/*  =========================================================================
+    shmreader - Parallel reader of metrics from fty_shm
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "shmreader.h"
+#include <algorithm>
+#include <exception>
+#include <fty_log.h>
+
+// read metrics of 'shard' into 'batch', a failed shard is logged and left empty for this read
+static void s_shmreader_read_shard(shmreader_t* self, size_t shard, fty::shm::shmMetrics*& batch)
+{
+    try {
+        fty::shm::read_metrics(self->shards[shard], SHMREADER_METRIC_REGEX, *batch);
+        return;
+    } catch (const std::exception& e) {
+        logError("shmreader: reading shard {} failed: {}", shard, e.what());
+    } catch (...) {
+        logError("shmreader: reading shard {} failed", shard);
+    }
+    delete batch;
+    batch = new fty::shm::shmMetrics();
+}
+
+// worker finished its shard, whatever way it left the read
+struct shmreader_done_t
+{
+    shmreader_t*                  self;
+    std::unique_lock<std::mutex>& lock;
+
+    ~shmreader_done_t()
+    {
+        lock.lock();
+        if (--self->pending == 0)
+            self->finished.notify_one();
+    }
+};
+
+// read 'shard' each time a read is started, until the reader stops
+static void s_shmreader_worker(shmreader_t* self, size_t shard)
+{
+    uint64_t                     generation = 0;
+    std::unique_lock<std::mutex> lock(self->mutex);
+    while (true) {
+        self->started.wait(lock, [&] {
+            return self->stop || self->generation != generation;
+        });
+        if (self->stop)
+            return;
+        generation                   = self->generation;
+        fty::shm::shmMetrics*& batch = self->batches[shard];
+        lock.unlock();
+        shmreader_done_t done{self, lock};
+        s_shmreader_read_shard(self, shard, batch);
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new reader with pool of 'workers' threads
+shmreader_t* shmreader_new(size_t workers)
+{
+    if (workers == 0)
+        workers = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+    workers = std::min(workers, size_t(SHMREADER_MAX_WORKERS));
+
+    shmreader_t* self = new shmreader_t();
+    self->generation  = 0;
+    self->pending     = 0;
+    self->stop        = false;
+    for (size_t shard = 0; shard < workers; shard++)
+        self->shards.push_back(shmreader_shard_regex(shard, workers));
+    for (size_t shard = 1; shard < workers; shard++)
+        self->workers.emplace_back(s_shmreader_worker, self, shard);
+    logDebug("shmreader: fty_shm is read in {} shards", workers);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the reader, stop its workers
+void shmreader_destroy(shmreader_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        shmreader_t* self = *self_p;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->stop = true;
+        }
+        self->started.notify_all();
+        for (auto& worker : self->workers)
+            worker.join();
+        delete self;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Number of shards read in parallel
+size_t shmreader_shards(shmreader_t* self)
+{
+    assert(self);
+    return self->shards.size();
+}
+
+//  --------------------------------------------------------------------------
+//  Regex of asset names in 'shard' out of 'shards'
+std::string shmreader_shard_regex(size_t shard, size_t shards)
+{
+    if (shards <= 1)
+        return ".*";
+
+    std::string digits;
+    for (size_t digit = shard; digit < 10; digit += shards)
+        digits += char('0' + digit);
+    if (shard == 0)
+        return "^(.*[^0-9]|.*[" + digits + "])$";
+    return "^.*[" + digits + "]$";
+}
+
+//  --------------------------------------------------------------------------
+//  Read all metrics from fty_shm, append one batch per shard into 'result'
+void shmreader_read(shmreader_t* self, shmreader_result_t& result)
+{
+    assert(self);
+
+    std::unique_lock<std::mutex> lock(self->mutex);
+    for (size_t shard = 0; shard < self->shards.size(); shard++)
+        self->batches.push_back(new fty::shm::shmMetrics());
+    self->pending = self->workers.size();
+    self->generation++;
+    self->started.notify_all();
+    fty::shm::shmMetrics*& batch = self->batches[0];
+    lock.unlock();
+
+    s_shmreader_read_shard(self, 0, batch);
+
+    lock.lock();
+    self->finished.wait(lock, [&] {
+        return self->pending == 0;
+    });
+    result.insert(result.end(), self->batches.begin(), self->batches.end());
+    self->batches.clear();
+}
+
+//  --------------------------------------------------------------------------
+//  Number of metrics in 'result'
+size_t shmreader_result_size(const shmreader_result_t& result)
+{
+    size_t size = 0;
+    for (auto batch : result)
+        size += size_t(batch->size());
+    return size;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the batches of 'result'
+void shmreader_result_clear(shmreader_result_t& result)
+{
+    for (auto batch : result)
+        delete batch;
+    result.clear();
+}
@@ -0,0 +1,81 @@
+/*  =========================================================================
+    shmreader - Parallel reader of metrics from fty_shm
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <fty_shm.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Metric files are split into shards by the last character of the asset name: digits are spread among
+// the shards, the first shard takes also the names not ending with a digit. Asset names end with their
+// database ID, so the shards are about the same size.
+// fty::shm::read_metrics filters by regex only, so each shard still lists the whole metric directory; the
+// parsing of the files is what gets split.
+// read_metrics is the only reader of the metric files, whose layout is private to libfty_shm, and it builds
+// a fty_proto_t per metric; the files are not parsed here, a lighter read needs an fty_shm API.
+#define SHMREADER_MAX_WORKERS 4 // the pool is small, reading is bound by the storage
+
+// metrics written by the agent itself (outage.* status and statistics) are never signs of life
+#define SHMREADER_METRIC_REGEX "^(?!outage\\.).*$"
+
+///  Metrics of one read, one batch per shard, owned by the holder
+typedef std::vector<fty::shm::shmMetrics*> shmreader_result_t;
+
+///  Structure of our class
+struct _shmreader_t
+{
+    std::vector<std::string>           shards;     //!< asset regex of each shard
+    std::vector<std::thread>           workers;    //!< read the shards 1..n-1, shard 0 is read by the caller
+    std::vector<fty::shm::shmMetrics*> batches;    //!< batches of the running read, one per shard
+    std::mutex                         mutex;      //!< guards the members below
+    std::condition_variable            started;    //!< workers wait for the next read
+    std::condition_variable            finished;   //!< caller waits for the workers
+    uint64_t                           generation; //!< number of reads started
+    size_t                             pending;    //!< workers still reading
+    bool                               stop;       //!< workers terminate
+};
+
+typedef struct _shmreader_t shmreader_t;
+
+///  Create a new reader with pool of 'workers' threads, 0 for one per core up to SHMREADER_MAX_WORKERS
+shmreader_t* shmreader_new(size_t workers);
+
+///  Destroy the reader, stop its workers
+void shmreader_destroy(shmreader_t** self_p);
+
+///  Number of shards read in parallel
+size_t shmreader_shards(shmreader_t* self);
+
+///  Regex of asset names in 'shard' out of 'shards'
+std::string shmreader_shard_regex(size_t shard, size_t shards);
+
+///  Read all metrics from fty_shm, append one batch per shard into 'result'
+void shmreader_read(shmreader_t* self, shmreader_result_t& result);
+
+///  Number of metrics in 'result'
+size_t shmreader_result_size(const shmreader_result_t& result);
+
+///  Destroy the batches of 'result'
+void shmreader_result_clear(shmreader_result_t& result);
@@ -0,0 +1,159 @@
+/*  =========================================================================
+    stats - Runtime statistics of the agent
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "stats.h"
+#include <fty_log.h>
+#include <fty_shm.h>
+#include <string>
+
+static const char* s_counter_names[] = {"msg_metrics", "msg_metrics_sensor", "msg_metrics_unavailable", "msg_assets",
+    "msg_mailbox", "msg_other", "decode_failures", "metrics_from_future", "touches", "assets_added", "assets_deleted",
+    "shm_polls", "shm_metrics", "dead_checks", "alerts_active", "alerts_resolved", "dead_checks_deferred",
+    "duplicates", "waves", "metrics_skewed", "clock_jumps", "replica_sent", "replica_applied"};
+
+static const char* s_gauge_names[] = {"assets_tracked", "assets_dead", "alerts_tracked", "dead_check_usec",
+    "shm_poll_usec", "ingest_lag_ms", "ingest_backlog", "protective", "alerts_held", "standby"};
+
+static const char* s_histogram_names[] = {"stream_message", "dead_check", "metric_processing", "shm_read", "save",
+    "outage_detection", "recovery_detection", "metric_age", "ingest_lag"};
+
+static_assert(sizeof(s_counter_names) / sizeof(s_counter_names[0]) == STATS_COUNTERS, "name of each counter");
+static_assert(sizeof(s_gauge_names) / sizeof(s_gauge_names[0]) == STATS_GAUGES, "name of each gauge");
+static_assert(sizeof(s_histogram_names) / sizeof(s_histogram_names[0]) == STATS_HISTOGRAMS, "name of each histogram");
+
+//  --------------------------------------------------------------------------
+//  Create new statistics, all zero
+stats_t* stats_new(void)
+{
+    stats_t* self = new stats_t();
+    for (auto& counter : self->counters)
+        counter.store(0, std::memory_order_relaxed);
+    for (auto& gauge : self->gauges)
+        gauge.store(0, std::memory_order_relaxed);
+    for (auto& histogram : self->histograms)
+        histogram_reset(&histogram);
+    self->started_ms   = zclock_mono();
+    self->published_ms = self->started_ms;
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the statistics
+void stats_destroy(stats_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        delete *self_p;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Name of the counter
+const char* stats_counter_name(stats_counter_t counter)
+{
+    return s_counter_names[counter];
+}
+
+//  --------------------------------------------------------------------------
+//  Name of the gauge
+const char* stats_gauge_name(stats_gauge_t gauge)
+{
+    return s_gauge_names[gauge];
+}
+
+//  --------------------------------------------------------------------------
+//  Name of the latency distribution
+const char* stats_histogram_name(stats_histogram_t histogram)
+{
+    return s_histogram_names[histogram];
+}
+
+//  --------------------------------------------------------------------------
+//  Add all the statistics to the message as name/value frames
+void stats_add_to_msg(stats_t* self, zmsg_t* msg)
+{
+    assert(self);
+    assert(msg);
+
+    zmsg_addstr(msg, "uptime_sec");
+    zmsg_addstr(msg, std::to_string((zclock_mono() - self->started_ms) / 1000).c_str());
+    for (int i = 0; i < STATS_COUNTERS; i++) {
+        zmsg_addstr(msg, s_counter_names[i]);
+        zmsg_addstr(msg, std::to_string(stats_get(self, stats_counter_t(i))).c_str());
+    }
+    for (int i = 0; i < STATS_GAUGES; i++) {
+        zmsg_addstr(msg, s_gauge_names[i]);
+        zmsg_addstr(msg, std::to_string(stats_gauge(self, stats_gauge_t(i))).c_str());
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Add all the latency distributions to the message as name/count/p50/p99/max frames
+void stats_add_latency_to_msg(stats_t* self, zmsg_t* msg, bool reset)
+{
+    assert(self);
+    assert(msg);
+
+    for (int i = 0; i < STATS_HISTOGRAMS; i++) {
+        histogram_summary_t summary = histogram_summary(&self->histograms[i], reset);
+        zmsg_addstr(msg, s_histogram_names[i]);
+        zmsg_addstr(msg, std::to_string(summary.count).c_str());
+        zmsg_addstr(msg, std::to_string(summary.p50).c_str());
+        zmsg_addstr(msg, std::to_string(summary.p99).c_str());
+        zmsg_addstr(msg, std::to_string(summary.max).c_str());
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Publish all the statistics and counter rates since the last publication into fty_shm
+int stats_publish(stats_t* self, const char* asset, const char* prefix, int ttl_sec)
+{
+    assert(self);
+    assert(asset);
+    assert(prefix);
+
+    int64_t now_ms     = zclock_mono();
+    int64_t elapsed_ms = now_ms - self->published_ms;
+    int     rv         = 0;
+
+    for (int i = 0; i < STATS_COUNTERS; i++) {
+        uint64_t    value = stats_get(self, stats_counter_t(i));
+        std::string name  = std::string(prefix) + s_counter_names[i];
+        rv |= fty::shm::write_metric(asset, name, std::to_string(value), "", ttl_sec);
+        if (elapsed_ms > 0) {
+            double rate = double(value - self->published[i]) * 1000.0 / double(elapsed_ms);
+            rv |= fty::shm::write_metric(asset, name + "_rate", std::to_string(rate), "/s", ttl_sec);
+        }
+        self->published[i] = value;
+    }
+    for (int i = 0; i < STATS_GAUGES; i++) {
+        rv |= fty::shm::write_metric(asset, std::string(prefix) + s_gauge_names[i],
+            std::to_string(stats_gauge(self, stats_gauge_t(i))), "", ttl_sec);
+    }
+    self->published_ms = now_ms;
+
+    if (rv != 0) {
+        logError("stats: failed to publish statistics of '{}' into shm", asset);
+        return -1;
+    }
+    return 0;
+}
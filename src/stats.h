@@ -0,0 +1,157 @@
+/*  =========================================================================
+    stats - Runtime statistics of the agent
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "histogram.h"
+#include <atomic>
+#include <czmq.h>
+
+/// monotonically increasing counters
+enum stats_counter_t
+{
+    STATS_MSG_METRICS,             //!< messages from METRICS stream
+    STATS_MSG_METRICS_SENSOR,      //!< messages from _METRICS_SENSOR stream
+    STATS_MSG_METRICS_UNAVAILABLE, //!< messages from _METRICS_UNAVAILABLE stream
+    STATS_MSG_ASSETS,              //!< messages from ASSETS stream
+    STATS_MSG_MAILBOX,             //!< mailbox requests
+    STATS_MSG_OTHER,               //!< messages from other streams
+    STATS_DECODE_FAILURES,         //!< messages which are not valid fty_proto
+    STATS_METRICS_FROM_FUTURE,     //!< metrics ignored because their time is in the future
+    STATS_TOUCHES,                 //!< metrics which updated a tracked asset
+    STATS_ASSETS_ADDED,            //!< assets added to the cache
+    STATS_ASSETS_DELETED,          //!< assets removed from the cache
+    STATS_SHM_POLLS,               //!< fty_shm polls
+    STATS_SHM_METRICS,             //!< metrics read from fty_shm
+    STATS_DEAD_CHECKS,             //!< checks of dead devices
+    STATS_ALERTS_ACTIVE,           //!< ACTIVE alerts sent
+    STATS_ALERTS_RESOLVED,         //!< RESOLVED alerts sent
+    STATS_DEAD_CHECKS_DEFERRED,    //!< checks of dead devices deferred in protective mode
+    STATS_DUPLICATES,              //!< metrics dropped, because newer ones were already applied
+    STATS_WAVES,                   //!< waves of correlated outages detected
+    STATS_METRICS_SKEWED,          //!< metrics accepted from devices whose clock is ahead
+    STATS_CLOCK_JUMPS,             //!< steps of the wall clock of the host
+    STATS_REPLICA_SENT,            //!< changes of the state sent to the standby agent
+    STATS_REPLICA_APPLIED,         //!< changes of the state received from the leader agent
+    STATS_COUNTERS
+};
+
+/// last measured values
+enum stats_gauge_t
+{
+    STATS_ASSETS_TRACKED,  //!< assets in the cache
+    STATS_ASSETS_DEAD,     //!< dead assets found by the last check
+    STATS_ALERTS_TRACKED,  //!< active alerts
+    STATS_DEAD_CHECK_USEC, //!< duration of the last check of dead devices
+    STATS_SHM_POLL_USEC,   //!< duration of the last fty_shm poll
+    STATS_INGEST_LAG_MS,   //!< lag of the freshest stream metric in the last check period
+    STATS_INGEST_BACKLOG,  //!< max number of stream messages waiting in the last check period
+    STATS_PROTECTIVE,      //!< 1 if dead checks are deferred, because the agent is behind
+    STATS_ALERTS_HELD,     //!< alerts held by running waves of correlated outages
+    STATS_STANDBY,         //!< 1 if the agent is a standby replica, which doesn't publish alerts
+    STATS_GAUGES
+};
+
+/// latency distributions, in microseconds
+enum stats_histogram_t
+{
+    STATS_LATENCY_STREAM_MESSAGE,     //!< handling of one message from malamute
+    STATS_LATENCY_DEAD_CHECK,         //!< check of dead devices
+    STATS_LATENCY_METRIC_PROCESSING,  //!< processing of metrics read from fty_shm
+    STATS_LATENCY_SHM_READ,           //!< fty::shm::read_metrics
+    STATS_LATENCY_SAVE,               //!< saving of the state file
+    STATS_LATENCY_OUTAGE_DETECTION,   //!< from expiration of the asset to ACTIVE alert
+    STATS_LATENCY_RECOVERY_DETECTION, //!< from metric of recovered asset to RESOLVED alert
+    STATS_LATENCY_METRIC_AGE,         //!< from time of the metric to its processing
+    STATS_LATENCY_INGEST_LAG,         //!< from time of the stream metric to its receiving
+    STATS_HISTOGRAMS
+};
+
+///  Structure of our class, values are updated from both actor and shm polling threads
+struct _stats_t
+{
+    std::atomic<uint64_t> counters[STATS_COUNTERS];     //!< counters
+    std::atomic<uint64_t> gauges[STATS_GAUGES];         //!< gauges
+    histogram_t           histograms[STATS_HISTOGRAMS]; //!< latency distributions
+    uint64_t              published[STATS_COUNTERS];    //!< counters at the last publication
+    int64_t               started_ms;                   //!< when the statistics started (monotonic)
+    int64_t               published_ms;                 //!< when the statistics were last published (monotonic)
+};
+
+typedef struct _stats_t stats_t;
+
+///  Create new statistics, all zero
+stats_t* stats_new(void);
+
+///  Destroy the statistics
+void stats_destroy(stats_t** self_p);
+
+///  Increment counter
+inline void stats_inc(stats_t* self, stats_counter_t counter, uint64_t value = 1)
+{
+    self->counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+///  Set gauge
+inline void stats_set(stats_t* self, stats_gauge_t gauge, uint64_t value)
+{
+    self->gauges[gauge].store(value, std::memory_order_relaxed);
+}
+
+///  Get counter
+inline uint64_t stats_get(stats_t* self, stats_counter_t counter)
+{
+    return self->counters[counter].load(std::memory_order_relaxed);
+}
+
+///  Get gauge
+inline uint64_t stats_gauge(stats_t* self, stats_gauge_t gauge)
+{
+    return self->gauges[gauge].load(std::memory_order_relaxed);
+}
+
+///  Name of the counter
+const char* stats_counter_name(stats_counter_t counter);
+
+///  Name of the gauge
+const char* stats_gauge_name(stats_gauge_t gauge);
+
+///  Latency distribution
+inline histogram_t* stats_histogram(stats_t* self, stats_histogram_t histogram)
+{
+    return &self->histograms[histogram];
+}
+
+///  Name of the latency distribution
+const char* stats_histogram_name(stats_histogram_t histogram);
+
+///  Add all the statistics to the message as name/value frames
+void stats_add_to_msg(stats_t* self, zmsg_t* msg);
+
+///  Add all the latency distributions to the message as name/count/p50/p99/max frames,
+///  the distributions start again if 'reset' is true
+void stats_add_latency_to_msg(stats_t* self, zmsg_t* msg, bool reset);
+
+///  Publish all the statistics and counter rates since the last publication into fty_shm
+///  as metrics of 'asset' prefixed by 'prefix'
+///  return -1, if some metric was not written
+///  return 0 otherwise
+int stats_publish(stats_t* self, const char* asset, const char* prefix, int ttl_sec);
@@ -0,0 +1,94 @@
+/*  =========================================================================
+    vclock - Source of time, real or simulated
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "vclock.h"
+
+//  --------------------------------------------------------------------------
+//  Create a new clock following the real time
+vclock_t* vclock_new(void)
+{
+    vclock_t* self = new vclock_t();
+    self->simulated.store(false);
+    self->wall_ms.store(0);
+    self->mono_ms.store(0);
+    self->seen_wall = 0;
+    self->seen_mono = 0;
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the clock
+void vclock_destroy(vclock_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        delete *self_p;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Switch the clock to simulated time starting at unix time 'wall_ms'
+void vclock_simulate(vclock_t* self, int64_t wall_ms)
+{
+    assert(self);
+    self->wall_ms.store(wall_ms);
+    self->mono_ms.store(vclock_mono(self));
+    self->simulated.store(true);
+    // switch of the time is not a jump
+    self->seen_wall = 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Move simulated clock forward by 'ms'
+int vclock_advance(vclock_t* self, int64_t ms)
+{
+    assert(self);
+    if (!self->simulated.load() || ms < 0)
+        return -1;
+    self->wall_ms.fetch_add(ms);
+    self->mono_ms.fetch_add(ms);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Step simulated unix time by 'ms', monotonic time stays
+int vclock_step(vclock_t* self, int64_t ms)
+{
+    assert(self);
+    if (!self->simulated.load())
+        return -1;
+    self->wall_ms.fetch_add(ms);
+    return 0;
+}
+
+//  --------------------------------------------------------------------------
+//  Milliseconds unix time jumped since the previous call
+int64_t vclock_jump(vclock_t* self)
+{
+    assert(self);
+    int64_t wall_ms = vclock_time(self);
+    int64_t mono_ms = vclock_mono(self);
+    int64_t jump_ms = self->seen_wall != 0 ? (wall_ms - self->seen_wall) - (mono_ms - self->seen_mono) : 0;
+    self->seen_wall = wall_ms;
+    self->seen_mono = mono_ms;
+    return jump_ms;
+}
@@ -0,0 +1,83 @@
+/*  =========================================================================
+    vclock - Source of time, real or simulated
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <czmq.h>
+
+///  Structure of our class, simulated time is read from both actor and shm polling threads
+struct _vclock_t
+{
+    std::atomic<bool>    simulated; //!< time moves only when advanced
+    std::atomic<int64_t> wall_ms;   //!< simulated unix time
+    std::atomic<int64_t> mono_ms;   //!< simulated monotonic time
+    int64_t              seen_wall; //!< unix time at the last vclock_jump, used by the actor only
+    int64_t              seen_mono; //!< monotonic time at the last vclock_jump, used by the actor only
+};
+
+typedef struct _vclock_t vclock_t;
+
+///  Create a new clock following the real time
+vclock_t* vclock_new(void);
+
+///  Destroy the clock
+void vclock_destroy(vclock_t** self_p);
+
+///  Switch the clock to simulated time starting at unix time 'wall_ms',
+///  monotonic time continues from the current one
+void vclock_simulate(vclock_t* self, int64_t wall_ms);
+
+///  Move simulated clock forward by 'ms'
+///  return -1, if the clock is not simulated
+///  return 0 otherwise
+int vclock_advance(vclock_t* self, int64_t ms);
+
+///  Step simulated unix time by 'ms' (may be negative), monotonic time stays, as NTP step does
+///  return -1, if the clock is not simulated
+///  return 0 otherwise
+int vclock_step(vclock_t* self, int64_t ms);
+
+///  Compare progress of unix and monotonic time since the previous call
+///  return milliseconds unix time jumped forward (or backward, if negative), 0 on the first call
+int64_t vclock_jump(vclock_t* self);
+
+///  Unix time in milliseconds, as zclock_time
+inline int64_t vclock_time(vclock_t* self)
+{
+    if (self->simulated.load(std::memory_order_relaxed))
+        return self->wall_ms.load(std::memory_order_relaxed);
+    return zclock_time();
+}
+
+///  Monotonic time in milliseconds, as zclock_mono
+inline int64_t vclock_mono(vclock_t* self)
+{
+    if (self->simulated.load(std::memory_order_relaxed))
+        return self->mono_ms.load(std::memory_order_relaxed);
+    return zclock_mono();
+}
+
+///  Unix time in seconds
+inline uint64_t vclock_time_sec(vclock_t* self)
+{
+    return uint64_t(vclock_time(self) / 1000);
+}
@@ -0,0 +1,238 @@
+/*  =========================================================================
+    wave - Detection of correlated outages of many assets
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "wave.h"
+#include <algorithm>
+#include <map>
+
+// children of one parent device
+struct wave_family_t
+{
+    std::vector<const std::string*> expired;  //!< children expired in this check
+    size_t                          children; //!< monitored children
+    size_t                          dead;     //!< monitored children which are dead
+};
+
+// is the asset dead (expired and not in maintenance)
+static bool s_wave_dead(expiration_t* e, uint64_t now_sec)
+{
+    return e != NULL && e->maintenance_until_sec == 0 && expiration_get(e) <= now_sec;
+}
+
+// parent device of the asset, NULL if not known
+static const char* s_wave_parent(expiration_t* e)
+{
+    const char* parent = e && e->msg ? fty_proto_aux_string(e->msg, ASSET_PARENT_NAME, NULL) : NULL;
+    return parent && *parent ? parent : NULL;
+}
+
+// running wave of 'origin', NULL if there is none
+static wave_running_t* s_wave_find(wave_t* self, const char* origin)
+{
+    for (auto& wave : self->waves) {
+        if (wave.origin == origin)
+            return &wave;
+    }
+    return NULL;
+}
+
+// start 'wave' and hold alerts of its 'assets'
+static void s_wave_start(wave_t* self, wave_running_t& wave, const std::vector<const std::string*>& assets)
+{
+    for (const auto* asset : assets)
+        zhashx_update(self->held, asset->c_str(), strdup(wave.origin.c_str()));
+    self->waves.push_back(wave);
+}
+
+static void s_wave_free(void** ptr)
+{
+    zstr_free(reinterpret_cast<char**>(ptr));
+}
+
+//  --------------------------------------------------------------------------
+//  Create a new wave detector with default settings
+wave_t* wave_new(void)
+{
+    wave_t* self = new wave_t();
+    self->held   = zhashx_new();
+    zhashx_set_destructor(self->held, s_wave_free);
+    wave_configure(
+        self, DEFAULT_WAVE_MIN_ASSETS, DEFAULT_WAVE_SHARE_PERCENT, DEFAULT_WAVE_MIN_CHILDREN, DEFAULT_WAVE_HOLD_SEC);
+    return self;
+}
+
+//  --------------------------------------------------------------------------
+//  Destroy the wave detector
+void wave_destroy(wave_t** self_p)
+{
+    assert(self_p);
+    if (*self_p) {
+        wave_t* self = *self_p;
+        zhashx_destroy(&self->held);
+        delete self;
+        *self_p = NULL;
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Set thresholds of the detection
+void wave_configure(wave_t* self, uint32_t min_assets, uint32_t share, uint32_t min_children, uint64_t hold_sec)
+{
+    assert(self);
+    self->min_assets   = min_assets;
+    self->share        = std::min(share, uint32_t(100));
+    self->min_children = std::max(min_children, uint32_t(2));
+    self->hold_sec     = hold_sec;
+}
+
+//  --------------------------------------------------------------------------
+//  Wall clock stepped by 'jump_sec', move running waves along
+void wave_shift_time(wave_t* self, int64_t jump_sec)
+{
+    assert(self);
+    for (auto& wave : self->waves) {
+        wave.started_sec = uint64_t(std::max(int64_t(wave.started_sec) + jump_sec, int64_t(1)));
+        wave.confirm_sec = uint64_t(std::max(int64_t(wave.confirm_sec) + jump_sec, int64_t(1)));
+    }
+}
+
+//  --------------------------------------------------------------------------
+//  Find waves among assets which expired in this check
+std::vector<wave_running_t> wave_detect(
+    wave_t* self, data_t* data, const std::vector<std::string>& expired, bool received, uint64_t now_sec)
+{
+    assert(self);
+    assert(data);
+
+    std::vector<wave_running_t> started;
+    if (self->min_assets == 0 || expired.empty())
+        return started;
+
+    // assets of running waves join them, the others are grouped by parent
+    std::vector<const std::string*>       fresh;
+    std::map<std::string, wave_family_t> families;
+    for (const auto& asset : expired) {
+        expiration_t*   e      = reinterpret_cast<expiration_t*>(zhashx_lookup(data->assets, asset.c_str()));
+        const char*     parent = s_wave_parent(e);
+        wave_running_t* wave   = parent ? s_wave_find(self, parent) : NULL;
+        if (!wave)
+            wave = s_wave_find(self, "");
+        if (wave) {
+            zhashx_update(self->held, asset.c_str(), strdup(wave->origin.c_str()));
+            wave->assets++;
+            continue;
+        }
+        fresh.push_back(&asset);
+        if (parent)
+            families[parent].expired.push_back(&asset);
+    }
+    if (fresh.empty())
+        return started;
+
+    // drop parents with few expired children before looking at all the assets
+    for (auto it = families.begin(); it != families.end();) {
+        if (it->second.expired.size() < self->min_children)
+            it = families.erase(it);
+        else
+            ++it;
+    }
+    size_t monitored = 0;
+    if (!families.empty() || fresh.size() >= self->min_assets) {
+        for (void* it = zhashx_first(data->assets); it != NULL; it = zhashx_next(data->assets)) {
+            expiration_t* e = static_cast<expiration_t*>(it);
+            if (e->maintenance_until_sec != 0)
+                continue;
+            monitored++;
+            const char* parent = families.empty() ? NULL : s_wave_parent(e);
+            auto        family = parent ? families.find(parent) : families.end();
+            if (family != families.end()) {
+                family->second.children++;
+                family->second.dead += s_wave_dead(e, now_sec);
+            }
+        }
+    }
+
+    // all children of one device expired
+    for (const auto& family : families) {
+        if (family.second.dead < family.second.children)
+            continue;
+        wave_running_t wave = {WAVE_PARENT, family.first, now_sec, now_sec + self->hold_sec,
+            family.second.expired.size(), family.second.children, 0};
+        s_wave_start(self, wave, family.second.expired);
+        started.push_back(wave);
+    }
+
+    // large share of the monitored assets expired
+    std::vector<const std::string*> rest;
+    for (const auto* asset : fresh) {
+        if (!wave_held(self, asset->c_str()))
+            rest.push_back(asset);
+    }
+    if (rest.size() >= self->min_assets && rest.size() * 100 >= monitored * self->share) {
+        wave_running_t wave = {received ? WAVE_NETWORK : WAVE_SOURCE, "", now_sec, now_sec + self->hold_sec,
+            rest.size(), monitored, 0};
+        s_wave_start(self, wave, rest);
+        started.push_back(wave);
+    }
+    return started;
+}
+
+//  --------------------------------------------------------------------------
+//  End waves whose hold elapsed or whose assets all came back
+std::vector<wave_running_t> wave_settle(wave_t* self, data_t* data, uint64_t now_sec)
+{
+    assert(self);
+    assert(data);
+
+    std::vector<wave_running_t> ended;
+    if (self->waves.empty())
+        return ended;
+
+    // dead assets of each wave
+    std::map<std::string, size_t> dead;
+    for (void* it = zhashx_first(self->held); it != NULL; it = zhashx_next(self->held)) {
+        const char*   asset = static_cast<const char*>(zhashx_cursor(self->held));
+        expiration_t* e     = reinterpret_cast<expiration_t*>(zhashx_lookup(data->assets, asset));
+        dead[static_cast<const char*>(it)] += s_wave_dead(e, now_sec);
+    }
+
+    for (auto it = self->waves.begin(); it != self->waves.end();) {
+        it->dead = dead[it->origin];
+        if (now_sec < it->confirm_sec && it->dead != 0) {
+            ++it;
+            continue;
+        }
+        ended.push_back(*it);
+        it = self->waves.erase(it);
+    }
+    if (ended.empty())
+        return ended;
+
+    // release assets of the ended waves
+    std::vector<std::string> released;
+    for (void* it = zhashx_first(self->held); it != NULL; it = zhashx_next(self->held)) {
+        if (!s_wave_find(self, static_cast<const char*>(it)))
+            released.push_back(static_cast<const char*>(zhashx_cursor(self->held)));
+    }
+    for (const auto& asset : released)
+        zhashx_delete(self->held, asset.c_str());
+    return ended;
+}
@@ -0,0 +1,97 @@
+/*  =========================================================================
+    wave - Detection of correlated outages of many assets
+
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "data.h"
+#include <czmq.h>
+#include <string>
+#include <vector>
+
+/// wave is a burst of assets expiring in the same check of dead devices, either all the children of one
+/// device, or a large share of the monitored assets. Alerts of the assets in a wave are held until the wave
+/// is confirmed, assets still dead then are real outages.
+#define DEFAULT_WAVE_MIN_ASSETS    20 // assets expiring at once to be a wave, 0 disables the detection
+#define DEFAULT_WAVE_SHARE_PERCENT 10 // ... which are at least this percentage of the monitored assets
+#define DEFAULT_WAVE_MIN_CHILDREN  5  // all children of one device expiring at once, at least this many
+#define DEFAULT_WAVE_HOLD_SEC      300 // alerts of the assets in a wave are held this long
+
+///  Likely common cause of a wave
+enum wave_cause_t
+{
+    WAVE_SOURCE  = 0, //!< no metric was received in the check, source of metrics (fty_shm writer, broker) is down
+    WAVE_NETWORK = 1, //!< metrics of other assets still come, network segment is down
+    WAVE_PARENT  = 2  //!< all children of one device expired, the device or its link is down
+};
+
+///  One wave
+struct wave_running_t
+{
+    wave_cause_t cause;       //!< likely common cause
+    std::string  origin;      //!< parent device, empty for waves of the whole agent
+    uint64_t     started_sec; //!< when the wave was detected
+    uint64_t     confirm_sec; //!< when alerts of the assets still dead are released
+    size_t       assets;      //!< assets in the wave
+    size_t       monitored;   //!< monitored assets (children of the parent) when the wave was detected
+    size_t       dead;        //!< assets of the wave still dead when it ended (filled by wave_settle)
+};
+
+///  Structure of our class
+struct _wave_t
+{
+    uint32_t                    min_assets;   //!< assets expiring at once to be a wave, 0 disables the detection
+    uint32_t                    share;        //!< percentage of the monitored assets expiring at once to be a wave
+    uint32_t                    min_children; //!< children of one device expiring at once to be a wave
+    uint64_t                    hold_sec;     //!< how long alerts of the assets in a wave are held
+    std::vector<wave_running_t> waves;        //!< running waves
+    zhashx_t*                   held;         //!< asset name -> origin of its wave
+};
+
+typedef struct _wave_t wave_t;
+
+///  Create a new wave detector with default settings
+wave_t* wave_new(void);
+
+///  Destroy the wave detector
+void wave_destroy(wave_t** self_p);
+
+///  Set thresholds of the detection, min_assets == 0 disables it, running waves are kept
+void wave_configure(wave_t* self, uint32_t min_assets, uint32_t share, uint32_t min_children, uint64_t hold_sec);
+
+///  Wall clock stepped by 'jump_sec' (negative when backward), move running waves along, so they are held
+///  for the whole hold time
+void wave_shift_time(wave_t* self, int64_t jump_sec);
+
+///  Is alert of the asset held by a running wave
+inline bool wave_held(wave_t* self, const char* asset_name)
+{
+    return zhashx_size(self->held) != 0 && zhashx_lookup(self->held, asset_name) != NULL;
+}
+
+///  Find waves among assets which expired in this check, 'received' tells if some metric was received since
+///  the previous check. Expired assets joining a running wave of the same cause are held too.
+///  returns new waves, their assets are held
+std::vector<wave_running_t> wave_detect(
+    wave_t* self, data_t* data, const std::vector<std::string>& expired, bool received, uint64_t now_sec);
+
+///  End waves whose hold elapsed or whose assets all came back, their assets are released
+///  returns ended waves
+std::vector<wave_running_t> wave_settle(wave_t* self, data_t* data, uint64_t now_sec);
@@ -0,0 +1,104 @@
+#include "src/availability.h"
+#include "src/data.h"
+#include <catch2/catch.hpp>
+
+// aligned to the buckets of all the windows
+static const uint64_t START = 20000 * 24 * 60 * 60;
+
+TEST_CASE("availability windows")
+{
+    CHECK(availability_window_sec(AVAILABILITY_1H) == 60 * 60);
+    CHECK(availability_window_sec(AVAILABILITY_24H) == 24 * 60 * 60);
+    CHECK(availability_window_sec(AVAILABILITY_30D) == 30 * 24 * 60 * 60);
+    CHECK(streq(availability_window_str(AVAILABILITY_30D), "30d"));
+
+    availability_t* availability = availability_new(START);
+    REQUIRE(availability);
+
+    // nothing observed yet
+    availability_report_t report = availability_get(availability, AVAILABILITY_1H, START);
+    CHECK(report.observed_sec == 0);
+    CHECK(report.percent == 100.0);
+
+    // 10 minutes outage
+    availability_down(availability, START + 600, START + 700);
+    availability_down(availability, START + 650, START + 700);
+    availability_up(availability, START + 1200, START + 1200);
+    report = availability_get(availability, AVAILABILITY_1H, START + 1800);
+    CHECK(report.outage_sec == 600);
+    CHECK(report.observed_sec == 1800);
+    CHECK(report.percent == Approx(100.0 * 2 / 3));
+    CHECK(availability_get(availability, AVAILABILITY_24H, START + 1800).outage_sec == 600);
+
+    // ongoing outage is counted up to now
+    availability_down(availability, START + 1800, START + 1800);
+    CHECK(availability_get(availability, AVAILABILITY_1H, START + 2100).outage_sec == 900);
+    // recovery seen later than the device came back
+    availability_up(availability, START + 1900, START + 2100);
+    CHECK(availability_get(availability, AVAILABILITY_1H, START + 2100).outage_sec == 700);
+    CHECK(availability_get(availability, AVAILABILITY_30D, START + 2100).outage_sec == 700);
+
+    // outage can't start before the previous one ended
+    availability_down(availability, START + 1000, START + 2400);
+    availability_up(availability, START + 2400, START + 2400);
+    CHECK(availability_get(availability, AVAILABILITY_1H, START + 2400).outage_sec == 1200);
+
+    // outages leave the short window first
+    report = availability_get(availability, AVAILABILITY_1H, START + 2 * 3600);
+    CHECK(report.outage_sec == 0);
+    CHECK(report.observed_sec == 3600 - 300);
+    CHECK(report.percent == 100.0);
+    report = availability_get(availability, AVAILABILITY_24H, START + 2 * 3600);
+    CHECK(report.outage_sec == 1200);
+    CHECK(report.observed_sec == 2 * 3600);
+    CHECK(availability_get(availability, AVAILABILITY_30D, START + 40 * 24 * 3600).outage_sec == 0);
+
+    // outage longer than the windows
+    uint64_t now_sec = START + 40 * 24 * 3600;
+    availability_down(availability, now_sec, now_sec);
+    now_sec += 2 * 24 * 3600 + 100;
+    CHECK(availability_get(availability, AVAILABILITY_1H, now_sec).percent == 0.0);
+    CHECK(availability_get(availability, AVAILABILITY_24H, now_sec).percent == 0.0);
+    report = availability_get(availability, AVAILABILITY_30D, now_sec);
+    CHECK(report.outage_sec == 2 * 24 * 3600 + 100);
+    availability_up(availability, now_sec, now_sec);
+    CHECK(availability_get(availability, AVAILABILITY_30D, now_sec + 1000).outage_sec == 2 * 24 * 3600 + 100);
+
+    availability_destroy(&availability);
+    CHECK(availability == NULL);
+}
+
+TEST_CASE("availability of assets")
+{
+    data_t* data = data_new();
+    REQUIRE(data);
+    vclock_simulate(data->clock, int64_t(START) * 1000);
+
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, "type", const_cast<char*>("device"));
+    zhash_insert(aux, "subtype", const_cast<char*>("ups"));
+    zmsg_t*      msg   = fty_proto_encode_asset(aux, "UPS1", "create", NULL);
+    fty_proto_t* proto = fty_proto_decode(&msg);
+    data_put(data, &proto);
+    zhash_destroy(&aux);
+
+    availability_report_t reports[AVAILABILITY_WINDOWS];
+    CHECK(data_get_availability(data, "UPS2", START + 60, reports) == -1);
+
+    // asset never down
+    REQUIRE(data_get_availability(data, "UPS1", START + 600, reports) == 0);
+    for (const auto& report : reports) {
+        CHECK(report.observed_sec == 600);
+        CHECK(report.percent == 100.0);
+    }
+
+    data_availability_down(data, "UPS1", START + 600, START + 900);
+    data_availability_up(data, "UPS1", START + 900, START + 900);
+    REQUIRE(data_get_availability(data, "UPS1", START + 1200, reports) == 0);
+    for (const auto& report : reports) {
+        CHECK(report.outage_sec == 300);
+        CHECK(report.percent == Approx(75.0));
+    }
+
+    data_destroy(&data);
+}
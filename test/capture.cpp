@@ -0,0 +1,90 @@
+#include "src/capture.h"
+#include <catch2/catch.hpp>
+#include <fty_proto.h>
+
+static const char* TRACE = "capture-test.bin";
+
+static fty_proto_t* s_metric(uint64_t time, const char* type, const char* name, const char* value)
+{
+    zmsg_t* msg = fty_proto_encode_metric(NULL, time, 60, type, name, value, "%");
+    return fty_proto_decode(&msg);
+}
+
+TEST_CASE("capture round trip")
+{
+    capture_t* capture = capture_new();
+    REQUIRE(capture);
+    CHECK(!capture_active(capture));
+
+    // nothing is written while the capture is not running
+    zmsg_t* msg = fty_proto_encode_metric(NULL, 1000, 60, "status.ups", "UPS-1", "1", "");
+    capture_message(capture, 1, "STREAM DELIVER", "METRICS", "agent", "status.ups@UPS-1", msg);
+
+    REQUIRE(capture_start(capture, TRACE) == 0);
+    CHECK(capture_active(capture));
+    capture_message(capture, 1000123, "STREAM DELIVER", "METRICS", "agent", "status.ups@UPS-1", msg);
+    zmsg_destroy(&msg);
+
+    fty::shm::shmMetrics shard0, shard1;
+    shard0.add(s_metric(1001, "load.input", "UPS-2", "5"));
+    shard1.add(s_metric(1002, "load.input", "UPS-3", "7"));
+    capture_metrics(capture, 1002000, {&shard0, &shard1});
+
+    msg = zmsg_new();
+    zmsg_addstr(msg, "REQUEST");
+    zmsg_addstr(msg, "1234");
+    zmsg_addstr(msg, "STATUS");
+    capture_message(capture, 1003000, "MAILBOX DELIVER", "fty-outage", "client", "", msg);
+    zmsg_destroy(&msg);
+    capture_destroy(&capture);
+
+    FILE* trace = capture_open(TRACE);
+    REQUIRE(trace);
+    capture_record_t record = {};
+
+    REQUIRE(capture_read(trace, record) == 0);
+    CHECK(record.kind == CAPTURE_MESSAGE);
+    CHECK(record.time_ms == 1000123);
+    CHECK(record.command == "STREAM DELIVER");
+    CHECK(record.address == "METRICS");
+    CHECK(record.sender == "agent");
+    CHECK(record.subject == "status.ups@UPS-1");
+    REQUIRE(fty_proto_is(record.content));
+    fty_proto_t* metric = fty_proto_decode(&record.content);
+    REQUIRE(metric);
+    CHECK(streq(fty_proto_name(metric), "UPS-1"));
+    CHECK(fty_proto_time(metric) == 1000);
+    fty_proto_destroy(&metric);
+
+    REQUIRE(capture_read(trace, record) == 0);
+    CHECK(record.kind == CAPTURE_METRICS);
+    CHECK(record.time_ms == 1002000);
+    // shards of one poll are one record
+    fty::shm::shmMetrics read;
+    capture_record_metrics(record, read);
+    REQUIRE(read.size() == 2);
+    auto it = read.begin();
+    CHECK(streq(fty_proto_name(*it), "UPS-2"));
+    CHECK(streq(fty_proto_type(*it), "load.input"));
+    CHECK(streq(fty_proto_value(*it), "5"));
+    CHECK(streq(fty_proto_unit(*it), "%"));
+    ++it;
+    CHECK(streq(fty_proto_name(*it), "UPS-3"));
+    CHECK(fty_proto_time(*it) == 1002);
+
+    REQUIRE(capture_read(trace, record) == 0);
+    CHECK(record.kind == CAPTURE_MESSAGE);
+    CHECK(record.command == "MAILBOX DELIVER");
+    CHECK(record.subject == "");
+    REQUIRE(zmsg_size(record.content) == 3);
+    char* frame = zmsg_popstr(record.content);
+    CHECK(streq(frame, "REQUEST"));
+    zstr_free(&frame);
+
+    CHECK(capture_read(trace, record) == -1);
+    CHECK(record.content == NULL);
+    fclose(trace);
+
+    CHECK(capture_open("capture-missing.bin") == NULL);
+    zsys_file_delete(TRACE);
+}
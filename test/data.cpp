@@ -131,8 +131,466 @@ TEST_CASE("data test")
 
     CHECK(streq(data_get_asset_ename(data, "PDU1"), "ename_of_pdu1"));
 
+    // metric from future is ignored
+    now_sec = uint64_t(zclock_time() / 1000);
+    rv      = data_touch_asset(data, "UPS4", now_sec + 100, 2, now_sec);
+    CHECK(rv == -1);
+
+    // the same heartbeat from fty_shm and from the stream is applied once, unless it shortens ttl
+    CHECK(data_touch_asset(data, "UPS4", now_sec + 1, 2, now_sec + 1) == 0);
+    CHECK(data_touch_asset(data, "UPS4", now_sec + 1, 2, now_sec + 1) == 1);
+    CHECK(data_touch_asset(data, "UPS4", now_sec, 2, now_sec + 1) == 1);
+    CHECK(data_touch_asset(data, "UPS4", now_sec + 1, 1, now_sec + 1) == 0);
+
+    // statistics
+    CHECK(stats_get(data->stats, STATS_ASSETS_ADDED) == 3);
+    CHECK(stats_get(data->stats, STATS_TOUCHES) == 5);
+    CHECK(stats_get(data->stats, STATS_DUPLICATES) == 2);
+    CHECK(stats_get(data->stats, STATS_METRICS_FROM_FUTURE) == 1);
+    data_delete(data, "PDU1");
+    data_delete(data, "PDU1");
+    CHECK(stats_get(data->stats, STATS_ASSETS_DELETED) == 1);
+
     fty_proto_destroy(&proto_n);
     zhash_destroy(&aux);
     zhash_destroy(&ext);
     data_destroy(&data);
 }
+
+TEST_CASE("data flap damping")
+{
+    data_t* data = data_new();
+    REQUIRE(data);
+    data_set_flap_damping(data, 100, 2500, 750);
+
+    zhash_t* asset_aux = zhash_new();
+    zhash_insert(asset_aux, "type", const_cast<char*>("device"));
+    zhash_insert(asset_aux, "subtype", const_cast<char*>("ups"));
+    zmsg_t*      asset   = fty_proto_encode_asset(asset_aux, "UPS1", "create", NULL);
+    fty_proto_t* proto_n = fty_proto_decode(&asset);
+    data_put(data, &proto_n);
+    zhash_destroy(&asset_aux);
+
+    uint64_t now_sec = 1000000;
+
+    // unknown asset is never flapping
+    CHECK(!data_flap_observe(data, "UNKNOWN", true, now_sec));
+
+    // two outages are published
+    CHECK(!data_flap_observe(data, "UPS1", true, now_sec));
+    CHECK(!data_flap_observe(data, "UPS1", false, now_sec + 1));
+    CHECK(!data_flap_observe(data, "UPS1", true, now_sec + 2));
+    CHECK(!data_flap_observe(data, "UPS1", false, now_sec + 3));
+    // repeated observation is not a transition
+    CHECK(!data_flap_observe(data, "UPS1", false, now_sec + 4));
+
+    // third outage in a row makes the asset flapping
+    CHECK(data_flap_observe(data, "UPS1", true, now_sec + 5));
+    CHECK(data_flap_observe(data, "UPS1", false, now_sec + 6));
+    auto flapping = data_get_flapping(data);
+    REQUIRE(flapping.size() == 1);
+    CHECK(flapping[0] == "UPS1");
+
+    // not decayed enough
+    CHECK(data_flap_settle(data, now_sec + 10).empty());
+
+    // ~3000 -> under 750 after two half-lives
+    auto settled = data_flap_settle(data, now_sec + 6 + 300);
+    REQUIRE(settled.size() == 1);
+    CHECK(settled[0] == "UPS1");
+    CHECK(data_get_flapping(data).empty());
+
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(data->assets, "UPS1"));
+    REQUIRE(e);
+    CHECK(!(e->flags & EXPIRATION_FLAG_DOWN));
+
+    // disabled damping
+    data_set_flap_damping(data, 100, 0, 0);
+    for (uint64_t i = 0; i < 10; i++) {
+        CHECK(!data_flap_observe(data, "UPS1", true, now_sec + 400 + 2 * i));
+        CHECK(!data_flap_observe(data, "UPS1", false, now_sec + 401 + 2 * i));
+    }
+
+    data_destroy(&data);
+}
+
+TEST_CASE("data maintenance")
+{
+    data_t* data = data_new();
+    REQUIRE(data);
+    data_set_default_expiry(data, 2);
+
+    zhash_t* asset_aux = zhash_new();
+    zhash_insert(asset_aux, "type", const_cast<char*>("device"));
+    zhash_insert(asset_aux, "subtype", const_cast<char*>("epdu"));
+    for (const char* name : {"epdu-1", "epdu-2"}) {
+        zmsg_t*      asset   = fty_proto_encode_asset(asset_aux, name, "create", NULL);
+        fty_proto_t* proto_n = fty_proto_decode(&asset);
+        data_put(data, &proto_n);
+    }
+
+    uint64_t now_sec = uint64_t(zclock_time() / 1000);
+    CHECK(data_maintenance_enable(data, "UNKNOWN", now_sec + 100) == -1);
+    CHECK(data_maintenance_disable(data, "UNKNOWN") == -1);
+
+    // maintenance is not shortened by metrics
+    REQUIRE(data_maintenance_enable(data, "epdu-1", now_sec + 100) == 0);
+    CHECK(data_in_maintenance(data, "epdu-1"));
+    CHECK(data_touch_asset(data, "epdu-1", now_sec, 1, now_sec) == 0);
+    CHECK(data_in_maintenance(data, "epdu-1"));
+    CHECK(data_maintenance_expire(data, now_sec + 99).empty());
+
+    // assets in maintenance are never dead
+    zclock_sleep(5000);
+    auto dead = data_get_dead(data);
+    REQUIRE(dead.size() == 1);
+    CHECK(dead[0] == "epdu-2");
+
+    // prolonged maintenance leaves a stale deadline behind
+    REQUIRE(data_maintenance_enable(data, "epdu-1", now_sec + 200) == 0);
+    CHECK(data_maintenance_expire(data, now_sec + 150).empty());
+    CHECK(data_in_maintenance(data, "epdu-1"));
+    auto expired = data_maintenance_expire(data, now_sec + 200);
+    REQUIRE(expired.size() == 1);
+    CHECK(expired[0] == "epdu-1");
+    CHECK(!data_in_maintenance(data, "epdu-1"));
+    // ended maintenance restarts the expiration
+    dead = data_get_dead(data);
+    REQUIRE(dead.size() == 1);
+    CHECK(dead[0] == "epdu-2");
+
+    // disabled maintenance
+    REQUIRE(data_maintenance_enable(data, "epdu-2", now_sec + 300) == 0);
+    REQUIRE(data_maintenance_disable(data, "epdu-2") == 0);
+    CHECK(!data_in_maintenance(data, "epdu-2"));
+    CHECK(data_maintenance_expire(data, now_sec + 300).empty());
+
+    // recurring window for epdu-2 only, every 1000s for 100s
+    zconfig_t* root   = zconfig_new("root", NULL);
+    zconfig_t* window = zconfig_new("window", zconfig_new("maintenance", root));
+    zconfig_put(window, "assets", "epdu-2");
+    zconfig_put(window, "start", std::to_string(now_sec + 1000).c_str());
+    zconfig_put(window, "period", "1000");
+    zconfig_put(window, "duration", "100");
+    REQUIRE(data_load_maintenance_windows(data, root, now_sec) == 0);
+
+    CHECK(data_maintenance_windows(data, now_sec + 999).empty());
+    auto entered = data_maintenance_windows(data, now_sec + 1000);
+    REQUIRE(entered.size() == 1);
+    CHECK(entered[0] == "epdu-2");
+    CHECK(data_in_maintenance(data, "epdu-2"));
+    CHECK(!data_in_maintenance(data, "epdu-1"));
+    expired = data_maintenance_expire(data, now_sec + 1100);
+    REQUIRE(expired.size() == 1);
+    CHECK(expired[0] == "epdu-2");
+
+    // next occurrence
+    CHECK(data_maintenance_windows(data, now_sec + 1999).empty());
+    CHECK(data_maintenance_windows(data, now_sec + 2050).size() == 1);
+
+    // invalid window keeps the current ones
+    zconfig_put(window, "duration", "1000");
+    CHECK(data_load_maintenance_windows(data, root, now_sec) == -1);
+
+    zconfig_destroy(&root);
+    zhash_destroy(&asset_aux);
+    data_destroy(&data);
+}
+
+TEST_CASE("data maintenance grace")
+{
+    static const uint64_t START = 1600000000;
+
+    data_t* data = data_new();
+    REQUIRE(data);
+    vclock_simulate(data->clock, int64_t(START) * 1000);
+
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, "type", const_cast<char*>("device"));
+    zhash_insert(aux, "subtype", const_cast<char*>("ups"));
+    zmsg_t*      asset = fty_proto_encode_asset(aux, "ups-1", "create", NULL);
+    fty_proto_t* proto = fty_proto_decode(&asset);
+    data_put(data, &proto);
+    zhash_destroy(&aux);
+    REQUIRE(data_touch_asset(data, "ups-1", START, 60, START) == 0);
+
+    // asset silent through its maintenance (120 s = ttl * multiplier) gets a whole ttl after it expired
+    REQUIRE(data_maintenance_enable(data, "ups-1", START + 1000) == 0);
+    vclock_advance(data->clock, 1000 * 1000);
+    REQUIRE(data_maintenance_expire(data, START + 1000).size() == 1);
+    CHECK(data_get_dead(data).empty());
+    vclock_advance(data->clock, 119 * 1000);
+    CHECK(data_get_dead(data).empty());
+    vclock_advance(data->clock, 1000);
+    CHECK(data_get_dead(data).size() == 1);
+
+    // the same when it is disabled
+    REQUIRE(data_maintenance_enable(data, "ups-1", START + 5000) == 0);
+    vclock_advance(data->clock, 880 * 1000);
+    REQUIRE(data_maintenance_disable(data, "ups-1") == 0);
+    vclock_advance(data->clock, 119 * 1000);
+    CHECK(data_get_dead(data).empty());
+    vclock_advance(data->clock, 1000);
+    CHECK(data_get_dead(data).size() == 1);
+
+    data_destroy(&data);
+}
+
+TEST_CASE("data clock step")
+{
+    static const uint64_t START = 1600000000;
+
+    data_t* data = data_new();
+    REQUIRE(data);
+    vclock_simulate(data->clock, int64_t(START) * 1000);
+
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, "type", const_cast<char*>("device"));
+    zhash_insert(aux, "subtype", const_cast<char*>("ups"));
+    for (const char* name : {"ups-1", "ups-2"}) {
+        zmsg_t*      asset = fty_proto_encode_asset(aux, name, "create", NULL);
+        fty_proto_t* proto = fty_proto_decode(&asset);
+        data_put(data, &proto);
+        REQUIRE(data_touch_asset(data, name, START, 60, START) == 0);
+    }
+    zhash_destroy(&aux);
+
+    // ups-1 in maintenance for 300 s and down, ups-2 in a window until START + 900
+    REQUIRE(data_maintenance_enable(data, "ups-1", START + 600) == 0);
+    data_availability_down(data, "ups-1", START + 300, START + 300);
+    zconfig_t* root   = zconfig_new("root", NULL);
+    zconfig_t* window = zconfig_new("window", zconfig_new("maintenance", root));
+    zconfig_put(window, "assets", "ups-2");
+    zconfig_put(window, "start", std::to_string(START + 300).c_str());
+    zconfig_put(window, "period", "86400");
+    zconfig_put(window, "duration", "600");
+    REQUIRE(data_load_maintenance_windows(data, root, START) == 0);
+    REQUIRE(data_maintenance_windows(data, START + 300).size() == 1);
+    zconfig_destroy(&root);
+
+    // wall clock stepped forward by an hour: the window ended, maintenance with ttl lasts as asked
+    data_shift_time(data, 3600);
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(data->assets, "ups-1"));
+    CHECK(e->maintenance_until_sec == START + 3600 + 600);
+    auto expired = data_maintenance_expire(data, START + 3900);
+    REQUIRE(expired.size() == 1);
+    CHECK(expired[0] == "ups-2");
+    CHECK(data_maintenance_expire(data, START + 4199).empty());
+    CHECK(data_in_maintenance(data, "ups-1"));
+
+    // the step is not an outage
+    availability_report_t reports[AVAILABILITY_WINDOWS];
+    REQUIRE(data_get_availability(data, "ups-1", START + 3960, reports) == 0);
+    CHECK(reports[AVAILABILITY_1H].outage_sec == 60);
+
+    // back by two hours
+    data_shift_time(data, -7200);
+    CHECK(data_maintenance_expire(data, START - 3001).empty());
+    expired = data_maintenance_expire(data, START - 3000);
+    REQUIRE(expired.size() == 1);
+    CHECK(expired[0] == "ups-1");
+    REQUIRE(data_get_availability(data, "ups-1", START - 3210, reports) == 0);
+    CHECK(reports[AVAILABILITY_1H].outage_sec == 90);
+    CHECK(reports[AVAILABILITY_24H].outage_sec == 90);
+
+    data_destroy(&data);
+}
+
+TEST_CASE("data select")
+{
+    data_t* data = data_new();
+    REQUIRE(data);
+
+    struct
+    {
+        const char* name;
+        const char* subtype;
+        const char* parent;
+    } assets[] = {{"ups-1", "ups", "rack-1"}, {"epdu-1", "epdu", "rack-1"}, {"epdu-2", "epdu", "rack-2"}};
+
+    for (const auto& a : assets) {
+        zhash_t* aux = zhash_new();
+        zhash_insert(aux, "type", const_cast<char*>("device"));
+        zhash_insert(aux, "subtype", const_cast<char*>(a.subtype));
+        zhash_insert(aux, ASSET_PARENT_NAME, const_cast<char*>(a.parent));
+        zmsg_t*      asset   = fty_proto_encode_asset(aux, a.name, "create", NULL);
+        fty_proto_t* proto_n = fty_proto_decode(&asset);
+        data_put(data, &proto_n);
+        zhash_destroy(&aux);
+    }
+
+    std::vector<std::string> selected;
+    REQUIRE(data_select(data, "subtype", "epdu", selected) == 0);
+    CHECK(selected.size() == 2);
+
+    selected.clear();
+    REQUIRE(data_select(data, "parent", "rack-1", selected) == 0);
+    CHECK(selected.size() == 2);
+
+    selected.clear();
+    REQUIRE(data_select(data, "name", "epdu-.*", selected) == 0);
+    CHECK(selected.size() == 2);
+
+    selected.clear();
+    REQUIRE(data_select(data, "name", "ups-1", selected) == 0);
+    REQUIRE(selected.size() == 1);
+    CHECK(selected[0] == "ups-1");
+
+    selected.clear();
+    CHECK(data_select(data, "name", "([", selected) == -1);
+    CHECK(data_select(data, "location", "dc", selected) == -1);
+    CHECK(selected.empty());
+
+    data_destroy(&data);
+}
+
+TEST_CASE("data snapshot")
+{
+    data_t* data = data_new();
+    REQUIRE(data);
+    data_set_default_expiry(data, 10);
+
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, "type", const_cast<char*>("device"));
+    zhash_insert(aux, "subtype", const_cast<char*>("ups"));
+    for (const char* name : {"ups-2", "ups-1", "ups-3"}) {
+        zmsg_t*      asset   = fty_proto_encode_asset(aux, name, "create", NULL);
+        fty_proto_t* proto_n = fty_proto_decode(&asset);
+        data_put(data, &proto_n);
+    }
+    zhash_destroy(&aux);
+
+    uint64_t now_sec = uint64_t(zclock_time() / 1000);
+    REQUIRE(data_touch_asset(data, "ups-1", now_sec, 10, now_sec) == 0);
+    REQUIRE(data_maintenance_enable(data, "ups-3", now_sec + 100) == 0);
+
+    asset_status_t status;
+    CHECK(data_get_status(data, "ups-4", now_sec, status) == -1);
+    REQUIRE(data_get_status(data, "ups-1", now_sec, status) == 0);
+    CHECK(status.name == "ups-1");
+    CHECK(status.last_seen_sec == now_sec);
+    CHECK(status.expires_at_sec == now_sec + 20);
+    CHECK(!status.dead);
+
+    auto snapshot = data_snapshot(data, now_sec + 50);
+    REQUIRE(snapshot.size() == 3);
+    CHECK(snapshot[0].name == "ups-1");
+    CHECK(snapshot[1].name == "ups-2");
+    CHECK(snapshot[2].name == "ups-3");
+    CHECK(snapshot[0].dead);
+    CHECK(snapshot[1].dead);
+    CHECK(!snapshot[2].dead);
+    CHECK(snapshot[2].maintenance_until_sec == now_sec + 100);
+
+    data_destroy(&data);
+}
+
+TEST_CASE("data status changes")
+{
+    data_t* data = data_new();
+    REQUIRE(data);
+    data_set_default_expiry(data, 10);
+
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, "type", const_cast<char*>("device"));
+    zhash_insert(aux, "subtype", const_cast<char*>("ups"));
+    for (const char* name : {"ups-1", "ups-2"}) {
+        zmsg_t*      asset   = fty_proto_encode_asset(aux, name, "create", NULL);
+        fty_proto_t* proto_n = fty_proto_decode(&asset);
+        data_put(data, &proto_n);
+    }
+    zhash_destroy(&aux);
+
+    uint64_t now_sec = uint64_t(zclock_time() / 1000);
+
+    // everything is new
+    CHECK(data_status_changes(data, now_sec, 300).size() == 2);
+    CHECK(data_status_changes(data, now_sec + 1, 300).empty());
+
+    // ups-1 is alive, seen more than its ttl after it was published, ups-2 dies
+    REQUIRE(data_touch_asset(data, "ups-1", now_sec + 20, 10, now_sec + 20) == 0);
+    auto changes = data_status_changes(data, now_sec + 30, 300);
+    REQUIRE(changes.size() == 2);
+    for (const auto& status : changes) {
+        CHECK(status.dead == (status.name == "ups-2"));
+        if (status.name == "ups-1")
+            CHECK(status.last_seen_sec == now_sec + 20);
+    }
+    REQUIRE(data_touch_asset(data, "ups-1", now_sec + 35, 10, now_sec + 35) == 0);
+    CHECK(data_status_changes(data, now_sec + 30, 300).empty());
+
+    // ups-2 goes to maintenance
+    REQUIRE(data_maintenance_enable(data, "ups-2", now_sec + 1000) == 0);
+    changes = data_status_changes(data, now_sec + 31, 300);
+    REQUIRE(changes.size() == 1);
+    CHECK(changes[0].maintenance_until_sec == now_sec + 1000);
+
+    // refresh
+    CHECK(data_status_changes(data, now_sec + 300, 300).empty());
+    CHECK(data_status_changes(data, now_sec + 330, 300).size() == 1);
+    CHECK(data_status_changes(data, now_sec + 331, 300).size() == 1);
+
+    data_destroy(&data);
+}
+
+TEST_CASE("data clock skew")
+{
+    data_t* data = data_new();
+    REQUIRE(data);
+
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, "type", const_cast<char*>("device"));
+    zhash_insert(aux, "subtype", const_cast<char*>("ups"));
+    zmsg_t*      asset   = fty_proto_encode_asset(aux, "ups-1", "create", NULL);
+    fty_proto_t* proto_n = fty_proto_decode(&asset);
+    data_put(data, &proto_n);
+    zhash_destroy(&aux);
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(data->assets, "ups-1"));
+    REQUIRE(e);
+
+    // clock of the device is 10 s ahead, its metrics count, but don't keep it alive longer
+    uint64_t now_sec = 1600000000;
+    REQUIRE(data_touch_asset(data, "ups-1", now_sec + 10, 60, now_sec) == 0);
+    CHECK(e->skew_sec == 2);
+    CHECK(e->last_time_seen_sec == now_sec);
+    CHECK(expiration_get(e) == now_sec + 120);
+    for (int i = 0; i < 20; i++) {
+        now_sec += 30;
+        REQUIRE(data_touch_asset(data, "ups-1", now_sec + 10, 60, now_sec) == 0);
+    }
+    CHECK(e->skew_sec == 10);
+    CHECK(e->last_time_seen_sec == now_sec);
+
+    // metric delayed in transport is taken back by the skew
+    REQUIRE(data_touch_asset(data, "ups-1", now_sec + 15, 60, now_sec + 20) == 0);
+    CHECK(e->skew_sec == 8);
+    CHECK(e->last_time_seen_sec == now_sec + 7);
+
+    // too far ahead
+    CHECK(data_touch_asset(data, "ups-1", now_sec + 100, 60, now_sec + 20) == -1);
+    data_set_max_skew(data, 0);
+    CHECK(data_touch_asset(data, "ups-1", now_sec + 21, 60, now_sec + 20) == -1);
+    CHECK(stats_get(data->stats, STATS_METRICS_SKEWED) == 21);
+    CHECK(stats_get(data->stats, STATS_METRICS_FROM_FUTURE) == 2);
+
+    // wall clock stepped forward, then back
+    uint64_t seen_sec   = e->last_time_seen_sec;
+    uint64_t metric_sec = e->last_metric_sec;
+    data_shift_time(data, 3600);
+    CHECK(e->last_time_seen_sec == seen_sec + 3600);
+    CHECK(e->last_metric_sec == metric_sec);
+    data_shift_time(data, -7200);
+    CHECK(e->last_time_seen_sec == seen_sec - 3600);
+    CHECK(e->last_metric_sec == metric_sec - 7200);
+
+    // seen time from the leader agent never moves back, its ttl is taken as is
+    CHECK(data_set_seen(data, "ups-2", now_sec, 60) == -1);
+    REQUIRE(data_set_seen(data, "ups-1", seen_sec, 300) == 0);
+    CHECK(e->last_time_seen_sec == seen_sec);
+    CHECK(e->ttl_sec == 300);
+    REQUIRE(data_set_seen(data, "ups-1", seen_sec - 100, 0) == 0);
+    CHECK(e->last_time_seen_sec == seen_sec);
+    CHECK(e->ttl_sec == 300);
+
+    data_destroy(&data);
+}
@@ -0,0 +1,54 @@
+#include "src/histogram.h"
+#include <catch2/catch.hpp>
+#include <memory>
+
+TEST_CASE("histogram buckets")
+{
+    // values are in buckets not wider than 1/8 of the value
+    for (uint64_t value : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        size_t bucket = histogram_bucket(value);
+        REQUIRE(bucket < HISTOGRAM_BUCKETS);
+        CHECK(value <= histogram_bucket_max(bucket));
+        CHECK(histogram_bucket_max(bucket) - value <= value / HISTOGRAM_SUB_BUCKETS);
+        if (bucket > 0)
+            CHECK(histogram_bucket_max(bucket - 1) < value);
+    }
+    CHECK(histogram_bucket(~0ull) == HISTOGRAM_BUCKETS - 1);
+}
+
+TEST_CASE("histogram summary")
+{
+    std::unique_ptr<histogram_t> histogram(new histogram_t());
+    histogram_reset(histogram.get());
+
+    histogram_summary_t summary = histogram_summary(histogram.get(), false);
+    CHECK(summary.count == 0);
+    CHECK(summary.max == 0);
+
+    for (uint64_t value = 1; value <= 1000; value++)
+        histogram_record(histogram.get(), value);
+    histogram_record(histogram.get(), 5000000);
+
+    summary = histogram_summary(histogram.get(), false);
+    CHECK(summary.count == 1001);
+    CHECK(summary.p50 >= 500);
+    CHECK(summary.p50 <= 500 + 500 / HISTOGRAM_SUB_BUCKETS);
+    CHECK(summary.p99 >= 990);
+    CHECK(summary.p99 <= 990 + 990 / HISTOGRAM_SUB_BUCKETS);
+    CHECK(summary.max == 5000000);
+
+    // reset on read
+    summary = histogram_summary(histogram.get(), true);
+    CHECK(summary.count == 1001);
+    summary = histogram_summary(histogram.get(), false);
+    CHECK(summary.count == 0);
+    CHECK(summary.max == 0);
+
+    {
+        histogram_timer_t timer(histogram.get());
+        zclock_sleep(10);
+    }
+    summary = histogram_summary(histogram.get(), true);
+    CHECK(summary.count == 1);
+    CHECK(summary.max >= 10000);
+}
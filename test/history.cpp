@@ -0,0 +1,117 @@
+#include "src/history.h"
+#include <catch2/catch.hpp>
+
+static const char* HISTORY = "history-test.bin";
+
+TEST_CASE("history query")
+{
+    zsys_file_delete(HISTORY);
+    history_t* history = history_new(HISTORY, 16);
+    REQUIRE(history);
+
+    history_begin(history, "ups-1", 100);
+    CHECK(history_end(history, "ups-1", 160, HISTORY_RECOVERED) == 0);
+    history_begin(history, "epdu-2", 120);
+    history_begin(history, "ups-1", 300);
+    // the outage is already recorded, its start is kept
+    history_begin(history, "ups-1", 310);
+    CHECK(history_end(history, "ups-1", 400, HISTORY_MAINTENANCE) == 0);
+    CHECK(history_end(history, "ups-1", 500, HISTORY_REMOVED) == -1);
+    CHECK(history_end(history, "sts-3", 500, HISTORY_REMOVED) == -1);
+
+    auto outages = history_query(history, "ups-1", 0, INT64_MAX);
+    REQUIRE(outages.size() == 2);
+    CHECK(outages[0].start_sec == 100);
+    CHECK(outages[0].end_sec == 160);
+    CHECK(outages[0].cause == HISTORY_RECOVERED);
+    CHECK(outages[1].start_sec == 300);
+    CHECK(outages[1].end_sec == 400);
+    CHECK(outages[1].cause == HISTORY_MAINTENANCE);
+    CHECK(streq(history_cause_str(outages[1].cause), "maintenance"));
+
+    // outages overlapping the range only
+    CHECK(history_query(history, "ups-1", 200, INT64_MAX).size() == 1);
+    CHECK(history_query(history, "ups-1", 0, 200).size() == 1);
+    CHECK(history_query(history, "ups-1", 170, 290).empty());
+    CHECK(history_query(history, "ups-1", 160, 300).size() == 2);
+    CHECK(history_query(history, "sts-3", 0, INT64_MAX).empty());
+
+    // ongoing outage overlaps everything after its start
+    outages = history_query(history, "epdu-2", 1000, 2000);
+    REQUIRE(outages.size() == 1);
+    CHECK(outages[0].end_sec == 0);
+    CHECK(outages[0].cause == HISTORY_ONGOING);
+
+    // outage can't start before the previous one ended
+    history_begin(history, "ups-1", 350);
+    outages = history_query(history, "ups-1", 0, INT64_MAX);
+    REQUIRE(outages.size() == 3);
+    CHECK(outages[2].start_sec == 400);
+
+    history_destroy(&history);
+    CHECK(history == NULL);
+    zsys_file_delete(HISTORY);
+}
+
+TEST_CASE("history ring")
+{
+    zsys_file_delete(HISTORY);
+    history_t* history = history_new(HISTORY, 4);
+    REQUIRE(history);
+
+    history_begin(history, "epdu-1", 10);
+    history_end(history, "epdu-1", 20, HISTORY_RECOVERED);
+    for (int64_t i = 0; i < 5; i++) {
+        history_begin(history, "ups-1", 100 * (i + 1));
+        history_end(history, "ups-1", 100 * (i + 1) + 50, HISTORY_RECOVERED);
+    }
+    // the oldest outages were overwritten
+    CHECK(history_query(history, "epdu-1", 0, INT64_MAX).empty());
+    auto outages = history_query(history, "ups-1", 0, INT64_MAX);
+    REQUIRE(outages.size() == 4);
+    CHECK(outages[0].start_sec == 200);
+    CHECK(outages[3].start_sec == 500);
+
+    // outage of the asset is recorded again once its records are gone
+    history_begin(history, "epdu-1", 600);
+    CHECK(history_query(history, "epdu-1", 0, INT64_MAX).size() == 1);
+    CHECK(history_query(history, "ups-1", 0, INT64_MAX).size() == 3);
+
+    history_destroy(&history);
+    zsys_file_delete(HISTORY);
+}
+
+TEST_CASE("history persistence")
+{
+    zsys_file_delete(HISTORY);
+    history_t* history = history_new(HISTORY, 8);
+    REQUIRE(history);
+    history_begin(history, "ups-1", 100);
+    history_end(history, "ups-1", 200, HISTORY_RECOVERED);
+    history_begin(history, "ups-1", 300);
+    history_begin(history, "epdu-2", 400);
+    history_destroy(&history);
+
+    // the index is rebuilt from the file, ongoing outage can be ended
+    history = history_new(HISTORY, 8);
+    REQUIRE(history);
+    CHECK(history_end(history, "ups-1", 350, HISTORY_REMOVED) == 0);
+    auto outages = history_query(history, "ups-1", 0, INT64_MAX);
+    REQUIRE(outages.size() == 2);
+    CHECK(outages[0].end_sec == 200);
+    CHECK(outages[1].end_sec == 350);
+    CHECK(outages[1].cause == HISTORY_REMOVED);
+    CHECK(history_query(history, "epdu-2", 0, INT64_MAX).size() == 1);
+    history_destroy(&history);
+
+    // other capacity starts the history again
+    history = history_new(HISTORY, 16);
+    REQUIRE(history);
+    CHECK(history_query(history, "ups-1", 0, INT64_MAX).empty());
+    CHECK(history_query(history, "epdu-2", 0, INT64_MAX).empty());
+    history_destroy(&history);
+
+    // file which can't be opened
+    CHECK(history_new("no-such-dir/history.bin", 8) == NULL);
+    zsys_file_delete(HISTORY);
+}
@@ -0,0 +1,58 @@
+#include "src/data.h"
+#include <catch2/catch.hpp>
+
+static int s_logged     = 0;
+static int s_suppressed = 0;
+
+// logger counting the messages instead of logging them
+template <typename... Args>
+static void s_count_log(const char* format, Args&&...)
+{
+    if (strstr(format, "suppressed"))
+        s_suppressed++;
+    s_logged++;
+}
+
+static void s_log_site(int i)
+{
+    logLimited(s_count_log, "event {}", i);
+}
+
+TEST_CASE("hotlog rate limit")
+{
+    for (int i = 0; i < 100; i++)
+        s_log_site(i);
+    CHECK(s_logged == HOTLOG_BURST);
+    CHECK(s_suppressed == 0);
+
+    hotlog_limit_t limit;
+    uint32_t       suppressed = 0;
+    limit.period_start_ms.store(zclock_mono());
+    for (int i = 0; i < HOTLOG_BURST; i++)
+        CHECK(hotlog_allow(limit, suppressed));
+    CHECK(!hotlog_allow(limit, suppressed));
+    CHECK(!hotlog_allow(limit, suppressed));
+
+    // next period reports the dropped messages
+    limit.period_start_ms.store(zclock_mono() - HOTLOG_PERIOD_MS);
+    CHECK(hotlog_allow(limit, suppressed));
+    CHECK(suppressed == 2);
+    CHECK(hotlog_allow(limit, suppressed));
+    CHECK(suppressed == 0);
+}
+
+TEST_CASE("hotlog debug asset")
+{
+    data_t* data = data_new();
+    CHECK(!data_debug_asset(data, "ups-1"));
+
+    data_set_debug_asset(data, "ups-1", true);
+    data_set_debug_asset(data, "ups-1", true);
+    CHECK(data_debug_asset(data, "ups-1"));
+    CHECK(!data_debug_asset(data, "ups-2"));
+
+    data_set_debug_asset(data, "ups-1", false);
+    data_set_debug_asset(data, "ups-2", false);
+    CHECK(!data_debug_asset(data, "ups-1"));
+    data_destroy(&data);
+}
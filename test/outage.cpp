@@ -3,8 +3,40 @@
 #include <fty_shm.h>
 #include "src/fty-outage-server.h"
 #include "src/data.h"
+#include "src/fty-outage.h"
 #include "src/osrv.h"
 
+// send mailbox request to agent 'address', returns the reply without correlation ID and REPLY frames
+static zmsg_t* s_request(mlm_client_t* client, const char* zuuid_str, std::initializer_list<const char*> frames,
+    const char* address = "fty-outage")
+{
+    zmsg_t* request = zmsg_new();
+    zmsg_addstr(request, "REQUEST");
+    zmsg_addstr(request, zuuid_str);
+    for (const char* frame : frames)
+        zmsg_addstr(request, frame);
+    int rv = mlm_client_sendto(client, address, "TEST", NULL, 1000, &request);
+    REQUIRE(rv >= 0);
+
+    zmsg_t* reply = mlm_client_recv(client);
+    REQUIRE(reply);
+    char* answer = zmsg_popstr(reply);
+    CHECK(streq(zuuid_str, answer));
+    zstr_free(&answer);
+    answer = zmsg_popstr(reply);
+    CHECK(streq("REPLY", answer));
+    zstr_free(&answer);
+    return reply;
+}
+
+static void s_check_frame(zmsg_t* reply, const char* expected)
+{
+    char* answer = zmsg_popstr(reply);
+    REQUIRE(answer);
+    CHECK(streq(expected, answer));
+    zstr_free(&answer);
+}
+
 TEST_CASE("outage server test")
 {
     static const char* endpoint = "inproc://malamute-test2";
@@ -37,6 +69,8 @@ TEST_CASE("outage server test")
     zstr_sendx(self, "TIMEOUT", "1000", NULL);
     zstr_sendx(self, "ASSET-EXPIRY-SEC", "3", NULL);
     zstr_sendx(server, "DEFAULT_MAINTENANCE_EXPIRATION", "30", NULL);
+    zsys_file_delete("outage-trace.log");
+    zstr_sendx(self, "TRACE-FILE", "outage-trace.log", NULL);
 
     mlm_client_t* mb_client = mlm_client_new();
     mlm_client_connect(mb_client, endpoint, 1000, "fty_outage_client");
@@ -189,6 +223,115 @@ TEST_CASE("outage server test")
     CHECK(streq(fty_proto_name(bmsg), "UPS-42"));
     CHECK(streq(fty_proto_state(bmsg), "ACTIVE"));
     fty_proto_destroy(&bmsg);
+
+    // bulk request: asset is not in maintenance anymore, so no alert is expected
+    // * REQUEST/'msg-correlation-id'/MAINTENANCE_MODE_SELECT/<mode>/<selector>/<value>
+    request = zmsg_new();
+    zmsg_addstr(request, "REQUEST");
+    zmsg_addstr(request, zuuid_str);
+    zmsg_addstr(request, "MAINTENANCE_MODE_SELECT");
+    zmsg_addstr(request, "disable");
+    zmsg_addstr(request, "name");
+    zmsg_addstr(request, "UPS-4.*");
+    rv = mlm_client_sendto(mb_client, "fty-outage", "TEST", NULL, 1000, &request);
+    REQUIRE(rv >= 0);
+
+    recv = mlm_client_recv(mb_client);
+    REQUIRE(recv);
+    answer = zmsg_popstr(recv);
+    CHECK(streq(zuuid_str, answer));
+    zstr_free(&answer);
+    answer = zmsg_popstr(recv);
+    CHECK(streq("REPLY", answer));
+    zstr_free(&answer);
+    answer = zmsg_popstr(recv);
+    CHECK(streq("OK", answer));
+    zstr_free(&answer);
+    answer = zmsg_popstr(recv);
+    CHECK(streq("1", answer));
+    zstr_free(&answer);
+    answer = zmsg_popstr(recv);
+    CHECK(streq("UPS-42", answer));
+    zstr_free(&answer);
+    s_check_frame(recv, "OK");
+    zmsg_destroy(&recv);
+
+    recv = s_request(mb_client, zuuid_str, {"MAINTENANCE_MODE_SELECT", "enable", "name", "UPS-4.*", "ttl=x"});
+    s_check_frame(recv, "ERROR");
+    s_check_frame(recv, "Invalid expiration");
+    zmsg_destroy(&recv);
+
+    // query API: UPS-42 is the only known asset and it is dead
+    recv = s_request(mb_client, zuuid_str, {"STATUS", "UPS-42"});
+    s_check_frame(recv, "OK");
+    s_check_frame(recv, "UPS-42");
+    s_check_frame(recv, "dead");
+    s_check_frame(recv, "ACTIVE");
+    s_check_frame(recv, "0");
+    zmsg_destroy(&recv);
+
+    // status is published into shm by the dead check
+    fty::shm::shmMetrics status;
+    fty::shm::read_metrics("UPS-42", "outage\\.communicating", status);
+    REQUIRE(status.size() == 1);
+    for (auto& metric : status)
+        CHECK(streq(fty_proto_value(metric), "0"));
+
+    recv = s_request(mb_client, zuuid_str, {"STATUS", "UPS-43"});
+    s_check_frame(recv, "ERROR");
+    s_check_frame(recv, "Unknown asset");
+    zmsg_destroy(&recv);
+
+    // debug logging of selected assets
+    recv = s_request(mb_client, zuuid_str, {"DEBUG_ASSET", "enable", "UPS-42", "UPS-43"});
+    s_check_frame(recv, "OK");
+    zmsg_destroy(&recv);
+    recv = s_request(mb_client, zuuid_str, {"DEBUG_ASSET", "disable", "UPS-43"});
+    s_check_frame(recv, "OK");
+    zmsg_destroy(&recv);
+    recv = s_request(mb_client, zuuid_str, {"DEBUG_ASSET", "verbose", "UPS-42"});
+    s_check_frame(recv, "ERROR");
+    s_check_frame(recv, "Unsupported debug mode");
+    zmsg_destroy(&recv);
+
+    recv = s_request(mb_client, zuuid_str, {"COUNT"});
+    s_check_frame(recv, "OK");
+    s_check_frame(recv, "tracked");
+    s_check_frame(recv, "1");
+    s_check_frame(recv, "dead");
+    s_check_frame(recv, "1");
+    zmsg_destroy(&recv);
+
+    recv = s_request(mb_client, zuuid_str, {"LIST", "DEAD", "0", "0", "10"});
+    s_check_frame(recv, "OK");
+    answer = zmsg_popstr(recv);
+    REQUIRE(answer);
+    std::string snapshot = answer;
+    zstr_free(&answer);
+    s_check_frame(recv, "1"); // total
+    s_check_frame(recv, "");  // last page
+    s_check_frame(recv, "UPS-42");
+    zmsg_destroy(&recv);
+
+    recv = s_request(mb_client, zuuid_str, {"LIST", "MAINTENANCE", snapshot.c_str()});
+    s_check_frame(recv, "OK");
+    s_check_frame(recv, snapshot.c_str());
+    s_check_frame(recv, "0");
+    s_check_frame(recv, "");
+    CHECK(zmsg_size(recv) == 0);
+    zmsg_destroy(&recv);
+
+    recv = s_request(mb_client, zuuid_str, {"STATS"});
+    s_check_frame(recv, "OK");
+    s_check_frame(recv, "uptime_sec");
+    CHECK(zmsg_size(recv) % 2 == 1);
+    zmsg_destroy(&recv);
+
+    recv = s_request(mb_client, zuuid_str, {"LATENCY", "RESET"});
+    s_check_frame(recv, "OK");
+    s_check_frame(recv, "stream_message");
+    CHECK(zmsg_size(recv) % 5 == 4);
+    zmsg_destroy(&recv);
     zuuid_destroy(&zuuid);
 
     // test case 05: RESOLVE alert when device is retired
@@ -209,6 +352,19 @@ TEST_CASE("outage server test")
     CHECK(streq(fty_proto_state(bmsg), "RESOLVED"));
     fty_proto_destroy(&bmsg);
     zactor_destroy(&self);
+
+    // detection latencies of UPS33 alerts were traced
+    zfile_t* trace = zfile_new(NULL, "outage-trace.log");
+    REQUIRE(zfile_input(trace) == 0);
+    bool traced_active = false, traced_resolved = false;
+    for (const char* line = zfile_readln(trace); line != NULL; line = zfile_readln(trace)) {
+        traced_active |= strstr(line, " ACTIVE UPS33 ") != NULL;
+        traced_resolved |= strstr(line, " RESOLVED UPS33 ") != NULL;
+    }
+    CHECK(traced_active);
+    CHECK(traced_resolved);
+    zfile_destroy(&trace);
+    zsys_file_delete("outage-trace.log");
     //    mlm_client_destroy (&m_sender);
     fty_shm_delete_test_dir();
     mlm_client_destroy(&a_sender);
@@ -220,6 +376,17 @@ TEST_CASE("outage server test")
 
     // Those are PRIVATE to actor, so won't be a part of documentation
     s_osrv_t* self2 = s_osrv_new();
+    // without configuration file, the settings are the defaults of the file
+    CHECK(self2->default_maintenance_expiration == uint64_t(atoll(DEFAULT_MAINTENANCE_EXPIRATION)));
+    CHECK(self2->timeout_ms == uint64_t(atoll(DEFAULT_CHECK_INTERVAL)) * 1000);
+    CHECK(self2->stats_interval_ms == uint64_t(atoll(DEFAULT_STATS_INTERVAL)) * 1000);
+    CHECK(self2->lag_threshold_ms == uint64_t(atoll(DEFAULT_LAG_THRESHOLD)));
+    CHECK(self2->assets->flap_half_life_sec == uint32_t(atol(DEFAULT_FLAP_HALF_LIFE)));
+    CHECK(self2->assets->flap_suppress == uint32_t(atol(DEFAULT_FLAP_SUPPRESS)));
+    CHECK(self2->assets->flap_reuse == uint32_t(atol(DEFAULT_FLAP_REUSE)));
+    CHECK(self2->assets->max_skew_sec == uint32_t(atol(DEFAULT_MAX_CLOCK_SKEW)));
+    CHECK(self2->wave->min_assets == uint32_t(atol(DEFAULT_WAVE_ASSETS)));
+    CHECK(self2->wave->hold_sec == uint64_t(atoll(DEFAULT_WAVE_HOLD)));
     zhash_insert(self2->active_alerts, "DEVICE1", TRUE);
     zhash_insert(self2->active_alerts, "DEVICE2", TRUE);
     zhash_insert(self2->active_alerts, "DEVICE3", TRUE);
@@ -243,3 +410,411 @@ TEST_CASE("outage server test")
 
     unlink("state.zpl");
 }
+
+// receive alert of 'asset' in 'state' within 'timeout_ms'
+static bool s_recv_alert(mlm_client_t* consumer, const char* asset, const char* state, int timeout_ms)
+{
+    zpoller_t* poller = zpoller_new(mlm_client_msgpipe(consumer), NULL);
+    bool       found  = false;
+    if (zpoller_wait(poller, timeout_ms)) {
+        zmsg_t*      msg   = mlm_client_recv(consumer);
+        fty_proto_t* alert = fty_proto_decode(&msg);
+        found              = alert && streq(fty_proto_name(alert), asset) && streq(fty_proto_state(alert), state);
+        fty_proto_destroy(&alert);
+    }
+    zpoller_destroy(&poller);
+    return found;
+}
+
+TEST_CASE("outage server simulated clock")
+{
+    static const char* endpoint = "inproc://malamute-test-clock";
+
+    zactor_t* server = zactor_new(mlm_server, const_cast<char*>("Malamute"));
+    zstr_sendx(server, "BIND", endpoint, NULL);
+    CHECK(fty_shm_set_test_dir(".") == 0);
+
+    int64_t  start_ms  = zclock_time();
+    uint64_t start_sec = uint64_t(start_ms / 1000);
+
+    zactor_t* self = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    REQUIRE(self);
+    zstr_sendx(self, "CLOCK", "SIMULATED", std::to_string(start_ms).c_str(), NULL);
+    zstr_sendx(self, "CONNECT", endpoint, "fty-outage", NULL);
+    zstr_sendx(self, "CONSUMER", "METRICS", ".*", NULL);
+    zstr_sendx(self, "CONSUMER", "ASSETS", ".*", NULL);
+    zstr_sendx(self, "PRODUCER", "_ALERTS_SYS", NULL);
+    zstr_sendx(self, "ASSET-EXPIRY-SEC", "900", NULL);
+    zstr_sendx(self, "SHM-STATUS", "0", NULL);
+    zsys_file_delete("history-clock-test.bin");
+    zstr_sendx(self, "HISTORY-FILE", "history-clock-test.bin", "16", NULL);
+
+    mlm_client_t* mb_client = mlm_client_new();
+    mlm_client_connect(mb_client, endpoint, 1000, "fty_outage_client");
+    mlm_client_t* sender = mlm_client_new();
+    mlm_client_connect(sender, endpoint, 1000, "sender");
+    mlm_client_t* consumer = mlm_client_new();
+    mlm_client_connect(consumer, endpoint, 1000, "alert-consumer");
+    mlm_client_set_consumer(consumer, "_ALERTS_SYS", ".*");
+    zclock_sleep(500);
+
+    // asset with 15 minutes TTL, expires after 30 minutes
+    mlm_client_set_producer(sender, "ASSETS");
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, FTY_PROTO_ASSET_TYPE, const_cast<char*>("device"));
+    zhash_insert(aux, FTY_PROTO_ASSET_SUBTYPE, const_cast<char*>("ups"));
+    zmsg_t* msg = fty_proto_encode_asset(aux, "UPS-SIM", FTY_PROTO_ASSET_OP_CREATE, NULL);
+    zhash_destroy(&aux);
+    REQUIRE(mlm_client_send(sender, "UPS-SIM", &msg) == 0);
+
+    mlm_client_set_producer(sender, "METRICS");
+    msg = fty_proto_encode_metric(NULL, start_sec, 900, "status.ups", "UPS-SIM", "1", "");
+    REQUIRE(mlm_client_send(sender, "status.ups@UPS-SIM", &msg) == 0);
+
+    // wait for the metric, clock doesn't move meanwhile
+    std::string last_seen;
+    for (int i = 0; i < 50 && last_seen != std::to_string(start_sec); i++) {
+        zmsg_t* recv = s_request(mb_client, "1234", {"STATUS", "UPS-SIM"});
+        char*   ok   = zmsg_popstr(recv);
+        if (streq(ok, "OK")) {
+            for (int frame = 0; frame < 4; frame++)
+                zstr_free(&ok), ok = zmsg_popstr(recv);
+            last_seen = ok;
+        }
+        zstr_free(&ok);
+        zmsg_destroy(&recv);
+        zclock_sleep(20);
+    }
+    REQUIRE(last_seen == std::to_string(start_sec));
+
+    // long outage takes milliseconds
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(29 * 60 * 1000).c_str(), NULL);
+    CHECK(!s_recv_alert(consumer, "UPS-SIM", "ACTIVE", 200));
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(2 * 60 * 1000).c_str(), NULL);
+    CHECK(s_recv_alert(consumer, "UPS-SIM", "ACTIVE", 1000));
+
+    // maintenance expires after 10 minutes and the asset is still dead
+    zmsg_t* recv = s_request(mb_client, "1234", {"MAINTENANCE_MODE", "enable", "UPS-SIM", "600"});
+    s_check_frame(recv, "OK");
+    zmsg_destroy(&recv);
+    CHECK(s_recv_alert(consumer, "UPS-SIM", "RESOLVED", 1000));
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(9 * 60 * 1000).c_str(), NULL);
+    CHECK(!s_recv_alert(consumer, "UPS-SIM", "ACTIVE", 200));
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(2 * 60 * 1000).c_str(), NULL);
+    CHECK(s_recv_alert(consumer, "UPS-SIM", "ACTIVE", 1000));
+
+    // stream metrics don't keep assets alive, when only fty_shm is the liveness source
+    uint64_t now_sec = start_sec + 42 * 60;
+    zstr_sendx(self, "LIVENESS-SOURCE", "shm", NULL);
+    msg = fty_proto_encode_metric(NULL, now_sec, 900, "status.ups", "UPS-SIM", "1", "");
+    REQUIRE(mlm_client_send(sender, "status.ups@UPS-SIM", &msg) == 0);
+    CHECK(!s_recv_alert(consumer, "UPS-SIM", "RESOLVED", 500));
+    zstr_sendx(self, "LIVENESS-SOURCE", "hybrid", NULL);
+    msg = fty_proto_encode_metric(NULL, now_sec, 900, "status.ups", "UPS-SIM", "1", "");
+    REQUIRE(mlm_client_send(sender, "status.ups@UPS-SIM", &msg) == 0);
+    CHECK(s_recv_alert(consumer, "UPS-SIM", "RESOLVED", 1000));
+
+    // the same heartbeat again is a duplicate
+    msg = fty_proto_encode_metric(NULL, now_sec, 900, "status.ups", "UPS-SIM", "1", "");
+    REQUIRE(mlm_client_send(sender, "status.ups@UPS-SIM", &msg) == 0);
+    bool duplicate = false;
+    for (int i = 0; i < 50 && !duplicate; i++) {
+        zmsg_t* recv = s_request(mb_client, "1234", {"STATS"});
+        for (char* frame = zmsg_popstr(recv); frame != NULL; frame = zmsg_popstr(recv)) {
+            if (streq(frame, "duplicates")) {
+                char* value = zmsg_popstr(recv);
+                duplicate   = value && streq(value, "1");
+                zstr_free(&value);
+            }
+            zstr_free(&frame);
+        }
+        zmsg_destroy(&recv);
+        zclock_sleep(20);
+    }
+    CHECK(duplicate);
+
+    // both outages are in the history, the second one starts when the maintenance ended
+    std::vector<std::string> expected = {"OK", std::to_string(start_sec + 30 * 60), std::to_string(start_sec + 31 * 60),
+        "maintenance", std::to_string(start_sec + 41 * 60), std::to_string(now_sec), "recovered"};
+    recv = s_request(mb_client, "1234", {"HISTORY", "UPS-SIM"});
+    for (const auto& frame : expected)
+        s_check_frame(recv, frame.c_str());
+    CHECK(zmsg_size(recv) == 0);
+    zmsg_destroy(&recv);
+    recv = s_request(mb_client, "1234", {"HISTORY", "UPS-SIM", std::to_string(start_sec + 32 * 60).c_str()});
+    s_check_frame(recv, "OK");
+    s_check_frame(recv, std::to_string(start_sec + 41 * 60).c_str());
+    CHECK(zmsg_size(recv) == 2);
+    zmsg_destroy(&recv);
+
+    // 2 minutes of outage in the 42 minutes the asset is tracked, maintenance is not an outage
+    recv = s_request(mb_client, "1234", {"AVAILABILITY", "UPS-SIM"});
+    for (const char* frame : {"OK", "UPS-SIM", "1h", "95.238", "120", "2520", "24h", "95.238"})
+        s_check_frame(recv, frame);
+    zmsg_destroy(&recv);
+
+    // NTP steps the wall clock 2 hours forward, that is not an outage, nor the end of a 10 minutes maintenance
+    recv = s_request(mb_client, "1234", {"MAINTENANCE_MODE", "enable", "UPS-SIM", "600"});
+    s_check_frame(recv, "OK");
+    zmsg_destroy(&recv);
+    zstr_sendx(self, "CLOCK-STEP", std::to_string(2 * 60 * 60 * 1000).c_str(), NULL);
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(60 * 1000).c_str(), NULL);
+    CHECK(!s_recv_alert(consumer, "UPS-SIM", "ACTIVE", 500));
+    recv = s_request(mb_client, "1234", {"STATUS", "UPS-SIM"});
+    for (const char* frame : {"OK", "UPS-SIM", "maintenance"})
+        s_check_frame(recv, frame);
+    for (int frame = 0; frame < 4; frame++) {
+        char* skipped = zmsg_popstr(recv);
+        zstr_free(&skipped);
+    }
+    s_check_frame(recv, std::to_string(now_sec + 2 * 60 * 60 + 600).c_str());
+    zmsg_destroy(&recv);
+
+    // the maintenance ends 10 minutes after it was enabled, the step is not counted
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(9 * 60 * 1000).c_str(), NULL);
+    CHECK(!s_recv_alert(consumer, "UPS-SIM", "ACTIVE", 500));
+    recv = s_request(mb_client, "1234", {"STATUS", "UPS-SIM"});
+    for (const char* frame : {"OK", "UPS-SIM", "alive"})
+        s_check_frame(recv, frame);
+    zmsg_destroy(&recv);
+
+    zactor_destroy(&self);
+    zsys_file_delete("history-clock-test.bin");
+    mlm_client_destroy(&consumer);
+    mlm_client_destroy(&sender);
+    mlm_client_destroy(&mb_client);
+    zactor_destroy(&server);
+}
+
+TEST_CASE("outage server replay")
+{
+    static const char* endpoint = "inproc://malamute-test-replay";
+    static const char* trace    = "outage-replay.bin";
+
+    // asset announced with metric, then half an hour of silence interrupted by other asset only
+    int64_t    start_ms = zclock_time();
+    capture_t* capture  = capture_new();
+    REQUIRE(capture_start(capture, trace) == 0);
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, FTY_PROTO_ASSET_TYPE, const_cast<char*>("device"));
+    zhash_insert(aux, FTY_PROTO_ASSET_SUBTYPE, const_cast<char*>("ups"));
+    zmsg_t* msg = fty_proto_encode_asset(aux, "UPS-REPLAY", FTY_PROTO_ASSET_OP_CREATE, NULL);
+    zhash_destroy(&aux);
+    capture_message(capture, start_ms, "STREAM DELIVER", FTY_PROTO_STREAM_ASSETS, "asset-agent", "UPS-REPLAY", msg);
+    zmsg_destroy(&msg);
+    msg = fty_proto_encode_metric(NULL, uint64_t(start_ms / 1000), 900, "status.ups", "UPS-REPLAY", "1", "");
+    capture_message(
+        capture, start_ms + 10, "STREAM DELIVER", FTY_PROTO_STREAM_METRICS, "nut", "status.ups@UPS-REPLAY", msg);
+    zmsg_destroy(&msg);
+    int64_t later_ms = start_ms + 31 * 60 * 1000;
+    msg = fty_proto_encode_metric(NULL, uint64_t(later_ms / 1000), 900, "status.ups", "UPS-OTHER", "1", "");
+    capture_message(capture, later_ms, "STREAM DELIVER", FTY_PROTO_STREAM_METRICS, "nut", "status.ups@UPS-OTHER", msg);
+    zmsg_destroy(&msg);
+    // malformed topic is ignored, the valid one stops tracking of the asset
+    const char* topics[] = {"garbage", "status.ups@UPS-REPLAY"};
+    for (const char* topic : topics) {
+        msg = zmsg_new();
+        zmsg_addstr(msg, "METRICUNAVAILABLE");
+        zmsg_addstr(msg, topic);
+        capture_message(
+            capture, later_ms + 10, "STREAM DELIVER", FTY_PROTO_STREAM_METRICS_UNAVAILABLE, "nut", topic, msg);
+        zmsg_destroy(&msg);
+    }
+    capture_destroy(&capture);
+
+    zactor_t* server = zactor_new(mlm_server, const_cast<char*>("Malamute"));
+    zstr_sendx(server, "BIND", endpoint, NULL);
+    CHECK(fty_shm_set_test_dir(".") == 0);
+
+    zactor_t* self = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    REQUIRE(self);
+    zstr_sendx(self, "CONNECT", endpoint, "fty-outage", NULL);
+    zstr_sendx(self, "PRODUCER", "_ALERTS_SYS", NULL);
+    zstr_sendx(self, "STATS-INTERVAL", "0", NULL);
+    zstr_sendx(self, "SHM-STATUS", "0", NULL);
+
+    mlm_client_t* consumer = mlm_client_new();
+    mlm_client_connect(consumer, endpoint, 1000, "alert-consumer");
+    mlm_client_set_consumer(consumer, "_ALERTS_SYS", ".*");
+    zclock_sleep(500);
+
+    // replayed as fast as possible, the outage is detected when the time of the last record is reached
+    zstr_sendx(self, "REPLAY", trace, "0", NULL);
+    char* records = zstr_recv(self);
+    CHECK(streq(records, "5"));
+    zstr_free(&records);
+    CHECK(s_recv_alert(consumer, "UPS-REPLAY", "ACTIVE", 1000));
+    CHECK(s_recv_alert(consumer, "UPS-REPLAY", "RESOLVED", 1000));
+
+    zstr_sendx(self, "REPLAY", "outage-missing.bin", NULL);
+    records = zstr_recv(self);
+    CHECK(streq(records, "-1"));
+    zstr_free(&records);
+
+    zactor_destroy(&self);
+    mlm_client_destroy(&consumer);
+    zactor_destroy(&server);
+    zsys_file_delete(trace);
+}
+
+// ask for STATUS of 'asset' until the reply is 'expected' (OK if it is tracked, ERROR if not)
+static bool s_wait_status(
+    mlm_client_t* client, const char* asset, const char* expected, const char* address = "fty-outage")
+{
+    bool found = false;
+    for (int i = 0; i < 50 && !found; i++) {
+        zmsg_t* recv  = s_request(client, "1234", {"STATUS", asset}, address);
+        char*   state = zmsg_popstr(recv);
+        found         = state && streq(state, expected);
+        zstr_free(&state);
+        zmsg_destroy(&recv);
+        if (!found)
+            zclock_sleep(20);
+    }
+    return found;
+}
+
+static void s_send_asset(mlm_client_t* sender, const char* asset)
+{
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, FTY_PROTO_ASSET_TYPE, const_cast<char*>("device"));
+    zhash_insert(aux, FTY_PROTO_ASSET_SUBTYPE, const_cast<char*>("ups"));
+    zmsg_t* msg = fty_proto_encode_asset(aux, asset, FTY_PROTO_ASSET_OP_CREATE, NULL);
+    zhash_destroy(&aux);
+    REQUIRE(mlm_client_send(sender, asset, &msg) == 0);
+}
+
+TEST_CASE("outage server reload")
+{
+    static const char* endpoint = "inproc://malamute-test-reload";
+    static const char* config   = "outage-reload.cfg";
+
+    zactor_t* server = zactor_new(mlm_server, const_cast<char*>("Malamute"));
+    zstr_sendx(server, "BIND", endpoint, NULL);
+    CHECK(fty_shm_set_test_dir(".") == 0);
+
+    zactor_t* self = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    REQUIRE(self);
+    zstr_sendx(self, "CLOCK", "SIMULATED", NULL);
+    zstr_sendx(self, "CONNECT", endpoint, "fty-outage", NULL);
+    zstr_sendx(self, "CONSUMER", "ASSETS", ".*", NULL);
+    zstr_sendx(self, "PRODUCER", "_ALERTS_SYS", NULL);
+    zstr_sendx(self, "SHM-STATUS", "0", NULL);
+
+    mlm_client_t* mb_client = mlm_client_new();
+    mlm_client_connect(mb_client, endpoint, 1000, "fty_outage_client");
+    mlm_client_t* sender = mlm_client_new();
+    mlm_client_connect(sender, endpoint, 1000, "sender");
+    mlm_client_set_producer(sender, "ASSETS");
+    mlm_client_t* consumer = mlm_client_new();
+    mlm_client_connect(consumer, endpoint, 1000, "alert-consumer");
+    mlm_client_set_consumer(consumer, "_ALERTS_SYS", ".*");
+    zclock_sleep(500);
+
+    // UPS-DROP expires 15 minutes after it was added, UPS-KEEP is added 10 minutes later
+    s_send_asset(sender, "UPS-DROP");
+    REQUIRE(s_wait_status(mb_client, "UPS-DROP", "OK"));
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(10 * 60 * 1000).c_str(), NULL);
+    s_send_asset(sender, "UPS-KEEP");
+    REQUIRE(s_wait_status(mb_client, "UPS-KEEP", "OK"));
+    zstr_sendx(self, "CLOCK-ADVANCE", std::to_string(6 * 60 * 1000).c_str(), NULL);
+    CHECK(s_recv_alert(consumer, "UPS-DROP", "ACTIVE", 1000));
+
+    // invalid configuration is not applied at all
+    zconfig_t* root = zconfig_new("root", NULL);
+    zconfig_put(root, "server/liveness_source", "nowhere");
+    zconfig_t* rule = zconfig_new("rule", zconfig_new("policy", root));
+    zconfig_put(rule, "subtype", "ups");
+    zconfig_put(rule, "monitor", "0");
+    REQUIRE(zconfig_save(root, config) == 0);
+    zstr_sendx(self, "RELOAD", config, NULL);
+    zclock_sleep(200);
+    CHECK(s_wait_status(mb_client, "UPS-KEEP", "OK"));
+
+    // assets no longer monitored are dropped, their alerts resolved, the others are kept
+    zconfig_put(root, "server/liveness_source", "hybrid");
+    zconfig_put(rule, "name", "^UPS-DROP$");
+    REQUIRE(zconfig_save(root, config) == 0);
+    zconfig_destroy(&root);
+    zstr_sendx(self, "RELOAD", config, NULL);
+    CHECK(s_recv_alert(consumer, "UPS-DROP", "RESOLVED", 1000));
+    CHECK(s_wait_status(mb_client, "UPS-DROP", "ERROR"));
+    CHECK(s_wait_status(mb_client, "UPS-KEEP", "OK"));
+
+    zactor_destroy(&self);
+    zsys_file_delete(config);
+    mlm_client_destroy(&consumer);
+    mlm_client_destroy(&sender);
+    mlm_client_destroy(&mb_client);
+    zactor_destroy(&server);
+}
+
+// ask agent 'address' for STATS until statistic 'name' is 'expected'
+static bool s_wait_stat(mlm_client_t* client, const char* address, const char* name, const char* expected)
+{
+    bool found = false;
+    for (int i = 0; i < 100 && !found; i++) {
+        zmsg_t* recv = s_request(client, "1234", {"STATS"}, address);
+        for (char* frame = zmsg_popstr(recv); frame != NULL; frame = zmsg_popstr(recv)) {
+            if (streq(frame, name)) {
+                char* value = zmsg_popstr(recv);
+                found       = value && streq(value, expected);
+                zstr_free(&value);
+            }
+            zstr_free(&frame);
+        }
+        zmsg_destroy(&recv);
+        if (!found)
+            zclock_sleep(20);
+    }
+    return found;
+}
+
+TEST_CASE("outage server replication")
+{
+    static const char* endpoint = "inproc://malamute-test-replica";
+    static const char* replica  = "ipc://@/fty-outage-replica-test";
+
+    zactor_t* server = zactor_new(mlm_server, const_cast<char*>("Malamute"));
+    zstr_sendx(server, "BIND", endpoint, NULL);
+    CHECK(fty_shm_set_test_dir(".") == 0);
+
+    zactor_t* leader = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    REQUIRE(leader);
+    zstr_sendx(leader, "CONNECT", endpoint, "fty-outage", NULL);
+    zstr_sendx(leader, "CONSUMER", "ASSETS", ".*", NULL);
+    zstr_sendx(leader, "SHM-STATUS", "0", NULL);
+    zstr_sendx(leader, "REPLICA", "leader", replica, "500", NULL);
+
+    mlm_client_t* mb_client = mlm_client_new();
+    mlm_client_connect(mb_client, endpoint, 1000, "fty_outage_client");
+    mlm_client_t* sender = mlm_client_new();
+    mlm_client_connect(sender, endpoint, 1000, "sender");
+    mlm_client_set_producer(sender, "ASSETS");
+    zclock_sleep(500);
+
+    // standby started later gets the whole state, it doesn't consume the assets itself
+    s_send_asset(sender, "UPS-OLD");
+    REQUIRE(s_wait_status(mb_client, "UPS-OLD", "OK"));
+    zactor_t* standby = zactor_new(fty_outage_server, const_cast<char*>("outage"));
+    REQUIRE(standby);
+    zstr_sendx(standby, "CONNECT", endpoint, "fty-outage-standby", NULL);
+    zstr_sendx(standby, "SHM-STATUS", "0", NULL);
+    zstr_sendx(standby, "REPLICA", "standby", replica, "500", NULL);
+    CHECK(s_wait_status(mb_client, "UPS-OLD", "OK", "fty-outage-standby"));
+    CHECK(s_wait_stat(mb_client, "fty-outage-standby", "standby", "1"));
+
+    // then the changes
+    s_send_asset(sender, "UPS-NEW");
+    CHECK(s_wait_status(mb_client, "UPS-NEW", "OK", "fty-outage-standby"));
+
+    // the leader stops, the standby takes over once the lease expires
+    zactor_destroy(&leader);
+    CHECK(s_wait_stat(mb_client, "fty-outage-standby", "standby", "0"));
+    CHECK(s_wait_status(mb_client, "UPS-NEW", "OK", "fty-outage-standby"));
+
+    zactor_destroy(&standby);
+    mlm_client_destroy(&sender);
+    mlm_client_destroy(&mb_client);
+    zactor_destroy(&server);
+}
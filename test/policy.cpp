@@ -0,0 +1,160 @@
+#include "src/data.h"
+#include "src/policy.h"
+#include <catch2/catch.hpp>
+
+static fty_proto_t* s_asset(const char* name, const char* type, const char* subtype, const char* ext_key = NULL,
+    const char* ext_value = NULL)
+{
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, FTY_PROTO_ASSET_TYPE, const_cast<char*>(type));
+    zhash_insert(aux, FTY_PROTO_ASSET_SUBTYPE, const_cast<char*>(subtype));
+    zhash_t* ext = zhash_new();
+    if (ext_key)
+        zhash_insert(ext, ext_key, const_cast<char*>(ext_value));
+    zmsg_t*      msg   = fty_proto_encode_asset(aux, name, FTY_PROTO_ASSET_OP_CREATE, ext);
+    fty_proto_t* proto = fty_proto_decode(&msg);
+    zhash_destroy(&aux);
+    zhash_destroy(&ext);
+    return proto;
+}
+
+static const policy_rule_t* s_match(policy_t* policy, const char* name, const char* type, const char* subtype,
+    const char* ext_key = NULL, const char* ext_value = NULL)
+{
+    fty_proto_t*         asset = s_asset(name, type, subtype, ext_key, ext_value);
+    const policy_rule_t* rule  = policy_match(policy, asset);
+    fty_proto_destroy(&asset);
+    return rule;
+}
+
+TEST_CASE("policy builtin rules")
+{
+    policy_t* policy = policy_new();
+    REQUIRE(policy);
+
+    CHECK(s_match(policy, "ups-1", "device", "ups"));
+    CHECK(s_match(policy, "epdu-1", "device", "epdu"));
+    CHECK(s_match(policy, "sensor-1", "device", "sensor"));
+    CHECK(s_match(policy, "sensorgpio-1", "device", "sensorgpio"));
+    CHECK(s_match(policy, "sts-1", "device", "sts", "device.type", "sts"));
+    CHECK(!s_match(policy, "sts-2", "device", "sts"));
+    CHECK(!s_match(policy, "server-1", "device", "server"));
+    CHECK(!s_match(policy, "ups-2", "group", "ups"));
+
+    const policy_rule_t* rule = s_match(policy, "ups-1", "device", "ups");
+    REQUIRE(rule);
+    CHECK(rule->ttl_sec == 0);
+    CHECK(rule->multiplier == DEFAULT_POLICY_MULTIPLIER);
+
+    policy_destroy(&policy);
+    CHECK(!policy);
+}
+
+TEST_CASE("policy configured rules")
+{
+    zconfig_t* root    = zconfig_new("root", NULL);
+    zconfig_t* section = zconfig_new("policy", root);
+
+    zconfig_t* rule1 = zconfig_new("rule", section);
+    zconfig_put(rule1, "subtype", "ups");
+    zconfig_put(rule1, "name", "^ups-lab-.*");
+    zconfig_put(rule1, "monitor", "0");
+
+    zconfig_t* rule2 = zconfig_new("rule", section);
+    zconfig_put(rule2, "subtype", "pdu");
+    zconfig_put(rule2, "ttl", "300");
+    zconfig_put(rule2, "multiplier", "3");
+    zconfig_put(rule2, "reannounce", "600");
+
+    zconfig_t* rule3 = zconfig_new("rule", section);
+    zconfig_put(rule3, "ext_key", "location");
+    zconfig_put(rule3, "ext_value", "dc-.*");
+    zconfig_put(rule3, "ttl", "60");
+
+    policy_t* policy = policy_new();
+    REQUIRE(policy_load(policy, root) == 0);
+
+    // excluded by name
+    CHECK(!s_match(policy, "ups-lab-1", "device", "ups"));
+    // built-in rule still applies
+    const policy_rule_t* rule = s_match(policy, "ups-1", "device", "ups");
+    REQUIRE(rule);
+    CHECK(rule->ttl_sec == 0);
+
+    // new subtype
+    rule = s_match(policy, "pdu-1", "device", "pdu");
+    REQUIRE(rule);
+    CHECK(rule->ttl_sec == 300);
+    CHECK(rule->multiplier == 3);
+    CHECK(rule->reannounce_sec == 600);
+
+    // any subtype selected by ext attribute
+    rule = s_match(policy, "server-1", "device", "server", "location", "dc-1");
+    REQUIRE(rule);
+    CHECK(rule->ttl_sec == 60);
+    CHECK(!s_match(policy, "server-2", "device", "server", "location", "lab"));
+    rule = s_match(policy, "epdu-1", "device", "epdu", "location", "dc-2");
+    REQUIRE(rule);
+    CHECK(rule->ttl_sec == 60);
+
+    // invalid rule keeps the current policy
+    zconfig_put(rule3, "name", "([");
+    CHECK(policy_load(policy, root) == -1);
+    CHECK(s_match(policy, "pdu-1", "device", "pdu"));
+
+    policy_destroy(&policy);
+    zconfig_destroy(&root);
+}
+
+TEST_CASE("policy of tracked assets")
+{
+    zconfig_t* root = zconfig_new("root", NULL);
+    zconfig_t* rule = zconfig_new("rule", zconfig_new("policy", root));
+    zconfig_put(rule, "subtype", "pdu");
+    zconfig_put(rule, "ttl", "300");
+    policy_t* policy = policy_new();
+    REQUIRE(policy_load(policy, root) == 0);
+
+    data_t* data = data_new();
+    REQUIRE(data);
+    data_set_policy(data, &policy);
+    fty_proto_t* asset = s_asset("pdu-1", "device", "pdu");
+    data_put(data, &asset);
+    expiration_t* e = reinterpret_cast<expiration_t*>(zhashx_lookup(data->assets, "pdu-1"));
+    REQUIRE(e);
+    CHECK(e->ttl_sec == 300);
+
+    // re-announced asset follows the changed rule
+    zconfig_put(rule, "ttl", "120");
+    zconfig_put(rule, "multiplier", "3");
+    policy = policy_new();
+    REQUIRE(policy_load(policy, root) == 0);
+    data_set_policy(data, &policy);
+    asset = s_asset("pdu-1", "device", "pdu");
+    data_put(data, &asset);
+    CHECK(e->ttl_sec == 120);
+    CHECK(e->multiplier == 3);
+
+    // reload applies the rule without the asset being re-announced
+    zconfig_put(rule, "ttl", "60");
+    zconfig_put(rule, "multiplier", "2");
+    policy = policy_new();
+    REQUIRE(policy_load(policy, root) == 0);
+    data_set_policy(data, &policy);
+    CHECK(data_follow_policy(data).empty());
+    CHECK(e->ttl_sec == 60);
+    CHECK(e->multiplier == 2);
+
+    // and is dropped, once it is not monitored
+    zconfig_put(rule, "monitor", "0");
+    policy = policy_new();
+    REQUIRE(policy_load(policy, root) == 0);
+    data_set_policy(data, &policy);
+    asset = s_asset("pdu-1", "device", "pdu");
+    CHECK(!data_monitored(data, asset));
+    data_put(data, &asset);
+    CHECK(zhashx_lookup(data->assets, "pdu-1") == NULL);
+
+    data_destroy(&data);
+    zconfig_destroy(&root);
+}
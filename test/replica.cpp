@@ -0,0 +1,189 @@
+#include "src/replica.h"
+#include "src/vclock.h"
+#include <catch2/catch.hpp>
+
+// receive messages from 'actor' until one starting with 'command' comes, NULL after 'timeout_ms'
+static zmsg_t* s_recv_command(zactor_t* actor, const char* command, int timeout_ms)
+{
+    zpoller_t* poller   = zpoller_new(actor, NULL);
+    int64_t    until_ms = zclock_mono() + timeout_ms;
+    zmsg_t*    found    = NULL;
+    while (!found && zclock_mono() < until_ms) {
+        if (!zpoller_wait(poller, int(until_ms - zclock_mono())))
+            break;
+        zmsg_t* msg   = zmsg_recv(actor);
+        char*   first = msg ? zmsg_popstr(msg) : NULL;
+        if (first && streq(first, command))
+            found = msg;
+        else
+            zmsg_destroy(&msg);
+        zstr_free(&first);
+    }
+    zpoller_destroy(&poller);
+    return found;
+}
+
+TEST_CASE("replica leader and standby")
+{
+    static const char* endpoint = "ipc://@/fty-outage-replica-unit";
+
+    // standby may start first
+    zactor_t* standby = zactor_new(outage_replica, NULL);
+    REQUIRE(standby);
+    zstr_sendx(standby, "STANDBY", endpoint, "200", NULL);
+
+    zactor_t* leader = zactor_new(outage_replica, NULL);
+    REQUIRE(leader);
+    zstr_sendx(leader, "LEADER", endpoint, "200", NULL);
+
+    // subscribed standby asks for the whole state
+    zmsg_t* msg = s_recv_command(leader, "SNAPSHOT", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    // leader syncs each lease / REPLICA_SYNCS_PER_LEASE
+    msg = s_recv_command(leader, "SYNC", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    // changes come to the standby in order
+    zstr_sendx(leader, "PUBLISH", "DELETE", "UPS1", NULL);
+    zstr_sendx(leader, "PUBLISH", "LEASE", NULL);
+    msg = s_recv_command(standby, "APPLY", 1000);
+    REQUIRE(msg);
+    char* kind  = zmsg_popstr(msg);
+    char* asset = zmsg_popstr(msg);
+    CHECK(streq(kind, "DELETE"));
+    CHECK(streq(asset, "UPS1"));
+    zstr_free(&kind);
+    zstr_free(&asset);
+    zmsg_destroy(&msg);
+
+    // standby is kept while the leader publishes, it takes over once the leader is gone
+    for (int i = 0; i < 5; i++) {
+        zstr_sendx(leader, "PUBLISH", "LEASE", NULL);
+        zclock_sleep(100);
+    }
+    msg = s_recv_command(standby, "TAKEOVER", 50);
+    CHECK(!msg);
+    zactor_destroy(&leader);
+    msg = s_recv_command(standby, "TAKEOVER", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    // the new leader binds the same endpoint
+    zstr_sendx(standby, "LEADER", endpoint, "200", NULL);
+    msg = s_recv_command(standby, "SYNC", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    zactor_destroy(&standby);
+}
+
+TEST_CASE("replica lease in simulated time")
+{
+    static const char* endpoint = "ipc://@/fty-outage-replica-clock";
+
+    vclock_t* clock = vclock_new();
+    vclock_simulate(clock, 1000000);
+
+    // standby started first waits REPLICA_STARTUP_LEASES for the leader
+    zactor_t* standby = zactor_new(outage_replica, clock);
+    REQUIRE(standby);
+    zstr_sendx(standby, "STANDBY", endpoint, "200", NULL);
+    vclock_advance(clock, 500);
+    zstr_send(standby, "TICK");
+    zmsg_t* msg = s_recv_command(standby, "TAKEOVER", 200);
+    CHECK(!msg);
+
+    zactor_t* leader = zactor_new(outage_replica, clock);
+    REQUIRE(leader);
+    zstr_sendx(leader, "LEADER", endpoint, "200", NULL);
+    msg = s_recv_command(leader, "SNAPSHOT", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+    zstr_sendx(leader, "PUBLISH", "LEASE", NULL);
+    msg = s_recv_command(standby, "APPLY", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    // the leader appeared in time, its lease counts from now on
+    vclock_advance(clock, 150);
+    zstr_send(standby, "TICK");
+    msg = s_recv_command(standby, "TAKEOVER", 200);
+    CHECK(!msg);
+    zactor_destroy(&leader);
+
+    // the lease runs out only when the clock moves
+    msg = s_recv_command(standby, "TAKEOVER", 200);
+    CHECK(!msg);
+    vclock_advance(clock, 49);
+    zstr_send(standby, "TICK");
+    msg = s_recv_command(standby, "TAKEOVER", 200);
+    CHECK(!msg);
+    vclock_advance(clock, 1);
+    zstr_send(standby, "TICK");
+    msg = s_recv_command(standby, "TAKEOVER", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    zactor_destroy(&standby);
+    vclock_destroy(&clock);
+}
+
+TEST_CASE("replica without leader")
+{
+    vclock_t* clock = vclock_new();
+    vclock_simulate(clock, 1000000);
+
+    // leader which never comes is taken over after REPLICA_STARTUP_LEASES
+    zactor_t* standby = zactor_new(outage_replica, clock);
+    REQUIRE(standby);
+    zstr_sendx(standby, "STANDBY", "ipc://@/fty-outage-replica-none", "200", NULL);
+    vclock_advance(clock, 200 * REPLICA_STARTUP_LEASES - 1);
+    zstr_send(standby, "TICK");
+    zmsg_t* msg = s_recv_command(standby, "TAKEOVER", 200);
+    CHECK(!msg);
+    vclock_advance(clock, 1);
+    zstr_send(standby, "TICK");
+    msg = s_recv_command(standby, "TAKEOVER", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    zactor_destroy(&standby);
+    vclock_destroy(&clock);
+}
+
+TEST_CASE("replica standby which doesn't read")
+{
+    static const char* endpoint = "ipc://@/fty-outage-replica-stuck";
+
+    zactor_t* leader = zactor_new(outage_replica, NULL);
+    REQUIRE(leader);
+    zstr_sendx(leader, "LEADER", endpoint, "200", NULL);
+    zsock_t* stuck = zsock_new(ZMQ_SUB);
+    REQUIRE(stuck);
+    zsock_set_rcvhwm(stuck, 1);
+    zsock_set_subscribe(stuck, "");
+    REQUIRE(zsock_connect(stuck, "%s", endpoint) == 0);
+    zmsg_t* msg = s_recv_command(leader, "SNAPSHOT", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    // the leader is never blocked by the full queue, the standby is sent the whole state again
+    for (int round = 0; round < 100 && !msg; round++) {
+        for (int i = 0; i < 10000; i++)
+            zstr_sendx(leader, "PUBLISH", "LEASE", NULL);
+        msg = s_recv_command(leader, "SNAPSHOT", 100);
+    }
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    // and keeps syncing
+    msg = s_recv_command(leader, "SYNC", 1000);
+    CHECK(msg);
+    zmsg_destroy(&msg);
+
+    zsock_destroy(&stuck);
+    zactor_destroy(&leader);
+}
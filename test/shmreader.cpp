@@ -0,0 +1,63 @@
+#include "src/shmreader.h"
+#include <catch2/catch.hpp>
+#include <fty_proto.h>
+#include <regex>
+#include <set>
+
+TEST_CASE("shmreader shards")
+{
+    // every asset name is in exactly one shard
+    const char* names[] = {"ups-10", "ups-11", "epdu-2", "sensor-33", "sts-4", "rackcontroller-0", "datacenter-15",
+        "room-6", "row-27", "rack-8", "ups-19", "fty-outage", "UPS33", "x"};
+    for (size_t shards = 1; shards <= SHMREADER_MAX_WORKERS; shards++) {
+        for (const char* name : names) {
+            size_t matches = 0;
+            for (size_t shard = 0; shard < shards; shard++) {
+                if (std::regex_match(name, std::regex(shmreader_shard_regex(shard, shards))))
+                    matches++;
+            }
+            CHECK(matches == 1);
+        }
+    }
+    CHECK(shmreader_shard_regex(0, 1) == ".*");
+}
+
+TEST_CASE("shmreader read")
+{
+    zsys_dir_create("shmreader-test");
+    REQUIRE(fty_shm_set_test_dir("shmreader-test") == 0);
+    std::set<std::string> written;
+    for (int i = 0; i < 24; i++) {
+        std::string asset = (i % 3 == 0 ? "epdu-" : "ups-") + std::to_string(i);
+        REQUIRE(fty::shm::write_metric(asset, "status.ups", "1", "", 600) == 0);
+        written.insert(asset);
+    }
+    // metrics of the agent itself are skipped
+    REQUIRE(fty::shm::write_metric("fty-outage", "outage.stats.touches", "1", "", 600) == 0);
+    REQUIRE(fty::shm::write_metric("ups-0", "outage.communicating", "1", "", 600) == 0);
+
+    for (size_t workers : {1, 3, 8}) {
+        shmreader_t* reader = shmreader_new(workers);
+        REQUIRE(reader);
+        CHECK(shmreader_shards(reader) == std::min(workers, size_t(SHMREADER_MAX_WORKERS)));
+
+        // the same assets are read by each poll, every one of them once
+        for (int poll = 0; poll < 2; poll++) {
+            shmreader_result_t result;
+            shmreader_read(reader, result);
+            CHECK(result.size() == shmreader_shards(reader));
+            CHECK(shmreader_result_size(result) == written.size());
+            std::set<std::string> read;
+            for (auto batch : result) {
+                for (auto& metric : *batch)
+                    read.insert(fty_proto_name(metric));
+            }
+            CHECK(read == written);
+            shmreader_result_clear(result);
+            CHECK(result.empty());
+        }
+        shmreader_destroy(&reader);
+        CHECK(reader == NULL);
+    }
+    fty_shm_delete_test_dir();
+}
@@ -0,0 +1,118 @@
+#include "src/wave.h"
+#include <catch2/catch.hpp>
+
+static const uint64_t START = 1600000000;
+
+// ups with ttl 60 s, seen at 'seen_sec', so it expires 120 s later
+static void s_add_asset(data_t* data, const std::string& name, const char* parent, uint64_t seen_sec)
+{
+    zhash_t* aux = zhash_new();
+    zhash_insert(aux, "type", const_cast<char*>("device"));
+    zhash_insert(aux, "subtype", const_cast<char*>("ups"));
+    if (parent)
+        zhash_insert(aux, ASSET_PARENT_NAME, const_cast<char*>(parent));
+    zmsg_t*      msg   = fty_proto_encode_asset(aux, name.c_str(), FTY_PROTO_ASSET_OP_CREATE, NULL);
+    fty_proto_t* proto = fty_proto_decode(&msg);
+    data_put(data, &proto);
+    zhash_destroy(&aux);
+    REQUIRE(data_touch_asset(data, name.c_str(), seen_sec, 60, seen_sec) == 0);
+}
+
+static data_t* s_data(void)
+{
+    data_t* data = data_new();
+    vclock_simulate(data->clock, int64_t(START) * 1000);
+    for (int i = 0; i < 6; i++)
+        s_add_asset(data, "epdu-" + std::to_string(i), "rack-1", START);
+    for (int i = 0; i < 40; i++)
+        s_add_asset(data, "ups-" + std::to_string(i), NULL, START + 100);
+    return data;
+}
+
+TEST_CASE("wave of children")
+{
+    data_t* data = s_data();
+    wave_t* wave = wave_new();
+    REQUIRE(wave);
+
+    std::vector<std::string> expired;
+    for (int i = 0; i < 6; i++)
+        expired.push_back("epdu-" + std::to_string(i));
+    auto started = wave_detect(wave, data, expired, true, START + 130);
+    REQUIRE(started.size() == 1);
+    CHECK(started[0].cause == WAVE_PARENT);
+    CHECK(started[0].origin == "rack-1");
+    CHECK(started[0].assets == 6);
+    CHECK(started[0].monitored == 6);
+    CHECK(wave_held(wave, "epdu-3"));
+    CHECK(!wave_held(wave, "ups-3"));
+
+    // held until confirmed, even across a step of the wall clock, the assets still dead then are released
+    data_shift_time(data, 3600);
+    wave_shift_time(wave, 3600);
+    CHECK(wave_settle(wave, data, START + 3600 + 200).empty());
+    CHECK(wave_settle(wave, data, START + 3600 + 129 + DEFAULT_WAVE_HOLD_SEC).empty());
+    auto ended = wave_settle(wave, data, START + 3600 + 130 + DEFAULT_WAVE_HOLD_SEC);
+    REQUIRE(ended.size() == 1);
+    CHECK(ended[0].started_sec == START + 3600 + 130);
+    CHECK(ended[0].dead == 6);
+    CHECK(!wave_held(wave, "epdu-3"));
+    CHECK(wave->waves.empty());
+    data_shift_time(data, -3600);
+
+    // some children still communicate
+    REQUIRE(data_touch_asset(data, "epdu-5", START + 500, 60, START + 500) == 0);
+    expired.pop_back();
+    CHECK(wave_detect(wave, data, expired, true, START + 510).empty());
+    CHECK(!wave_held(wave, "epdu-3"));
+
+    wave_destroy(&wave);
+    CHECK(wave == NULL);
+    data_destroy(&data);
+}
+
+TEST_CASE("wave of many assets")
+{
+    data_t* data = s_data();
+    wave_t* wave = wave_new();
+
+    // few assets are not a wave
+    std::vector<std::string> expired;
+    for (int i = 0; i < 10; i++)
+        expired.push_back("ups-" + std::to_string(i));
+    CHECK(wave_detect(wave, data, expired, true, START + 230).empty());
+
+    // no metric came, the source is down
+    for (int i = 10; i < 30; i++)
+        expired.push_back("ups-" + std::to_string(i));
+    auto started = wave_detect(wave, data, expired, false, START + 230);
+    REQUIRE(started.size() == 1);
+    CHECK(started[0].cause == WAVE_SOURCE);
+    CHECK(started[0].origin.empty());
+    CHECK(started[0].assets == 30);
+    CHECK(started[0].monitored == 46);
+
+    // assets expiring later join the wave
+    CHECK(wave_detect(wave, data, {"ups-30"}, false, START + 260).empty());
+    CHECK(wave_held(wave, "ups-30"));
+    CHECK(wave->waves[0].assets == 31);
+
+    // all of them came back before the wave was confirmed
+    for (int i = 0; i < 31; i++)
+        REQUIRE(data_touch_asset(data, ("ups-" + std::to_string(i)).c_str(), START + 280, 60, START + 280) == 0);
+    auto ended = wave_settle(wave, data, START + 290);
+    REQUIRE(ended.size() == 1);
+    CHECK(ended[0].dead == 0);
+    CHECK(zhashx_size(wave->held) == 0);
+
+    // metrics of other assets still come, network is down; disabled detection finds nothing
+    started = wave_detect(wave, data, expired, true, START + 500);
+    REQUIRE(started.size() == 1);
+    CHECK(started[0].cause == WAVE_NETWORK);
+    wave_configure(wave, 0, 10, 5, 300);
+    CHECK(wave_detect(wave, data, {"ups-35"}, true, START + 500).empty());
+    CHECK(!wave_held(wave, "ups-35"));
+
+    wave_destroy(&wave);
+    data_destroy(&data);
+}